@@ -15,8 +15,33 @@ import torch.nn.functional as F
 from wjwgym.agents import DDPGBase
 from wjwgym.models import SimpleCriticNet
 import os
+import struct
 CUDA = torch.cuda.is_available()
 
+# 策略文件的格式，与env-interface/model/openenv_policy.h中的OpenEnvMlpPolicy一致
+POLICY_MAGIC = 0x504d454f  # "OEMP"
+POLICY_VERSION = 1
+POLICY_ACTIVATIONS = {'linear': 0, 'relu': 1, 'softmax': 2, 'tanh': 3}
+
+
+def write_policy(path, layers, scale=1.0):
+    """把MLP写为ns-3可以直接加载的策略文件
+
+    @param path: 输出文件
+    @param layers: [(weight, bias, activation)]，weight形状为[输出, 输入]（与nn.Linear相同），
+                   activation为POLICY_ACTIVATIONS中的名字
+    @param scale: 输出倍率
+    """
+    with open(path, 'wb') as f:
+        f.write(struct.pack('<IIIf', POLICY_MAGIC, POLICY_VERSION, len(layers), float(scale)))
+        for weight, bias, activation in layers:
+            weight = np.ascontiguousarray(weight, dtype='<f4')
+            bias = np.ascontiguousarray(bias, dtype='<f4')
+            n_out, n_in = weight.shape
+            f.write(struct.pack('<III', n_in, n_out, POLICY_ACTIVATIONS[activation]))
+            f.write(weight.tobytes())
+            f.write(bias.tobytes())
+
 
 class OUProcess(object):
     """Ornstein-Uhlenbeck process"""
@@ -83,6 +108,10 @@ class DDPG(DDPGBase):
         }
         torch.save(state, './drlte.pth')
 
+    def export_actor(self, path='./drlte.policy'):
+        """导出actor_eval，供ns-3中的OpenEnvInterface::PolicyFile直接执行"""
+        self.actor_eval.export(path)
+
     # TODO 将方法固定到基类
     def load(self):
         print('\033[1;31;40m{}\033[0m'.format('加载模型参数...'))
@@ -135,3 +164,10 @@ class ActorNetwork(nn.Module):
         action_value = F.softmax(x, dim=1)
         action_value = action_value * self.bound
         return action_value
+
+    def export(self, path):
+        """按forward的结构写出策略文件，bound作为输出倍率"""
+        layers = []
+        for layer, activation in ((self.fc1, 'relu'), (self.fc2, 'relu'), (self.out, 'softmax')):
+            layers.append((layer.weight.detach().cpu().numpy(), layer.bias.detach().cpu().numpy(), activation))
+        write_policy(path, layers, self.bound.item())
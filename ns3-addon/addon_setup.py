@@ -94,6 +94,7 @@ def wscript_append(waf_script: str, module_path: str):
     """
     replace_str = ''
     ws_lines = waf_script.split('\n')
+    module_name = dir_dict[module_path.parts[-1]]
 
     # 获取所有additioal文件
     additional_path = module_path / 'additional.json'
@@ -101,9 +102,16 @@ def wscript_append(waf_script: str, module_path: str):
         add_files = json.load(f)
 
     # 对于不同的新增列表，其对应key是要被添加的目标list
-    for target_list in add_files:
+    for add_key in add_files:
+        # key中的'-'不能出现在python变量名中，如metric-extractor_test.source对应metric_extractor_test.source
+        target_list = add_key.replace('-', '_')
+        var_name = target_list.split('.')[0]
+        # 原module没有测试库（如flow-monitor）时先创建
+        test_lib = f'    {var_name} = bld.create_ns3_module_test_library'
+        if var_name.endswith('_test') and f'{var_name} =' not in waf_script and test_lib not in replace_str:
+            replace_str += f'''{test_lib}('{module_name}')\n'''
         # 对于这个list，遍历新增头文件，并创建相应的append语句
-        for add_file in add_files[target_list]:
+        for add_file in add_files[add_key]:
             has_this_file = False
             # 检查这一行在wscript中是否已经存在
             for ws_line in ws_lines:
@@ -43,7 +43,7 @@ GetAvgDelay (Ptr<FlowMonitor> fptr)
 {
 
   FlowMonitor::FlowStatsContainer flowStatsContainer = fptr->GetFlowStats ();
-  std::map<FlowId, FlowMonitor::FlowStats>::iterator it;
+  FlowMonitor::FlowStatsContainerI it;
   int64_t t = 0;
   uint32_t pnum = 0;
   for (it = flowStatsContainer.begin (); it != flowStatsContainer.end (); it++)
@@ -66,7 +66,7 @@ GetForwardMatrix (Ptr<FlowMonitor> fptr, uint32_t nodeNum)
   FlowMonitor::FlowProbeContainer flowProbeContainer = fptr->GetAllProbes ();
   for (uint32_t index = 0; index < flowProbeContainer.size (); index++)
     {
-      FlowProbe::RLStats rlstats = flowProbeContainer[index]->GetRLStats ();
+      const FlowProbe::RLStats &rlstats = flowProbeContainer[index]->GetRLStats ();
       for (auto sit = rlstats.begin (); sit != rlstats.end (); sit++)
         {
           NS_LOG_DEBUG ("FlowId: " << sit->first.flowId << "; NodeId: " << sit->first.nodeId
@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * 大拓扑下RLFlowProbe安装耗时的基准测试
+ * 拓扑为一个环，再加上随机的弦，保证每个节点至少有两个device
+ * 运行: ./waf --run "rl_probe_bench --nodeNum=1000 --chordNum=1000"
+ */
+
+#include <chrono>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/flow-monitor-helper.h"
+
+using namespace ns3;
+NS_LOG_COMPONENT_DEFINE ("RLProbeBench");
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nodeNum = 1000;
+  uint32_t chordNum = 1000;
+  uint32_t simSeed = 1;
+  uint32_t probeMode = RLFlowProbe::PROBE_FULL;
+
+  CommandLine cmd;
+  cmd.AddValue ("nodeNum", "节点数目", nodeNum);
+  cmd.AddValue ("chordNum", "环之外额外随机添加的链路数目", chordNum);
+  cmd.AddValue ("simSeed", "随机种子", simSeed);
+  cmd.AddValue ("probeMode", "probe安装模式，0: full, 1: end-to-end, 2: links", probeMode);
+  cmd.Parse (argc, argv);
+  RngSeedManager::SetSeed (simSeed);
+
+  NodeContainer nodes;
+  nodes.Create (nodeNum);
+  InternetStackHelper stack;
+  stack.Install (nodes);
+
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("5Mbps"));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue ("2ms"));
+  Ipv4AddressHelper address;
+  address.SetBase ("10.0.0.0", "255.255.255.252");
+
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  uint32_t linkNum = 0;
+  for (uint32_t index = 0; index < nodeNum + chordNum; index++)
+    {
+      uint32_t src = index % nodeNum;
+      uint32_t dst = (src + 1) % nodeNum;
+      if (index >= nodeNum)
+        {
+          src = rand->GetInteger (0, nodeNum - 1);
+          dst = rand->GetInteger (0, nodeNum - 1);
+          if (src == dst)
+            {
+              continue;
+            }
+        }
+      NetDeviceContainer devices = pointToPoint.Install (nodes.Get (src), nodes.Get (dst));
+      address.Assign (devices);
+      address.NewNetwork ();
+      linkNum++;
+    }
+
+  // 只统计probe安装本身的耗时
+  FlowMonitorHelper flowHelper;
+  flowHelper.SetProbeMode (static_cast<RLFlowProbe::ProbeMode> (probeMode));
+  auto start = std::chrono::steady_clock::now ();
+  Ptr<FlowMonitor> flowMonitor = flowHelper.RLInstall (nodes);
+  auto end = std::chrono::steady_clock::now ();
+  double seconds = std::chrono::duration<double> (end - start).count ();
+
+  NS_LOG_UNCOND ("nodes: " << nodeNum << ", links: " << linkNum
+                           << ", probes: " << flowMonitor->GetAllProbes ().size ());
+  NS_LOG_UNCOND ("RLInstall time: " << seconds << " s ("
+                                    << seconds * 1e6 / nodeNum << " us/node)");
+
+  Simulator::Destroy ();
+  return 0;
+}
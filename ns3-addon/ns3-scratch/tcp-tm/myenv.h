@@ -32,15 +32,13 @@
 #include "ns3/network-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/flow-monitor-helper.h"
+#include "ns3/rl-observation-builder.h"
 
 namespace ns3 {
 
 class MyOpenEnv : public OpenEnvAbstract
 {
 public:
-  typedef std::pair<uint32_t, uint32_t> NodePair; //!< 两个node（由index确定）可以确定一条有向边
-  typedef std::vector<NodePair> FlowVec; //!< 记录FlowId和对应的node的关系的Vector
-
   MyOpenEnv ();
   MyOpenEnv (Time stepTime, NodeContainer nodes, uint32_t edgeNum, uint32_t maxStep);
   virtual ~MyOpenEnv ();
@@ -57,8 +55,6 @@ public:
 
   void SetAdjacencyVec (std::vector<int> adjacencyVec);
   void SetFlowMonitor (Ptr<FlowMonitor> flowMonitor);
-  void SetFlowClassifier (Ptr<Ipv4FlowClassifier> Classifier);
-  void SetFlowVec (FlowVec flowVec);
 
 private:
   void ScheduleNextStateRead ();
@@ -68,8 +64,13 @@ private:
   uint32_t m_maxStep;
   std::vector<int> m_adjacencyVec;
   Ptr<FlowMonitor> m_flowMonitor;
-  Ptr<Ipv4FlowClassifier> m_flowClassifier;
-  FlowVec m_flowVec;
+  RLObservationBuilder m_obsBuilder;
+  Ptr<OpenEnvBoxContainer<uint32_t>> m_obsBox;
+
+  // 同一进程中可以有多个环境实例，逐step的状态不能放在静态变量里
+  uint32_t m_stepCounter; //!< 已经经过的step数
+  int64_t m_cumNanoDelay; //!< 上一个step为止累计的时延
+  uint32_t m_cumPackets; //!< 上一个step为止累计收到的包数
 
   bool m_needGameOver;
   Time m_interval;
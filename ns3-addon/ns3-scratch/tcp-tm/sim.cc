@@ -127,9 +127,9 @@ main (int argc, char *argv[])
   // 配置流分析器
   Ptr<FlowMonitor> flowMonitor;
   FlowMonitorHelper flowHelper;
+  // TM观测和时延奖励只需要端到端统计，中转节点上不挂每跳的hook
+  flowHelper.SetProbeMode (RLFlowProbe::PROBE_END_TO_END);
   flowMonitor = flowHelper.RLInstallAll ();
-  Ptr<Ipv4FlowClassifier> flowClassifier =
-      DynamicCast<Ipv4FlowClassifier> (flowHelper.GetClassifier ());
 
   // 根据业务TM配置应用层
   root.Parse (trafficMatrixStr.c_str ());
@@ -151,11 +151,11 @@ main (int argc, char *argv[])
 
   // OpenEnv Env
   Ptr<OpenEnvInterface> openEnvInterface = CreateObject<OpenEnvInterface> (openEnvPort);
+  // 启用剖析（--OpenEnvInterface::EnableProfiler=true）时按step统计路由计算耗时
+  openEnvInterface->SetGetRouteTimeCb (MakeCallback (&Ipv4RLRoutingHelper::GetTotalComputeTime));
   Ptr<MyOpenEnv> myOpenEnv = CreateObject<MyOpenEnv> (Seconds (envStepTime), nodes, edgeNum, maxStep);
   myOpenEnv->SetFlowMonitor (flowMonitor);
-  myOpenEnv->SetFlowClassifier (flowClassifier);
   myOpenEnv->SetAdjacencyVec(adjacencyVec);
-  myOpenEnv->SetFlowVec (myNetwork->GetFlowVec ());
   myOpenEnv->SetOpenEnvInterface (openEnvInterface);
 
   // 从client启动开始计时
@@ -19,6 +19,7 @@
  */
 
 #include "myenv.h"
+#include "ns3/rl-route-manager-impl.h"
 #include "ns3/object.h"
 #include "ns3/core-module.h"
 #include "ns3/wifi-module.h"
@@ -26,6 +27,7 @@
 #include "ns3/log.h"
 #include <sstream>
 #include <iostream>
+#include <cmath>
 
 namespace ns3 {
 
@@ -34,30 +36,40 @@ NS_LOG_COMPONENT_DEFINE ("MyOpenEnv");
 NS_OBJECT_ENSURE_REGISTERED (MyOpenEnv);
 
 MyOpenEnv::MyOpenEnv ()
+  : m_routeManager (0)
 {
   NS_LOG_FUNCTION (this);
   m_interval = Seconds (0.1);
   m_needGameOver = true;
-  Simulator::Schedule (Seconds (0.0), &MyOpenEnv::ScheduleNextStateRead, this);
+  m_stepCounter = 0;
+  m_cumNanoDelay = 0;
+  m_cumPackets = 0;
+  m_firstStep = Seconds (0.0);
+  m_stepEvent = Simulator::Schedule (m_firstStep, &MyOpenEnv::ScheduleNextStateRead, this);
 }
 
 MyOpenEnv::MyOpenEnv (Time stepTime, NodeContainer nodes, uint32_t edgeNum, uint32_t maxStep)
+  : m_routeManager (0)
 {
   NS_LOG_FUNCTION (this);
   m_interval = stepTime;
   m_needGameOver = true;
+  m_stepCounter = 0;
+  m_cumNanoDelay = 0;
+  m_cumPackets = 0;
   m_nodes = nodes;
   m_edgeNum = edgeNum;
   m_maxStep = maxStep;
 
-  Simulator::Schedule (Seconds (7.0), &MyOpenEnv::ScheduleNextStateRead, this);
+  m_firstStep = Seconds (7.0);
+  m_stepEvent = Simulator::Schedule (m_firstStep, &MyOpenEnv::ScheduleNextStateRead, this);
 }
 
 void
 MyOpenEnv::ScheduleNextStateRead ()
 {
   NS_LOG_FUNCTION (this);
-  Simulator::Schedule (m_interval, &MyOpenEnv::ScheduleNextStateRead, this);
+  m_stepEvent = Simulator::Schedule (m_interval, &MyOpenEnv::ScheduleNextStateRead, this);
   Notify ();
 }
 
@@ -72,7 +84,13 @@ MyOpenEnv::GetTypeId (void)
   static TypeId tid = TypeId ("MyOpenEnv")
                           .SetParent<OpenEnvAbstract> ()
                           .SetGroupName ("OpenEnv")
-                          .AddConstructor<MyOpenEnv> ();
+                          .AddConstructor<MyOpenEnv> ()
+                          .AddAttribute ("StatsFile",
+                                         "Binary file that receives the flow and link statistics of every step "
+                                         "(see pyns3/flow_stats_reader.py).  Empty disables the dump.",
+                                         StringValue (""),
+                                         MakeStringAccessor (&MyOpenEnv::m_statsFile),
+                                         MakeStringChecker ());
   return tid;
 }
 
@@ -80,6 +98,14 @@ void
 MyOpenEnv::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
+  m_obsBox = 0;
+  m_network = 0;
+  m_statsWriter.Close ();
+  if (m_routeManager != 0)
+    {
+      delete m_routeManager;
+      m_routeManager = 0;
+    }
 }
 
 void
@@ -91,7 +117,42 @@ MyOpenEnv::SetAdjacencyVec (std::vector<int> adjacencyVec)
 void
 MyOpenEnv::SetFlowMonitor (Ptr<FlowMonitor> flowMonitor)
 {
+  // 转发矩阵观测需要各链路的发送计数，时延奖励需要端到端flow统计
+  uint32_t required = RLFlowProbe::METRIC_QUEUE_STATS | RLFlowProbe::METRIC_FLOW_STATS;
+  NS_ABORT_MSG_IF ((flowMonitor->GetAvailableMetrics () & required) != required,
+                   "flow monitor probes do not provide the metrics this env needs");
   m_flowMonitor = flowMonitor;
+
+  // 观测box只创建一次，每个step由m_obsBuilder直接写入
+  uint32_t nodeNum = m_nodes.GetN ();
+  // 同一进程中有多个环境时本环境的节点不从0开始编号
+  m_obsBuilder.Setup (flowMonitor, RLObservationBuilder::LINK_TX_PACKETS, nodeNum, 1.0,
+                      m_nodes.Get (0)->GetId ());
+  std::vector<uint32_t> shape = {
+      nodeNum * nodeNum,
+  };
+  m_obsBox = CreateObject<OpenEnvBoxContainer<uint32_t>> (shape);
+  m_obsBox->Resize (m_obsBuilder.GetSize ());
+}
+
+void
+MyOpenEnv::SetLinkMonitor (Ptr<RLLinkMonitor> linkMonitor)
+{
+  m_linkMonitor = linkMonitor;
+}
+
+void
+MyOpenEnv::SetNetwork (Ptr<MyNetwork> network)
+{
+  m_network = network;
+}
+
+void
+MyOpenEnv::InitializeRouteDatabase (int *adjacencyArray)
+{
+  NS_ASSERT (m_routeManager == 0);
+  m_routeManager = new RLRouteManagerImpl ();
+  Ipv4RLRoutingHelper::InitializeRouteDatabase (m_routeManager, adjacencyArray, m_nodes);
 }
 
 void
@@ -154,9 +215,8 @@ bool
 MyOpenEnv::GetGameOver ()
 {
   bool isGameOver = false;
-  static float stepCounter = 0.0;
-  stepCounter += 1;
-  if (stepCounter == m_maxStep && m_needGameOver)
+  m_stepCounter += 1;
+  if (m_stepCounter == m_maxStep && m_needGameOver)
     {
       isGameOver = true;
     }
@@ -170,28 +230,28 @@ Collect observations
 Ptr<OpenEnvDataContainer>
 MyOpenEnv::GetObservation ()
 {
-  uint32_t nodeNum = m_nodes.GetN ();
-
-  // 创建一个记录上一次TM的static变量
-  static std::vector<uint32_t> cumFrowardMatrix = std::vector<uint32_t> (nodeNum * nodeNum, 0);
-  std::vector<uint32_t> sumFrowardMatrix = GetForwardMatrix();
   // 仅当需要看详细数据时打开
   // flowMonitor->SerializeToXmlFile ("myanal.xml", true, true);
-  // 创建box
-  std::vector<uint32_t> shape = {
-      nodeNum * nodeNum,
-  };
-  Ptr<OpenEnvBoxContainer<uint32_t>> box = CreateObject<OpenEnvBoxContainer<uint32_t>> (shape);
-
-  // 用cur-last得到最近一个仿真时段的TM
-  for (uint32_t index = 0; index < nodeNum * nodeNum; index++)
+  // 各链路（src -> dst）最近一个仿真时段发出的包数，由m_obsBuilder直接写入box
+  m_obsBuilder.Build (m_obsBox->GetRawData (), m_obsBox->GetSize ());
+  if (m_linkMonitor != 0)
+    {
+      // 每个step结束一次链路统计窗口，GetExtraInfo和其他读取者使用同一份结果
+      m_linkMonitor->Snapshot ();
+    }
+  if (!m_statsFile.empty ())
     {
-      box->AddValue (sumFrowardMatrix[index] - cumFrowardMatrix[index]);
+      if (!m_statsWriter.IsOpen ())
+        {
+          m_statsWriter.Open (m_statsFile);
+        }
+      m_statsWriter.WriteStep (m_stepCounter, m_flowMonitor);
+      // 仿真可能由StopSimulation直接exit结束，环境不会被析构；
+      // 每个step交给stdio，exit时会被写出
+      m_statsWriter.Flush ();
     }
-  // 结束之后cur -> last
-  cumFrowardMatrix.assign (sumFrowardMatrix.begin (), sumFrowardMatrix.end ());
-  NS_LOG_UNCOND ("MyGetObservation: " << box);
-  return box;
+  NS_LOG_UNCOND ("MyGetObservation: " << m_obsBox);
+  return m_obsBox;
 }
 
 /*
@@ -200,28 +260,24 @@ Define reward function
 float
 MyOpenEnv::GetReward ()
 {
-  static float reward;
-  static int64_t cumNanoDelay = 0; // 累计的时延
-  static uint32_t cumPackets = 0; // 累计包数目
-  FlowMonitor::FlowStatsContainer flowStatsContainer = m_flowMonitor->GetFlowStats ();
-  std::map<FlowId, FlowMonitor::FlowStats>::iterator it;
-  if (flowStatsContainer.size () == 0)
+  float reward;
+  if (m_flowMonitor->GetFlowStats ().size () == 0)
     {
       return 0.0f;
     }
-  // 遍历flowStats计算至今为止的时延和包数目
-  int64_t sumNanoDelay = 0;
-  uint32_t sumPackets = 0;
-  for (it = flowStatsContainer.begin (); it != flowStatsContainer.end (); it++)
+  int64_t sumNanoDelay;
+  uint32_t sumPackets;
+  SumFlowStats (sumNanoDelay, sumPackets);
+  if (sumPackets == m_cumPackets)
     {
-      sumNanoDelay += it->second.delaySum.GetNanoSeconds ();
-      NS_ASSERT (it->second.rxPackets > 0);
-      sumPackets += it->second.rxPackets;
+      // 这个step内没有收到包（如原地reset之后的第一个step），没有时延可算
+      m_cumNanoDelay = sumNanoDelay;
+      return 0.0f;
     }
   // 计算时延，之后 sum -> cum
-  float nanoAvgDelay = (sumNanoDelay - cumNanoDelay) / (sumPackets - cumPackets);
-  cumNanoDelay = sumNanoDelay;
-  cumPackets = sumPackets;
+  float nanoAvgDelay = static_cast<float> (sumNanoDelay - m_cumNanoDelay) / (sumPackets - m_cumPackets);
+  m_cumNanoDelay = sumNanoDelay;
+  m_cumPackets = sumPackets;
 
   // 计算奖励，返回
   reward = (-nanoAvgDelay) / 1000000; // 取负数，转换为毫秒单位
@@ -229,6 +285,22 @@ MyOpenEnv::GetReward ()
   return reward;
 }
 
+void
+MyOpenEnv::SumFlowStats (int64_t &sumNanoDelay, uint32_t &sumPackets) const
+{
+  // 遍历flowStats计算至今为止的时延和包数目，被淘汰的flow已经汇总到一起
+  const FlowMonitor::FlowStatsContainer &flowStatsContainer = m_flowMonitor->GetFlowStats ();
+  const FlowMonitor::FlowStats &evicted = m_flowMonitor->GetEvictedFlowStats ();
+  sumNanoDelay = evicted.delaySum.GetNanoSeconds ();
+  sumPackets = evicted.rxPackets;
+  for (FlowMonitor::FlowStatsContainerCI it = flowStatsContainer.begin (); it != flowStatsContainer.end (); it++)
+    {
+      sumNanoDelay += it->second.delaySum.GetNanoSeconds ();
+      NS_ASSERT (it->second.rxPackets > 0);
+      sumPackets += it->second.rxPackets;
+    }
+}
+
 /*
 Define extra info. Optional
 */
@@ -237,6 +309,25 @@ MyOpenEnv::GetExtraInfo ()
 {
   std::string myInfo = "testInfo";
   myInfo += "|123";
+  if (m_linkMonitor != 0)
+    {
+      // 附加上一个step内各链路（按邻接矩阵顺序）的利用率和平均队列长度，
+      // 统计窗口已在GetObservation中结束，这里只读取结果
+      std::ostringstream oss;
+      const std::vector<double> &utilization = m_linkMonitor->GetUtilization ();
+      const std::vector<double> &queueLength = m_linkMonitor->GetAverageQueueLength ();
+      oss << "|util:";
+      for (uint32_t index = 0; index < utilization.size (); index++)
+        {
+          oss << (index ? "," : "") << utilization[index];
+        }
+      oss << "|queue:";
+      for (uint32_t index = 0; index < queueLength.size (); index++)
+        {
+          oss << (index ? "," : "") << queueLength[index];
+        }
+      myInfo += oss.str ();
+    }
   NS_LOG_UNCOND ("MyGetExtraInfo: " << myInfo);
   return myInfo;
 }
@@ -278,64 +369,53 @@ MyOpenEnv::ExecuteActions (Ptr<OpenEnvDataContainer> action)
       }
 
   // 设置距离矩阵并重新计算路由
-  Ipv4RLRoutingHelper::ComputeRoutingTables (weightArray);
+  if (m_routeManager != 0)
+    {
+      Ipv4RLRoutingHelper::ComputeRoutingTables (m_routeManager, weightArray);
+    }
+  else
+    {
+      Ipv4RLRoutingHelper::ComputeRoutingTables (weightArray);
+    }
   return true;
 }
 
-std::vector<uint32_t>
-MyOpenEnv::GetForwardMatrix ()
+/*
+Reset the scenario in place for a new episode
+*/
+bool
+MyOpenEnv::Reset ()
 {
-  uint32_t nodeNum = m_nodes.GetN ();
+  NS_LOG_FUNCTION (this);
+  // 取消下一个step，与新建环境时一样在m_firstStep之后开始第一个step
+  Simulator::Cancel (m_stepEvent);
+  m_stepEvent = Simulator::Schedule (m_firstStep, &MyOpenEnv::ScheduleNextStateRead, this);
+  m_stepCounter = 0;
 
-  // 将FlowMonitor中的记录整理到forwardVec中
-  std::vector<uint32_t> forwardVec = std::vector<uint32_t> (nodeNum * nodeNum, 0);
-  FlowMonitor::FlowProbeContainer flowProbeContainer = m_flowMonitor->GetAllProbes ();
-  for (uint32_t index = 0; index < flowProbeContainer.size (); index++)
+  // FlowMonitor的累计统计不清空，把当前的累计值作为新episode的基准
+  if (m_flowMonitor != 0)
     {
-      FlowProbe::RLStats rlstats = flowProbeContainer[index]->GetRLStats ();
-      for (auto sit = rlstats.begin (); sit != rlstats.end (); sit++)
-        {
-          NS_LOG_DEBUG ("FlowId: " << sit->first.flowId << "; NodeId: " << sit->first.nodeId
-                                   << "; IfId: " << sit->first.interface << ". -> packtes: "
-                                   << sit->second.packets);
-          // ! 注意RLStats中的NodeId确实是ID而不是Index
-          // Id是全局唯一的NodeList的index，同时，如果使用NodeContainer::GetGlobal ()
-          // 取得的container实际上和NodeList是等价的，顺序也是一致的。
-          // 即： 只要没有创建冗余的Node，这里的Id和nodes的Index是等价的
-          uint32_t src = sit->first.nodeId;
-          uint32_t interface = sit->first.interface;
-          // 通过src 和 interface 可以获取另一段的Node
-          Ptr<NetDevice> device = 0;
-          for (uint32_t dindex = 0; dindex < m_nodes.Get (src)->GetNDevices (); dindex++)
-            {
-              device = m_nodes.Get (src)->GetDevice (dindex);
-              if (device->GetIfIndex () == interface)
-                {
-                  break;
-                }
-              device = 0;
-            }
-          if (device == 0)
-            {
-              NS_LOG_UNCOND ("未找到device");
-            }
-          // 获取与其相连的channel，查找对端
-          Ptr<Channel> channel = device->GetChannel ();
-          if (channel == 0)
-            {
-              NS_LOG_UNCOND ("未找到channel");
-            }
-          // 因为是point-to-point信道，所以一定是两个device，一个是自己，另一个就是对端
-          uint32_t remoteIndex = channel->GetDevice (0) == device ? 1 : 0;
-          // 此时device已经没用了，可以用来记录对端device
-          device = channel->GetDevice (remoteIndex);
-          // 通过device查找对端Node
-          uint32_t dst = device->GetNode ()->GetId ();
-          forwardVec[src * nodeNum + dst] += sit->second.packets;
-        }
+      SumFlowStats (m_cumNanoDelay, m_cumPackets);
+      m_obsBuilder.Rebase ();
     }
-  // 返回FM
-  return forwardVec;
+  if (m_linkMonitor != 0)
+    {
+      // 丢弃当前的统计窗口
+      m_linkMonitor->Snapshot ();
+    }
+
+  // 与新建环境时一样，收到第一个动作之前没有RL路由
+  if (m_routeManager != 0)
+    {
+      m_routeManager->DeleteRoutes ();
+    }
+
+  if (m_network != 0)
+    {
+      m_network->RestartApplications ();
+    }
+  NS_LOG_UNCOND ("MyReset at " << Simulator::Now ().GetSeconds () << "s");
+  return true;
 }
 
 } // namespace ns3
\ No newline at end of file
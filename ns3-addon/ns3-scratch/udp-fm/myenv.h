@@ -32,9 +32,15 @@
 #include "ns3/network-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/flow-monitor-helper.h"
+#include "ns3/rl-link-monitor.h"
+#include "ns3/rl-observation-builder.h"
+#include "ns3/flow-stats-writer.h"
+#include "mynetwork.h"
 
 namespace ns3 {
 
+class RLRouteManagerImpl;
+
 class MyOpenEnv : public OpenEnvAbstract
 {
 public:
@@ -54,15 +60,23 @@ public:
   float GetReward ();
   std::string GetExtraInfo ();
   bool ExecuteActions (Ptr<OpenEnvDataContainer> action);
-  std::vector<uint32_t> GetForwardMatrix ();
+  // 原地reset：重新开始step计数和统计基准，删除RL路由，重新安装应用
+  bool Reset ();
 
   void SetAdjacencyVec (std::vector<int> adjacencyVec);
   void SetFlowMonitor (Ptr<FlowMonitor> flowMonitor);
   void SetFlowClassifier (Ptr<Ipv4FlowClassifier> Classifier);
   void SetFlowVec (FlowVec flowVec);
+  void SetLinkMonitor (Ptr<RLLinkMonitor> linkMonitor);
+  // reset时用于重新安装应用
+  void SetNetwork (Ptr<MyNetwork> network);
+  // 为本环境的节点建立独立的RL路由数据库，同一进程中有多个环境时每个环境各自计算路由
+  void InitializeRouteDatabase (int *adjacencyArray);
 
 private:
   void ScheduleNextStateRead ();
+  // 至今为止所有flow（包括被淘汰的）的时延和与收到的包数
+  void SumFlowStats (int64_t &sumNanoDelay, uint32_t &sumPackets) const;
 
   NodeContainer m_nodes;
   uint32_t m_edgeNum;
@@ -71,9 +85,23 @@ private:
   Ptr<FlowMonitor> m_flowMonitor;
   Ptr<Ipv4FlowClassifier> m_flowClassifier;
   FlowVec m_flowVec;
+  Ptr<RLLinkMonitor> m_linkMonitor;
+  Ptr<MyNetwork> m_network;
+  RLRouteManagerImpl *m_routeManager; //!< 本环境的路由manager，为0时使用全局单例
+  RLObservationBuilder m_obsBuilder;
+  Ptr<OpenEnvBoxContainer<uint32_t>> m_obsBox;
+  std::string m_statsFile; //!< 逐step写入flow和链路统计的二进制文件，为空时不写
+  FlowStatsWriter m_statsWriter;
+
+  // 同一进程中可以有多个环境实例，逐step的状态不能放在静态变量里
+  uint32_t m_stepCounter; //!< 已经经过的step数
+  int64_t m_cumNanoDelay; //!< 上一个step为止累计的时延
+  uint32_t m_cumPackets; //!< 上一个step为止累计收到的包数
 
   bool m_needGameOver;
   Time m_interval;
+  Time m_firstStep; //!< 从episode开始到第一个step的时间
+  EventId m_stepEvent; //!< 下一个step
 };
 
 } // namespace ns3
@@ -8,7 +8,6 @@
 #include "mynetwork.h"
 #include "ns3/internet-module.h"
 #include "ns3/point-to-point-module.h"
-#include "ns3/applications-module.h"
 
 namespace ns3 {
 
@@ -17,6 +16,7 @@ NS_LOG_COMPONENT_DEFINE ("MyNetwork");
 MyNetwork::MyNetwork ()
 {
   m_applicationPort = 615;
+  m_ipBase = 0;
 }
 
 MyNetwork::MyNetwork (NodeContainer nodes, std ::string routingMethod, uint32_t simulationTime)
@@ -25,6 +25,7 @@ MyNetwork::MyNetwork (NodeContainer nodes, std ::string routingMethod, uint32_t
   m_routingMethod = routingMethod;
   m_simulationTime = simulationTime;
   m_applicationPort = 615;
+  m_ipBase = 0;
 }
 
 MyNetwork::~MyNetwork ()
@@ -32,6 +33,12 @@ MyNetwork::~MyNetwork ()
   NS_LOG_FUNCTION (this);
 }
 
+void
+MyNetwork::SetIpBase (uint32_t ipBase)
+{
+  m_ipBase = ipBase;
+}
+
 void
 MyNetwork::BuildTopology (std::vector<int> adjacencyVec)
 {
@@ -63,7 +70,7 @@ MyNetwork::BuildTopology (std::vector<int> adjacencyVec)
   pointToPoint.SetChannelAttribute ("Delay", StringValue ("2ms")); // 传输时延2ms
   Ipv4AddressHelper address;
 
-  uint32_t ipBase = 0;
+  uint32_t ipBase = m_ipBase;
   // 遍历节点对，创建信道
   for (uint32_t sindex = 0; sindex < nodeNum; sindex++)
     {
@@ -105,7 +112,37 @@ MyNetwork::BuildTopology (std::vector<int> adjacencyVec)
 void
 MyNetwork::AddApplication (uint32_t src, uint32_t dst, double rate)
 {
-  // 部分固定配置
+  Traffic traffic = {src, dst, rate};
+  m_trafficVec.push_back (traffic);
+  InstallApplication (traffic);
+  // 将这组Flow放进Vec中
+  m_flowVec.push_back (NodePair (src, dst));
+}
+
+void
+MyNetwork::RestartApplications ()
+{
+  // ns-3的应用启动之后不能重新开始，也不能从外部提前停止。UdpClient每次发送后都会检查MaxPackets，
+  // 把上限设为1，上一个episode的client最多再发一个包就停止；server保持到自己的停止时间
+  for (ApplicationContainer::Iterator iter = m_clientApps.Begin (); iter != m_clientApps.End (); iter++)
+    {
+      (*iter)->SetAttribute ("MaxPackets", UintegerValue (1));
+    }
+  m_clientApps = ApplicationContainer ();
+  // 新的应用使用新的端口，被FlowMonitor识别为新的flow
+  for (std::vector<Traffic>::const_iterator iter = m_trafficVec.begin (); iter != m_trafficVec.end (); iter++)
+    {
+      InstallApplication (*iter);
+    }
+}
+
+void
+MyNetwork::InstallApplication (const Traffic &traffic)
+{
+  uint32_t src = traffic.src;
+  uint32_t dst = traffic.dst;
+  double rate = traffic.rate;
+  // 部分固定配置，应用在安装之后才初始化，启动和停止时间都相对于安装的时刻
   NS_LOG_DEBUG ("src: " << src << ", dst: " << dst << ", rate: " << rate);
   Time serverStartTime = Seconds (1.0);
   Time clientStartTime = Seconds (2.0);
@@ -133,11 +170,10 @@ MyNetwork::AddApplication (uint32_t src, uint32_t dst, double rate)
   ApplicationContainer clientApps = udpClient.Install (m_nodes.Get (src));
   clientApps.Start (clientStartTime);
   clientApps.Stop (Seconds (m_simulationTime + 5.0));
+  m_clientApps.Add (clientApps);
 
-  // port自增
-  m_applicationPort += 1;
-  // 将这组Flow放进Vec中
-  m_flowVec.push_back (NodePair (src, dst));
+  // port自增，多次reset之后回绕，此时之前使用该端口的应用早已停止
+  m_applicationPort = m_applicationPort == 65535 ? 615 : m_applicationPort + 1;
 }
 
 MyNetwork::FlowVec
@@ -10,6 +10,7 @@
 
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
+#include "ns3/applications-module.h"
 
 namespace ns3 {
 class MyNetwork : public Object
@@ -25,11 +26,24 @@ public:
   MyNetwork (NodeContainer nodes, std ::string routingMethod, uint32_t simulationTime);
   virtual ~MyNetwork();
 
+  // 设置本拓扑第一条链路使用的子网序号，同一进程中有多个拓扑时各自使用不重叠的地址
+  void SetIpBase (uint32_t ipBase);
   void BuildTopology (std::vector<int> adjacencyVec);
   void AddApplication (uint32_t src, uint32_t dst, double rate);
+  // 原地reset：停止上一个episode的client，按相同的TM重新安装应用，启动时间相对于当前时刻
+  void RestartApplications ();
   FlowVec GetFlowVec();
 
 private:
+  // 一条业务：src、dst和速率（Mbps）
+  struct Traffic
+  {
+    uint32_t src;
+    uint32_t dst;
+    double rate;
+  };
+
+  void InstallApplication (const Traffic &traffic);
 
   ChannelMap m_channelMap;
   FlowVec m_flowVec;
@@ -38,6 +52,9 @@ private:
   std::string m_routingMethod;
   uint32_t m_simulationTime;
   uint32_t m_applicationPort;
+  uint32_t m_ipBase;
+  std::vector<Traffic> m_trafficVec;
+  ApplicationContainer m_clientApps; //!< 当前episode的client
 };
 } // namespace ns3
 #endif // MY_NETWORK_H
\ No newline at end of file
@@ -21,6 +21,7 @@
 
 #include <math.h>
 #include <algorithm>
+#include <sstream>
 #include "myenv.h"
 #include "mynetwork.h"
 #include "ns3/log.h"
@@ -38,6 +39,13 @@ using namespace ns3;
 using namespace rapidjson;
 NS_LOG_COMPONENT_DEFINE ("UdpTMSim");
 
+// 结束当前episode的仿真，Run返回后由OpenEnvInterface决定是否原地reset
+static void
+StopEpisode ()
+{
+  Simulator::Stop ();
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -52,6 +60,7 @@ main (int argc, char *argv[])
   // 仿真默认参数设置
   uint32_t openEnvPort = 5555; // 与zmpBridge交互使用的端口
   uint32_t simSeed = 1;
+  uint32_t numEnvs = 1; // 同一进程中并行的环境数，大于1时以[K × obs]/[K × act]批量交互
 
   // 仿真时长设置
   uint32_t maxStep = 10; // 最大仿真步数
@@ -61,12 +70,15 @@ main (int argc, char *argv[])
   std::string routingMethod = "rl"; // 指定使用的路由规则[rl, ospf]
   std::string adjacencyMatrixStr = "[0,1,1,1,1,0,1,1,1,1,0,1,1,1,1,0]"; // 邻接矩阵
   std::string trafficMatrixStr = "[{/src/:0,/rate/:4,/dst/:1}]"; // TM
+  std::string statsFile = ""; // 逐step导出flow和链路统计的文件
 
   CommandLine cmd;
   // required parameters for OpenEnv interface
   cmd.AddValue ("openEnvPort", "Port number for OpenEnv env. Default: 5555", openEnvPort);
   cmd.AddValue ("simSeed", "Seed for random generator. Default: 1", simSeed);
   cmd.AddValue ("maxStep", "Simulation max steps. Default: 10", maxStep);
+  cmd.AddValue ("numEnvs", "Number of independent environments served by one OpenEnv interface. Default: 1",
+                numEnvs);
   // optional parameters
   cmd.AddValue ("routingMethod", "Ipv4 Routing Method, rl or ospf. Default: rl", routingMethod);
   cmd.AddValue ("trafficMatrix",
@@ -77,6 +89,10 @@ main (int argc, char *argv[])
                 "Neighbor Matrix, json type, using -1 replace infinity. Defatult: "
                 "[0,1,1,1,1,0,1,1,1,1,0,1,1,1,1,0]",
                 adjacencyMatrixStr);
+  cmd.AddValue ("statsFile",
+                "Dump the flow and link stats of every step to this binary file, one file per env "
+                "(suffixed with the env index when numEnvs > 1). Default: no dump",
+                statsFile);
   cmd.Parse (argc, argv);
   // 为了确保传输json格式，需要进行一定的替换
   replace (trafficMatrixStr.begin (), trafficMatrixStr.end (), '/', '"');
@@ -93,6 +109,8 @@ main (int argc, char *argv[])
   NS_LOG_UNCOND ("--trafficMatrix: " << trafficMatrixStr);
   NS_LOG_UNCOND ("--adjacencyMatrix: " << adjacencyMatrixStr);
   NS_LOG_UNCOND ("--seed: " << simSeed);
+  NS_LOG_UNCOND ("--numEnvs: " << numEnvs);
+  NS_LOG_UNCOND ("--statsFile: " << statsFile);
 
   RngSeedManager::SetSeed (1);
   RngSeedManager::SetRun (simSeed);
@@ -114,56 +132,110 @@ main (int argc, char *argv[])
   int adjacencyArray[nodeNum * nodeNum];
   std::copy (adjacencyVec.begin (), adjacencyVec.end (), adjacencyArray);
 
-  // 根据节点数目创建节点备用
-  NodeContainer nodes;
-  nodes.Create (nodeNum);
-
-  // 使用上述信息创建网络构建类
-  Ptr<MyNetwork> myNetwork = CreateObject<MyNetwork> (nodes, routingMethod, simulationTime);
-
-  // 初始化拓扑结构
-  myNetwork->BuildTopology (adjacencyVec);
-
-  // 配置流分析器
-  Ptr<FlowMonitor> flowMonitor;
-  FlowMonitorHelper flowHelper;
-  flowMonitor = flowHelper.RLInstallAll ();
-  Ptr<Ipv4FlowClassifier> flowClassifier =
-      DynamicCast<Ipv4FlowClassifier> (flowHelper.GetClassifier ());
+  // OpenEnv Env
+  Ptr<OpenEnvInterface> openEnvInterface = CreateObject<OpenEnvInterface> (openEnvPort);
+  // 启用剖析（--OpenEnvInterface::EnableProfiler=true）时按step统计路由计算耗时
+  openEnvInterface->SetGetRouteTimeCb (MakeCallback (&Ipv4RLRoutingHelper::GetTotalComputeTime));
+  // 环境的step事件和回调不持有引用，环境对象需要一直保留到仿真结束
+  std::vector<Ptr<MyOpenEnv>> myOpenEnvs;
+  Ptr<OpenEnvVectorEnv> vectorEnv;
+  if (numEnvs > 1)
+    {
+      vectorEnv = CreateObject<OpenEnvVectorEnv> ();
+    }
 
-  // 根据业务TM配置应用层
-  root.Parse (trafficMatrixStr.c_str ());
-  for (auto &item : root.GetArray ())
+  // 每个环境有自己的节点、路由manager、FlowMonitor和链路统计，拓扑之间互不相连
+  for (uint32_t envIndex = 0; envIndex < numEnvs; envIndex++)
     {
-      auto traffic = item.GetObject ();
-      myNetwork->AddApplication (traffic["src"].GetInt (), traffic["dst"].GetInt (),
-                                 traffic["rate"].GetDouble ());
+      // 根据节点数目创建节点备用
+      NodeContainer nodes;
+      nodes.Create (nodeNum);
+
+      // 使用上述信息创建网络构建类
+      Ptr<MyNetwork> myNetwork = CreateObject<MyNetwork> (nodes, routingMethod, simulationTime);
+
+      // 初始化拓扑结构，每个环境的链路使用不同的子网
+      myNetwork->SetIpBase (envIndex * edgeNum);
+      myNetwork->BuildTopology (adjacencyVec);
+
+      // 配置流分析器，只统计本环境的节点
+      Ptr<FlowMonitor> flowMonitor;
+      FlowMonitorHelper flowHelper;
+      flowMonitor = flowHelper.RLInstall (nodes);
+      Ptr<Ipv4FlowClassifier> flowClassifier =
+          DynamicCast<Ipv4FlowClassifier> (flowHelper.GetClassifier ());
+
+      // 根据业务TM配置应用层
+      root.Parse (trafficMatrixStr.c_str ());
+      for (auto &item : root.GetArray ())
+        {
+          auto traffic = item.GetObject ();
+          myNetwork->AddApplication (traffic["src"].GetInt (), traffic["dst"].GetInt (),
+                                     traffic["rate"].GetDouble ());
+        }
+
+      // 按邻接矩阵顺序统计各链路的利用率和队列长度
+      Ptr<RLLinkMonitor> linkMonitor = CreateObject<RLLinkMonitor> ();
+      linkMonitor->Install (nodes, adjacencyVec);
+
+      Ptr<MyOpenEnv> myOpenEnv = CreateObject<MyOpenEnv> (Seconds (envStepTime), nodes, edgeNum, maxStep);
+      if (routingMethod == "rl")
+        {
+          myOpenEnv->InitializeRouteDatabase (adjacencyArray);
+        }
+      myOpenEnv->SetFlowMonitor (flowMonitor);
+      myOpenEnv->SetFlowClassifier (flowClassifier);
+      myOpenEnv->SetAdjacencyVec(adjacencyVec);
+      myOpenEnv->SetFlowVec (myNetwork->GetFlowVec ());
+      myOpenEnv->SetLinkMonitor (linkMonitor);
+      myOpenEnv->SetNetwork (myNetwork);
+      if (!statsFile.empty ())
+        {
+          std::ostringstream envStatsFile;
+          envStatsFile << statsFile;
+          if (numEnvs > 1)
+            {
+              envStatsFile << "." << envIndex;
+            }
+          myOpenEnv->SetAttribute ("StatsFile", StringValue (envStatsFile.str ()));
+        }
+      myOpenEnvs.push_back (myOpenEnv);
+      if (vectorEnv)
+        {
+          vectorEnv->AddEnv (myOpenEnv);
+        }
+      else
+        {
+          myOpenEnv->SetOpenEnvInterface (openEnvInterface);
+        }
     }
 
-  if (routingMethod == "rl")
+  if (vectorEnv)
     {
-      Ipv4RLRoutingHelper::InitializeRouteDatabase (adjacencyArray, nodes);
+      vectorEnv->SetOpenEnvInterface (openEnvInterface);
+      openEnvInterface->SetResetCb (MakeCallback (&OpenEnvAbstract::Reset, vectorEnv));
     }
   else
+    {
+      openEnvInterface->SetResetCb (MakeCallback (&OpenEnvAbstract::Reset, myOpenEnvs[0]));
+    }
+  if (routingMethod != "rl")
     {
       Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
     }
 
-  // OpenEnv Env
-  Ptr<OpenEnvInterface> openEnvInterface = CreateObject<OpenEnvInterface> (openEnvPort);
-  Ptr<MyOpenEnv> myOpenEnv = CreateObject<MyOpenEnv> (Seconds (envStepTime), nodes, edgeNum, maxStep);
-  myOpenEnv->SetFlowMonitor (flowMonitor);
-  myOpenEnv->SetFlowClassifier (flowClassifier);
-  myOpenEnv->SetAdjacencyVec(adjacencyVec);
-  myOpenEnv->SetFlowVec (myNetwork->GetFlowVec ());
-  myOpenEnv->SetOpenEnvInterface (openEnvInterface);
-
   // 从client启动开始计时
   NS_LOG_UNCOND ("Simulation start");
-  Simulator::Stop (Seconds (simulationTime + 2));
+  EventId stopEvent = Simulator::Schedule (Seconds (simulationTime + 2), &StopEpisode);
   Simulator::Run ();
 
+  // Python端请求原地reset时不重启进程，从当前时刻开始新的episode
+  while (openEnvInterface->NotifyEpisodeEnd ())
+    {
+      Simulator::Cancel (stopEvent);
+      stopEvent = Simulator::Schedule (Seconds (simulationTime + 2), &StopEpisode);
+      Simulator::Run ();
+    }
   NS_LOG_UNCOND ("Simulation stop");
-  openEnvInterface->NotifySimulationEnd ();
   Simulator::Destroy ();
 }
@@ -38,6 +38,9 @@ MyOpenEnv::MyOpenEnv ()
   NS_LOG_FUNCTION (this);
   m_interval = Seconds (0.1);
   m_needGameOver = true;
+  m_stepCounter = 0;
+  m_cumNanoDelay = 0;
+  m_cumPackets = 0;
   Simulator::Schedule (Seconds (0.0), &MyOpenEnv::ScheduleNextStateRead, this);
 }
 
@@ -46,6 +49,9 @@ MyOpenEnv::MyOpenEnv (Time stepTime, NodeContainer nodes, uint32_t edgeNum, uint
   NS_LOG_FUNCTION (this);
   m_interval = stepTime;
   m_needGameOver = true;
+  m_stepCounter = 0;
+  m_cumNanoDelay = 0;
+  m_cumPackets = 0;
   m_nodes = nodes;
   m_edgeNum = edgeNum;
   m_maxStep = maxStep;
@@ -80,6 +86,7 @@ void
 MyOpenEnv::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
+  m_obsBox = 0;
 }
 
 void
@@ -91,19 +98,20 @@ MyOpenEnv::SetAdjacencyVec (std::vector<int> adjacencyVec)
 void
 MyOpenEnv::SetFlowMonitor (Ptr<FlowMonitor> flowMonitor)
 {
+  // TM观测和时延奖励需要node对TM和端到端flow统计
+  uint32_t required = RLFlowProbe::METRIC_NODE_PAIR_TM | RLFlowProbe::METRIC_FLOW_STATS;
+  NS_ABORT_MSG_IF ((flowMonitor->GetAvailableMetrics () & required) != required,
+                   "flow monitor probes do not provide the metrics this env needs");
   m_flowMonitor = flowMonitor;
-}
-
-void
-MyOpenEnv::SetFlowClassifier (Ptr<Ipv4FlowClassifier> flowClassifier)
-{
-  m_flowClassifier = flowClassifier;
-}
 
-void
-MyOpenEnv::SetFlowVec (FlowVec flowVec)
-{
-  m_flowVec = flowVec;
+  // 观测box只创建一次，每个step由m_obsBuilder直接写入
+  uint32_t nodeNum = m_nodes.GetN ();
+  m_obsBuilder.Setup (flowMonitor, RLObservationBuilder::NODE_PAIR_PACKETS, nodeNum);
+  std::vector<uint32_t> shape = {
+      nodeNum * nodeNum,
+  };
+  m_obsBox = CreateObject<OpenEnvBoxContainer<uint32_t>> (shape);
+  m_obsBox->Resize (m_obsBuilder.GetSize ());
 }
 
 /*
@@ -154,9 +162,8 @@ bool
 MyOpenEnv::GetGameOver ()
 {
   bool isGameOver = false;
-  static float stepCounter = 0.0;
-  stepCounter += 1;
-  if (stepCounter == m_maxStep && m_needGameOver)
+  m_stepCounter += 1;
+  if (m_stepCounter == m_maxStep && m_needGameOver)
     {
       isGameOver = true;
     }
@@ -170,43 +177,12 @@ Collect observations
 Ptr<OpenEnvDataContainer>
 MyOpenEnv::GetObservation ()
 {
-  uint32_t nodeNum = m_nodes.GetN ();
-
-  // 创建一个记录上一次TM的static变量
-  static std::vector<uint32_t> lastTrafficMatrix = std::vector<uint32_t> (nodeNum * nodeNum, 0);
-  // 预创建变量
-  std::vector<uint32_t> currentTrafficMatrix = std::vector<uint32_t> (nodeNum * nodeNum, 0);
-
-  FlowMonitor::FlowStatsContainer flowStatsContainer = m_flowMonitor->GetFlowStats ();
-  // 遍历FlowStats，记录currentTM
-  for (auto it = flowStatsContainer.begin (); it != flowStatsContainer.end (); it++)
-    {
-      uint32_t dstPort = m_flowClassifier->FindFlow (it->first).destinationPort;
-      // 注意我们的定义里，flow是节点而不是ip对。对此我们取巧使用递增的dstPort作为标记
-      NodePair flow = m_flowVec[dstPort - 615];
-      currentTrafficMatrix[flow.first * nodeNum + flow.second] +=
-          (it->second.rxPackets + it->second.txPackets);
-      NS_ASSERT ((it->second.rxPackets + it->second.txPackets) > 0);
-      NS_LOG_DEBUG ("flow " << it->first << "(" << flow.first << "->" << flow.second
-                            << "), rxPackets: " << (it->second.rxPackets + it->second.txPackets));
-    }
   // 仅当需要看详细数据时打开
   // flowMonitor->SerializeToXmlFile ("myanal.xml", true, true);
-  // 创建box
-  std::vector<uint32_t> shape = {
-      nodeNum * nodeNum,
-  };
-  Ptr<OpenEnvBoxContainer<uint32_t>> box = CreateObject<OpenEnvBoxContainer<uint32_t>> (shape);
-
-  // 用cur-last得到最近一个仿真时段的TM
-  for (uint32_t index = 0; index < nodeNum * nodeNum; index++)
-    {
-      box->AddValue (currentTrafficMatrix[index] - lastTrafficMatrix[index]);
-    }
-  // 结束之后cur -> last
-  lastTrafficMatrix.assign (currentTrafficMatrix.begin (), currentTrafficMatrix.end ());
-  NS_LOG_UNCOND ("MyGetObservation: " << box);
-  return box;
+  // FlowMonitor按node对直接统计的TM，取最近一个仿真时段的增量写入box
+  m_obsBuilder.Build (m_obsBox->GetRawData (), m_obsBox->GetSize ());
+  NS_LOG_UNCOND ("MyGetObservation: " << m_obsBox);
+  return m_obsBox;
 }
 
 /*
@@ -215,18 +191,17 @@ Define reward function
 float
 MyOpenEnv::GetReward ()
 {
-  static float reward;
-  static int64_t cumNanoDelay = 0; // 累计的时延
-  static uint32_t cumPackets = 0; // 累计包数目
-  FlowMonitor::FlowStatsContainer flowStatsContainer = m_flowMonitor->GetFlowStats ();
-  std::map<FlowId, FlowMonitor::FlowStats>::iterator it;
+  float reward;
+  const FlowMonitor::FlowStatsContainer &flowStatsContainer = m_flowMonitor->GetFlowStats ();
+  FlowMonitor::FlowStatsContainerCI it;
   if (flowStatsContainer.size () == 0)
     {
       return 0.0f;
     }
-  // 遍历flowStats计算至今为止的时延和包数目
-  int64_t sumNanoDelay = 0;
-  uint32_t sumPackets = 0;
+  // 遍历flowStats计算至今为止的时延和包数目，被淘汰的flow已经汇总到一起
+  const FlowMonitor::FlowStats &evicted = m_flowMonitor->GetEvictedFlowStats ();
+  int64_t sumNanoDelay = evicted.delaySum.GetNanoSeconds ();
+  uint32_t sumPackets = evicted.rxPackets;
   for (it = flowStatsContainer.begin (); it != flowStatsContainer.end (); it++)
     {
       sumNanoDelay += it->second.delaySum.GetNanoSeconds ();
@@ -234,9 +209,9 @@ MyOpenEnv::GetReward ()
       sumPackets += it->second.rxPackets;
     }
   // 计算时延，之后 sum -> cum
-  float nanoAvgDelay = (sumNanoDelay - cumNanoDelay) / (sumPackets - cumPackets);
-  cumNanoDelay = sumNanoDelay;
-  cumPackets = sumPackets;
+  float nanoAvgDelay = (sumNanoDelay - m_cumNanoDelay) / (sumPackets - m_cumPackets);
+  m_cumNanoDelay = sumNanoDelay;
+  m_cumPackets = sumPackets;
 
   // 计算奖励，返回
   reward = (-nanoAvgDelay) / 1000000; // 取负数，转换为毫秒单位
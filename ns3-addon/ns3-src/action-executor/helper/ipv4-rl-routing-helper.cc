@@ -5,8 +5,11 @@
  * @desc: 封装RL路由，对外提供初始化和计算路由表的功能
  */
 
+#include <chrono>
+
 #include "ipv4-rl-routing-helper.h"
 #include "ns3/rl-router-interface.h"
+#include "ns3/rl-route-manager-impl.h"
 #include "ns3/ipv4-rl-routing.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/log.h"
@@ -15,6 +18,10 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("RLRoutingHelper");
 
+// 路由计算的累计耗时（秒）和次数
+static double g_totalComputeTime = 0;
+static uint32_t g_computeCount = 0;
+
 Ipv4RLRoutingHelper::Ipv4RLRoutingHelper ()
 {
 }
@@ -54,9 +61,45 @@ Ipv4RLRoutingHelper::InitializeRouteDatabase(int * adjacencyArray, NodeContainer
 void 
 Ipv4RLRoutingHelper::ComputeRoutingTables (double *weightArray)
 {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
   RLRouteManager::DeleteRoutes();
   RLRouteManager::SetWeightMatrix (weightArray);
   RLRouteManager::CalculateRoutes ();
+  double elapsed = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  g_totalComputeTime += elapsed;
+  g_computeCount++;
+  NS_LOG_LOGIC ("route computation took " << elapsed * 1e6 << " us");
+}
+
+void
+Ipv4RLRoutingHelper::InitializeRouteDatabase (RLRouteManagerImpl *manager, int *adjacencyArray, NodeContainer nodes)
+{
+  manager->BuildRLRoutingDatabase (adjacencyArray, nodes);
+}
+
+void
+Ipv4RLRoutingHelper::ComputeRoutingTables (RLRouteManagerImpl *manager, double *weightArray)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  manager->DeleteRoutes ();
+  manager->SetWeightMatrix (weightArray);
+  manager->CalculateRoutes ();
+  double elapsed = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  g_totalComputeTime += elapsed;
+  g_computeCount++;
+  NS_LOG_LOGIC ("route computation took " << elapsed * 1e6 << " us");
+}
+
+double
+Ipv4RLRoutingHelper::GetTotalComputeTime (void)
+{
+  return g_totalComputeTime;
+}
+
+uint32_t
+Ipv4RLRoutingHelper::GetComputeCount (void)
+{
+  return g_computeCount;
 }
 
 } // namespace ns3
@@ -13,6 +13,8 @@
 
 namespace ns3 {
 
+class RLRouteManagerImpl;
+
 /**
  * \ingroup ipv4Helpers
  *
@@ -68,6 +70,41 @@ public:
    *
    */
   static void ComputeRoutingTables (double *metricArray);
+
+  /**
+   * @brief 用指定的RLRouteManagerImpl初始化路由数据库
+   *
+   * 上面的静态方法使用整个仿真共享的单例，同一进程中有多个互不相连的拓扑（如向量化环境）
+   * 时，每个拓扑使用自己的manager，只管理传入的节点
+   *
+   * @param manager 该拓扑的路由manager，由调用者持有
+   * @param adjacencyArray
+   * @param nodes
+   */
+  static void InitializeRouteDatabase (RLRouteManagerImpl *manager, int *adjacencyArray, NodeContainer nodes);
+
+  /**
+   * @brief 用指定的RLRouteManagerImpl重新计算并下发路由表，计时计入GetTotalComputeTime
+   *
+   * @param manager 该拓扑的路由manager
+   * @param weightArray
+   */
+  static void ComputeRoutingTables (RLRouteManagerImpl *manager, double *weightArray);
+
+  /**
+   * \brief 获取ComputeRoutingTables累计消耗的墙钟时间
+   *
+   * 用单调时钟计时，包括删除旧路由、设置权重和计算下发路由表。
+   * 可以作为回调传给OpenEnvInterface::SetGetRouteTimeCb，按step统计路由计算耗时。
+   *
+   * \returns 累计的路由计算时间（秒）
+   */
+  static double GetTotalComputeTime (void);
+
+  /**
+   * \returns ComputeRoutingTables被调用的次数
+   */
+  static uint32_t GetComputeCount (void);
 private:
   /**
    * \brief Assignment operator declared private and not implemented to disallow
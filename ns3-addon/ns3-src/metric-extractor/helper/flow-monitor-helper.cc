@@ -40,6 +40,7 @@
 namespace ns3 {
 
 FlowMonitorHelper::FlowMonitorHelper ()
+  : m_probeMode (RLFlowProbe::PROBE_FULL)
 {
   m_monitorFactory.SetTypeId ("ns3::FlowMonitor");
 }
@@ -61,6 +62,12 @@ FlowMonitorHelper::SetMonitorAttribute (std::string n1, const AttributeValue &v1
   m_monitorFactory.Set (n1, v1);
 }
 
+void
+FlowMonitorHelper::SetProbeMode (RLFlowProbe::ProbeMode mode)
+{
+  m_probeMode = mode;
+}
+
 
 Ptr<FlowMonitor>
 FlowMonitorHelper::GetMonitor ()
@@ -132,7 +139,7 @@ FlowMonitorHelper::RLInstall (Ptr<Node> node)
     {
       Ptr<RLFlowProbe> probe = Create<RLFlowProbe> (monitor,
                                                         DynamicCast<Ipv4FlowClassifier> (classifier),
-                                                        node);
+                                                        node, m_probeMode);
     }
   return m_flowMonitor;
 }
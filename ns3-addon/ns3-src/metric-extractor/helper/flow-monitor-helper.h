@@ -55,6 +55,15 @@ public:
    */
   void SetMonitorAttribute (std::string n1, const AttributeValue &v1);
 
+  /**
+   * \brief 设置之后RLInstall*安装的RLFlowProbe连接哪些trace
+   *
+   * 只需要端到端统计（TM、时延奖励）时使用RLFlowProbe::PROBE_END_TO_END，
+   * 中转节点上就不会再处理每个包；默认为RLFlowProbe::PROBE_FULL。
+   * \param mode the probe mode
+   */
+  void SetProbeMode (RLFlowProbe::ProbeMode mode);
+
   /**
    * \brief Enable flow monitoring on a set of nodes
    * \param nodes A NodeContainer holding the set of nodes to work with.
@@ -152,6 +161,7 @@ private:
   Ptr<FlowMonitor> m_flowMonitor;        //!< the FlowMonitor object
   Ptr<FlowClassifier> m_flowClassifier4; //!< the FlowClassifier object for IPv4
   Ptr<FlowClassifier> m_flowClassifier6; //!< the FlowClassifier object for IPv6
+  RLFlowProbe::ProbeMode m_probeMode;    //!< RLFlowProbe的安装模式
 };
 
 } // namespace ns3
@@ -27,10 +27,21 @@
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-list.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <fstream>
 #include <sstream>
 
 #define PERIODIC_CHECK_INTERVAL (Seconds (1))
+// 分位数sketch覆盖的取值范围（秒），小于下限的时延按0计
+#define SKETCH_MIN_VALUE (1e-6)
+#define SKETCH_MAX_VALUE (100.0)
+// node对表中未知的节点
+#define INVALID_NODE (std::numeric_limits<uint32_t>::max ())
 
 namespace ns3 {
 
@@ -74,6 +85,34 @@ FlowMonitor::GetTypeId (void)
                    TimeValue (Seconds (0.5)),
                    MakeTimeAccessor (&FlowMonitor::m_flowInterruptionsMinTime),
                    MakeTimeChecker ())
+    .AddAttribute ("EnableQuantileSketches", ("Track delay and jitter with fixed-size quantile sketches "
+                                              "instead of the delay/jitter histograms."),
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&FlowMonitor::m_quantileSketches),
+                   MakeBooleanChecker ())
+    .AddAttribute ("SketchRelativeAccuracy", ("The relative accuracy of the quantile sketches."),
+                   DoubleValue (0.01),
+                   MakeDoubleAccessor (&FlowMonitor::m_sketchRelativeAccuracy),
+                   MakeDoubleChecker <double> (1e-4, 0.5))
+    .AddAttribute ("SamplingRate", ("The fraction of packets that are tracked.  Packets are selected by "
+                                    "a hash of (flowId, packetId), so every probe agrees on the sample; "
+                                    "use GetEstimatedFlowStats to get counters scaled back to totals."),
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&FlowMonitor::SetSamplingRate,
+                                       &FlowMonitor::GetSamplingRate),
+                   MakeDoubleChecker <double> (0.0, 1.0))
+    .AddAttribute ("FlowIdleTimeout", ("Flows that neither sent nor received packets for this long, and have "
+                                       "no packet in flight, are folded into the evicted-flow aggregate and "
+                                       "removed from the flow stats and the probes.  Zero disables eviction."),
+                   TimeValue (Seconds (0.0)),
+                   MakeTimeAccessor (&FlowMonitor::m_flowIdleTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxTrackedPackets", ("The maximum number of in-flight packets tracked at the same time.  "
+                                         "New packets beyond this are not tracked and are counted as tracking "
+                                         "overflows.  Zero means no limit."),
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FlowMonitor::m_maxTrackedPackets),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
@@ -85,7 +124,16 @@ FlowMonitor::GetInstanceTypeId (void) const
 }
 
 FlowMonitor::FlowMonitor ()
-  : m_enabled (false)
+  : m_enabled (false),
+    m_quantileSketches (false),
+    m_sketchRelativeAccuracy (0.01),
+    m_samplingRate (1.0),
+    m_samplingThreshold (static_cast<uint64_t> (1) << 32),
+    m_nodePairNodeNum (0),
+    m_flowIdleTimeout (Seconds (0)),
+    m_maxTrackedPackets (0),
+    m_trackingOverflows (0),
+    m_evictedFlows (0)
 {
   // m_histogramBinWidth=DEFAULT_BIN_WIDTH;
 }
@@ -107,6 +155,80 @@ FlowMonitor::DoDispose (void)
   Object::DoDispose ();
 }
 
+/**
+ * \brief 采样使用的哈希（splitmix64的finalizer），相邻的packetId也能均匀分散
+ * \param flowId flow identification
+ * \param packetId Packet ID
+ * \returns the hash value
+ */
+static inline uint64_t
+SamplingHash (FlowId flowId, FlowPacketId packetId)
+{
+  uint64_t x = (static_cast<uint64_t> (flowId) << 32) | packetId;
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+void
+FlowMonitor::SetSamplingRate (double rate)
+{
+  m_samplingRate = rate;
+  m_samplingThreshold = static_cast<uint64_t> (rate * 4294967296.0);
+}
+
+double
+FlowMonitor::GetSamplingRate () const
+{
+  return m_samplingRate;
+}
+
+bool
+FlowMonitor::IsSampled (FlowId flowId, FlowPacketId packetId) const
+{
+  if (m_samplingThreshold > 0xffffffffULL)
+    {
+      return true;
+    }
+  return (SamplingHash (flowId, packetId) >> 32) < m_samplingThreshold;
+}
+
+double
+FlowMonitor::GetSamplingScale () const
+{
+  if (m_samplingRate <= 0)
+    {
+      return 0;
+    }
+  return 1.0 / m_samplingRate;
+}
+
+void
+FlowMonitor::InitFlowStats (FlowStats &stats) const
+{
+  stats.delaySum = Seconds (0);
+  stats.jitterSum = Seconds (0);
+  stats.lastDelay = Seconds (0);
+  stats.txBytes = 0;
+  stats.rxBytes = 0;
+  stats.txPackets = 0;
+  stats.rxPackets = 0;
+  stats.lostPackets = 0;
+  stats.timesForwarded = 0;
+  stats.delayHistogram.SetDefaultBinWidth (m_delayBinWidth);
+  stats.jitterHistogram.SetDefaultBinWidth (m_jitterBinWidth);
+  stats.packetSizeHistogram.SetDefaultBinWidth (m_packetSizeBinWidth);
+  stats.flowInterruptionsHistogram.SetDefaultBinWidth (m_flowInterruptionsBinWidth);
+  if (m_quantileSketches)
+    {
+      ConfigureQuantileSketch (stats.delaySketch);
+      ConfigureQuantileSketch (stats.jitterSketch);
+    }
+}
+
 inline FlowMonitor::FlowStats&
 FlowMonitor::GetStatsForFlow (FlowId flowId)
 {
@@ -115,19 +237,7 @@ FlowMonitor::GetStatsForFlow (FlowId flowId)
   if (iter == m_flowStats.end ())
     {
       FlowMonitor::FlowStats &ref = m_flowStats[flowId];
-      ref.delaySum = Seconds (0);
-      ref.jitterSum = Seconds (0);
-      ref.lastDelay = Seconds (0);
-      ref.txBytes = 0;
-      ref.rxBytes = 0;
-      ref.txPackets = 0;
-      ref.rxPackets = 0;
-      ref.lostPackets = 0;
-      ref.timesForwarded = 0;
-      ref.delayHistogram.SetDefaultBinWidth (m_delayBinWidth);
-      ref.jitterHistogram.SetDefaultBinWidth (m_jitterBinWidth);
-      ref.packetSizeHistogram.SetDefaultBinWidth (m_packetSizeBinWidth);
-      ref.flowInterruptionsHistogram.SetDefaultBinWidth (m_flowInterruptionsBinWidth);
+      InitFlowStats (ref);
       return ref;
     }
   else
@@ -136,11 +246,23 @@ FlowMonitor::GetStatsForFlow (FlowId flowId)
     }
 }
 
+bool
+FlowMonitor::CheckTrackingLimit ()
+{
+  if (m_maxTrackedPackets == 0 || m_trackedPackets.size () < m_maxTrackedPackets)
+    {
+      return true;
+    }
+  m_trackingOverflows++;
+  NS_LOG_LOGIC ("MaxTrackedPackets reached, not tracking new packet");
+  return false;
+}
+
 
 void
 FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetId, uint32_t packetSize)
 {
-  if (!m_enabled)
+  if (!m_enabled || !IsSampled (flowId, packetId) || !CheckTrackingLimit ())
     {
       return;
     }
@@ -149,6 +271,8 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
   tracked.firstSeenTime = now;
   tracked.lastSeenTime = tracked.firstSeenTime;
   tracked.timesForwarded = 0;
+  tracked.lastRLProbe = 0;
+  tracked.lastInterface = 0;
   NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
                                                                 << ").");
 
@@ -165,18 +289,20 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
 }
 
 // 重载方法
-void
+bool
 FlowMonitor::ReportFirstTx (Ptr<RLFlowProbe> probe, uint32_t flowId, uint32_t packetId, uint32_t packetSize, uint32_t nodeId, uint32_t interface)
 {
-  if (!m_enabled)
+  if (!m_enabled || !IsSampled (flowId, packetId) || !CheckTrackingLimit ())
     {
-      return;
+      return false;
     }
   Time now = Simulator::Now ();
   TrackedPacket &tracked = m_trackedPackets[std::make_pair (flowId, packetId)];
   tracked.firstSeenTime = now;
   tracked.lastSeenTime = tracked.firstSeenTime;
   tracked.timesForwarded = 0;
+  tracked.lastRLProbe = PeekPointer (probe);
+  tracked.lastInterface = interface;
   NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
                                                                 << ").");
 
@@ -190,12 +316,13 @@ FlowMonitor::ReportFirstTx (Ptr<RLFlowProbe> probe, uint32_t flowId, uint32_t pa
       stats.timeFirstTxPacket = now;
     }
   stats.timeLastTxPacket = now;
+  return true;
 }
 
 void
 FlowMonitor::ReportForwarding (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetId, uint32_t packetSize)
 {
-  if (!m_enabled)
+  if (!m_enabled || !IsSampled (flowId, packetId))
     {
       return;
     }
@@ -218,7 +345,7 @@ FlowMonitor::ReportForwarding (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t p
 void
 FlowMonitor::ReportForwarding (Ptr<RLFlowProbe> probe, uint32_t flowId, uint32_t packetId, uint32_t packetSize, uint32_t nodeId, uint32_t interface)
 {
-  if (!m_enabled)
+  if (!m_enabled || !IsSampled (flowId, packetId))
     {
       return;
     }
@@ -231,17 +358,21 @@ FlowMonitor::ReportForwarding (Ptr<RLFlowProbe> probe, uint32_t flowId, uint32_t
       return;
     }
 
+  Time now = Simulator::Now ();
+  ReportHopDelay (tracked->second, flowId, now);
   tracked->second.timesForwarded++;
-  tracked->second.lastSeenTime = Simulator::Now ();
+  tracked->second.lastSeenTime = now;
+  tracked->second.lastRLProbe = PeekPointer (probe);
+  tracked->second.lastInterface = interface;
 
-  Time delay = (Simulator::Now () - tracked->second.firstSeenTime);
+  Time delay = (now - tracked->second.firstSeenTime);
   probe->AddPacketStats (flowId, nodeId, interface, packetSize, delay);
 }
 
 void
 FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetId, uint32_t packetSize)
 {
-  if (!m_enabled)
+  if (!m_enabled || !IsSampled (flowId, packetId))
     {
       return;
     }
@@ -254,24 +385,35 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     }
 
   Time now = Simulator::Now ();
+  ReportHopDelay (tracked->second, flowId, now);
   Time delay = (now - tracked->second.firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 
   FlowStats &stats = GetStatsForFlow (flowId);
   stats.delaySum += delay;
-  stats.delayHistogram.AddValue (delay.GetSeconds ());
+  if (m_quantileSketches)
+    {
+      stats.delaySketch.AddValue (delay.GetSeconds ());
+    }
+  else
+    {
+      stats.delayHistogram.AddValue (delay.GetSeconds ());
+    }
   if (stats.rxPackets > 0 )
     {
       Time jitter = stats.lastDelay - delay;
-      if (jitter > Seconds (0))
+      if (jitter < Seconds (0))
         {
-          stats.jitterSum += jitter;
-          stats.jitterHistogram.AddValue (jitter.GetSeconds ());
+          jitter = -jitter;
         }
-      else 
+      stats.jitterSum += jitter;
+      if (m_quantileSketches)
+        {
+          stats.jitterSketch.AddValue (jitter.GetSeconds ());
+        }
+      else
         {
-          stats.jitterSum -= jitter;
-          stats.jitterHistogram.AddValue (-jitter.GetSeconds ());
+          stats.jitterHistogram.AddValue (jitter.GetSeconds ());
         }
     }
   stats.lastDelay = delay;
@@ -305,7 +447,7 @@ void
 FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetId, uint32_t packetSize,
                          uint32_t reasonCode)
 {
-  if (!m_enabled)
+  if (!m_enabled || !IsSampled (flowId, packetId))
     {
       return;
     }
@@ -334,12 +476,214 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
     }
 }
 
+bool
+FlowMonitor::HasFlowNodePair (FlowId flowId) const
+{
+  return flowId < m_flowNodePairs.size () && m_flowNodePairs[flowId].first != INVALID_NODE;
+}
+
+void
+FlowMonitor::SetFlowNodePair (FlowId flowId, uint32_t srcNode, uint32_t dstNode)
+{
+  NS_LOG_FUNCTION (this << flowId << srcNode << dstNode);
+  if (flowId >= m_flowNodePairs.size ())
+    {
+      // Ipv4FlowClassifier的FlowId从1开始连续分配
+      m_flowNodePairs.resize (flowId + 1, NodePair (INVALID_NODE, INVALID_NODE));
+    }
+  m_flowNodePairs[flowId] = NodePair (srcNode, dstNode);
+
+  uint32_t nodeNum = NodeList::GetNNodes ();
+  if (nodeNum > m_nodePairNodeNum)
+    {
+      ResizeNodePairMatrix (nodeNum);
+    }
+}
+
+void
+FlowMonitor::AddNodePairTx (FlowId flowId, uint32_t packetSize)
+{
+  if (!m_enabled || flowId >= m_flowNodePairs.size ())
+    {
+      return;
+    }
+  const NodePair &pair = m_flowNodePairs[flowId];
+  if (pair.first >= m_nodePairNodeNum || pair.second >= m_nodePairNodeNum)
+    {
+      return;
+    }
+  uint32_t index = pair.first * m_nodePairNodeNum + pair.second;
+  ++m_nodePairPackets[index];
+  m_nodePairBytes[index] += packetSize;
+}
+
+bool
+FlowMonitor::GetFlowNodePair (FlowId flowId, NodePair &pair) const
+{
+  if (!HasFlowNodePair (flowId) || m_flowNodePairs[flowId].second == INVALID_NODE)
+    {
+      return false;
+    }
+  pair = m_flowNodePairs[flowId];
+  return true;
+}
+
+uint32_t
+FlowMonitor::GetNodePairNodeNum () const
+{
+  return m_nodePairNodeNum;
+}
+
+const std::vector<uint64_t>&
+FlowMonitor::GetNodePairPackets () const
+{
+  return m_nodePairPackets;
+}
+
+const std::vector<uint64_t>&
+FlowMonitor::GetNodePairBytes () const
+{
+  return m_nodePairBytes;
+}
+
+void
+FlowMonitor::ResizeNodePairMatrix (uint32_t nodeNum)
+{
+  std::vector<uint64_t> packets (nodeNum * nodeNum, 0);
+  std::vector<uint64_t> bytes (nodeNum * nodeNum, 0);
+  for (uint32_t src = 0; src < m_nodePairNodeNum; src++)
+    {
+      for (uint32_t dst = 0; dst < m_nodePairNodeNum; dst++)
+        {
+          packets[src * nodeNum + dst] = m_nodePairPackets[src * m_nodePairNodeNum + dst];
+          bytes[src * nodeNum + dst] = m_nodePairBytes[src * m_nodePairNodeNum + dst];
+        }
+    }
+  m_nodePairPackets.swap (packets);
+  m_nodePairBytes.swap (bytes);
+  m_nodePairNodeNum = nodeNum;
+}
+
+bool
+FlowMonitor::IsQuantileSketchEnabled () const
+{
+  return m_quantileSketches;
+}
+
+void
+FlowMonitor::ConfigureQuantileSketch (QuantileSketch &sketch) const
+{
+  sketch.Configure (m_sketchRelativeAccuracy, SKETCH_MIN_VALUE, SKETCH_MAX_VALUE);
+}
+
+Time
+FlowMonitor::GetDelayQuantile (FlowId flowId, double q) const
+{
+  FlowStatsContainerCI iter = m_flowStats.find (flowId);
+  if (iter == m_flowStats.end ())
+    {
+      return Seconds (0);
+    }
+  return Seconds (iter->second.delaySketch.GetQuantile (q));
+}
+
+Time
+FlowMonitor::GetJitterQuantile (FlowId flowId, double q) const
+{
+  FlowStatsContainerCI iter = m_flowStats.find (flowId);
+  if (iter == m_flowStats.end ())
+    {
+      return Seconds (0);
+    }
+  return Seconds (iter->second.jitterSketch.GetQuantile (q));
+}
+
+void
+FlowMonitor::ResetQuantileSketches ()
+{
+  for (FlowStatsContainerI iter = m_flowStats.begin (); iter != m_flowStats.end (); iter++)
+    {
+      iter->second.delaySketch.Reset ();
+      iter->second.jitterSketch.Reset ();
+    }
+  for (FlowProbeContainerI iter = m_flowProbes.begin (); iter != m_flowProbes.end (); iter++)
+    {
+      Ptr<RLFlowProbe> probe = DynamicCast<RLFlowProbe> (*iter);
+      if (probe != 0)
+        {
+          probe->ResetQuantileSketches ();
+        }
+    }
+}
+
+void
+FlowMonitor::ReportHopDelay (const TrackedPacket &tracked, FlowId flowId, Time now)
+{
+  if (tracked.lastRLProbe != 0)
+    {
+      tracked.lastRLProbe->AddLinkDelayStats (flowId, tracked.lastInterface, now - tracked.lastSeenTime);
+    }
+}
+
 const FlowMonitor::FlowStatsContainer&
 FlowMonitor::GetFlowStats () const
 {
   return m_flowStats;
 }
 
+const FlowMonitor::FlowStats&
+FlowMonitor::GetEvictedFlowStats () const
+{
+  return m_evictedStats;
+}
+
+uint32_t
+FlowMonitor::GetNEvictedFlows () const
+{
+  return m_evictedFlows;
+}
+
+uint32_t
+FlowMonitor::GetNTrackedPackets () const
+{
+  return m_trackedPackets.size ();
+}
+
+uint64_t
+FlowMonitor::GetTrackingOverflowCount () const
+{
+  return m_trackingOverflows;
+}
+
+FlowMonitor::FlowStatsContainer
+FlowMonitor::GetEstimatedFlowStats () const
+{
+  FlowStatsContainer estimated (m_flowStats);
+  double scale = GetSamplingScale ();
+  if (scale == 1.0)
+    {
+      return estimated;
+    }
+  for (FlowStatsContainerI iter = estimated.begin (); iter != estimated.end (); iter++)
+    {
+      FlowStats &stats = iter->second;
+      stats.delaySum = Seconds (stats.delaySum.GetSeconds () * scale);
+      stats.jitterSum = Seconds (stats.jitterSum.GetSeconds () * scale);
+      stats.txBytes = std::llround (stats.txBytes * scale);
+      stats.rxBytes = std::llround (stats.rxBytes * scale);
+      stats.txPackets = std::lround (stats.txPackets * scale);
+      stats.rxPackets = std::lround (stats.rxPackets * scale);
+      stats.lostPackets = std::lround (stats.lostPackets * scale);
+      stats.timesForwarded = std::lround (stats.timesForwarded * scale);
+      for (uint32_t reasonCode = 0; reasonCode < stats.packetsDropped.size (); reasonCode++)
+        {
+          stats.packetsDropped[reasonCode] = std::lround (stats.packetsDropped[reasonCode] * scale);
+          stats.bytesDropped[reasonCode] = std::llround (stats.bytesDropped[reasonCode] * scale);
+        }
+    }
+  return estimated;
+}
+
 
 void
 FlowMonitor::CheckForLostPackets (Time maxDelay)
@@ -372,10 +716,80 @@ FlowMonitor::CheckForLostPackets ()
   CheckForLostPackets (m_maxPerHopDelay);
 }
 
+void
+FlowMonitor::EvictIdleFlows ()
+{
+  Time now = Simulator::Now ();
+  m_evictedFlowIds.clear ();
+  for (FlowStatsContainerI iter = m_flowStats.begin (); iter != m_flowStats.end (); )
+    {
+      FlowStats &stats = iter->second;
+      Time lastActive = std::max (stats.timeLastTxPacket, stats.timeLastRxPacket);
+      if (now - lastActive < m_flowIdleTimeout)
+        {
+          iter++;
+          continue;
+        }
+      // 还有在途包的flow不能淘汰，否则之后的接收或丢包会找不到它；
+      // 在途包按(FlowId, PacketId)排序，二分查找即可
+      TrackedPacketMap::iterator tracked = m_trackedPackets.lower_bound (std::make_pair (iter->first, 0));
+      if (tracked != m_trackedPackets.end () && tracked->first.first == iter->first)
+        {
+          iter++;
+          continue;
+        }
+
+      m_evictedStats.delaySum += stats.delaySum;
+      m_evictedStats.jitterSum += stats.jitterSum;
+      m_evictedStats.txBytes += stats.txBytes;
+      m_evictedStats.rxBytes += stats.rxBytes;
+      m_evictedStats.txPackets += stats.txPackets;
+      m_evictedStats.rxPackets += stats.rxPackets;
+      m_evictedStats.lostPackets += stats.lostPackets;
+      m_evictedStats.timesForwarded += stats.timesForwarded;
+      if (m_evictedStats.packetsDropped.size () < stats.packetsDropped.size ())
+        {
+          m_evictedStats.packetsDropped.resize (stats.packetsDropped.size (), 0);
+          m_evictedStats.bytesDropped.resize (stats.bytesDropped.size (), 0);
+        }
+      for (uint32_t reasonCode = 0; reasonCode < stats.packetsDropped.size (); reasonCode++)
+        {
+          m_evictedStats.packetsDropped[reasonCode] += stats.packetsDropped[reasonCode];
+          m_evictedStats.bytesDropped[reasonCode] += stats.bytesDropped[reasonCode];
+        }
+      if (m_quantileSketches)
+        {
+          m_evictedStats.delaySketch.Merge (stats.delaySketch);
+          m_evictedStats.jitterSketch.Merge (stats.jitterSketch);
+        }
+
+      // 按FlowId升序遍历，得到的列表已经有序
+      m_evictedFlowIds.push_back (iter->first);
+      m_flowStats.erase (iter++);
+    }
+
+  if (m_evictedFlowIds.empty ())
+    {
+      return;
+    }
+  m_evictedFlows += m_evictedFlowIds.size ();
+  for (FlowProbeContainerI iter = m_flowProbes.begin (); iter != m_flowProbes.end (); iter++)
+    {
+      (*iter)->EvictFlows (m_evictedFlowIds);
+    }
+  NS_LOG_LOGIC ("evicted " << m_evictedFlowIds.size () << " idle flows, "
+                           << m_flowStats.size () << " flows and "
+                           << m_trackedPackets.size () << " packets still tracked");
+}
+
 void
 FlowMonitor::PeriodicCheckForLostPackets ()
 {
   CheckForLostPackets ();
+  if (m_flowIdleTimeout > Seconds (0))
+    {
+      EvictIdleFlows ();
+    }
   Simulator::Schedule (PERIODIC_CHECK_INTERVAL, &FlowMonitor::PeriodicCheckForLostPackets, this);
 }
 
@@ -383,6 +797,8 @@ void
 FlowMonitor::NotifyConstructionCompleted ()
 {
   Object::NotifyConstructionCompleted ();
+  // 直方图宽度和sketch配置来自属性，构造函数中属性还没有设置
+  InitFlowStats (m_evictedStats);
   Simulator::Schedule (PERIODIC_CHECK_INTERVAL, &FlowMonitor::PeriodicCheckForLostPackets, this);
 }
 
@@ -399,6 +815,24 @@ FlowMonitor::GetAllProbes () const
   return m_flowProbes;
 }
 
+uint32_t
+FlowMonitor::GetAvailableMetrics () const
+{
+  uint32_t metrics = 0;
+  bool found = false;
+  for (FlowProbeContainerCI iter = m_flowProbes.begin (); iter != m_flowProbes.end (); iter++)
+    {
+      Ptr<RLFlowProbe> probe = DynamicCast<RLFlowProbe> (*iter);
+      if (probe == 0)
+        {
+          continue;
+        }
+      metrics = found ? (metrics & probe->GetAvailableMetrics ()) : probe->GetAvailableMetrics ();
+      found = true;
+    }
+  return metrics;
+}
+
 
 void
 FlowMonitor::Start (const Time &time)
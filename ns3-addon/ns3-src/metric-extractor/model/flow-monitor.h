@@ -35,6 +35,8 @@
 #include "ns3/rl-flow-probe.h"
 #include "ns3/flow-classifier.h"
 #include "ns3/histogram.h"
+#include "ns3/quantile-sketch.h"
+#include "ns3/slab-allocator.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
 
@@ -141,6 +143,13 @@ public:
     /// comment in attribute packetsDropped.
     std::vector<uint64_t> bytesDropped; // bytesDropped[reasonCode] => number of dropped bytes
     Histogram flowInterruptionsHistogram; //!< histogram of durations of flow interruptions
+
+    /// 端到端时延（秒）的分位数sketch，仅在EnableQuantileSketches为true时使用，
+    /// 此时不再填充delayHistogram
+    QuantileSketch delaySketch;
+    /// 抖动（秒）的分位数sketch，仅在EnableQuantileSketches为true时使用，
+    /// 此时不再填充jitterHistogram
+    QuantileSketch jitterSketch;
   };
 
   // --- basic methods ---
@@ -184,7 +193,9 @@ public:
   /// \param packetSize packet size
   void ReportFirstTx (Ptr<FlowProbe> probe, FlowId flowId, FlowPacketId packetId, uint32_t packetSize);
   /// 重载
-  void ReportFirstTx (Ptr<RLFlowProbe> probe, uint32_t flowId, uint32_t packetId, uint32_t packetSize, uint32_t nodeId, uint32_t interface);
+  /// \returns false if the packet is not tracked, either because it is
+  ///          not sampled or because MaxTrackedPackets is reached
+  bool ReportFirstTx (Ptr<RLFlowProbe> probe, uint32_t flowId, uint32_t packetId, uint32_t packetSize, uint32_t nodeId, uint32_t interface);
   /// FlowProbe implementations are supposed to call this method to
   /// report that a known packet is being forwarded.
   /// \param probe the reporting probe
@@ -212,6 +223,49 @@ public:
   void ReportDrop (Ptr<FlowProbe> probe, FlowId flowId, FlowPacketId packetId,
                    uint32_t packetSize, uint32_t reasonCode);
 
+  /// 判断一个包是否在采样范围内。结果只取决于(flowId, packetId)的哈希，
+  /// 所以同一个包在所有hop上得到的结论一致；SamplingRate为1时总是返回true。
+  /// \param flowId flow identification
+  /// \param packetId Packet ID
+  /// \returns true if the packet should be tracked
+  bool IsSampled (FlowId flowId, FlowPacketId packetId) const;
+
+  /// node对，first为源节点ID，second为目的节点ID
+  typedef std::pair<uint32_t, uint32_t> NodePair;
+
+  /// \param flowId flow identification
+  /// \returns true if the node pair of the flow has already been recorded
+  bool HasFlowNodePair (FlowId flowId) const;
+
+  /// 记录flow对应的node对，由RLFlowProbe在flow第一次发送时调用，每个flow只解析一次地址
+  /// \param flowId flow identification
+  /// \param srcNode ID of the node sending the flow
+  /// \param dstNode ID of the node owning the destination address, or
+  ///        std::numeric_limits<uint32_t>::max () if it cannot be resolved
+  void SetFlowNodePair (FlowId flowId, uint32_t srcNode, uint32_t dstNode);
+
+  /// 按node对累加源节点发出的一个包，所有包都计入，不受采样影响
+  /// \param flowId flow identification
+  /// \param packetSize packet size
+  void AddNodePairTx (FlowId flowId, uint32_t packetSize);
+
+  /// O(1)查询flow对应的node对
+  /// \param flowId flow identification
+  /// \param pair the node pair of the flow
+  /// \returns false if the flow is unknown or its destination was not resolved
+  bool GetFlowNodePair (FlowId flowId, NodePair &pair) const;
+
+  /// \returns 按node对统计的矩阵的边长N，尚未统计任何包时为0
+  uint32_t GetNodePairNodeNum () const;
+
+  /// 按node对统计的累计发送包数，N×N的稠密矩阵，下标为 src * N + dst
+  /// \returns the traffic matrix in packets
+  const std::vector<uint64_t>& GetNodePairPackets () const;
+
+  /// 按node对统计的累计发送字节数，布局同GetNodePairPackets
+  /// \returns the traffic matrix in bytes
+  const std::vector<uint64_t>& GetNodePairBytes () const;
+
   /// Check right now for packets that appear to be lost
   void CheckForLostPackets ();
 
@@ -224,11 +278,13 @@ public:
   // --- methods to get the results ---
 
   /// Container: FlowId, FlowStats
-  typedef std::map<FlowId, FlowStats> FlowStatsContainer;
+  /// 节点从SlabPool分配，淘汰flow后释放的节点会被新flow复用
+  typedef std::map<FlowId, FlowStats, std::less<FlowId>,
+                   SlabAllocator<std::pair<const FlowId, FlowStats> > > FlowStatsContainer;
   /// Container Iterator: FlowId, FlowStats
-  typedef std::map<FlowId, FlowStats>::iterator FlowStatsContainerI;
+  typedef FlowStatsContainer::iterator FlowStatsContainerI;
   /// Container Const Iterator: FlowId, FlowStats
-  typedef std::map<FlowId, FlowStats>::const_iterator FlowStatsContainerCI;
+  typedef FlowStatsContainer::const_iterator FlowStatsContainerCI;
   /// Container: FlowProbe
   typedef std::vector< Ptr<FlowProbe> > FlowProbeContainer;
   /// Container Iterator: FlowProbe
@@ -243,6 +299,59 @@ public:
   /// \returns the flows statistics
   const FlowStatsContainer& GetFlowStats () const;
 
+  /// 返回按采样率放大后的流统计：计数类字段（包数、字节数、时延和、丢包等）
+  /// 乘以 1/SamplingRate 得到无偏估计，直方图保持为样本的分布。
+  /// SamplingRate为1时与GetFlowStats()的内容相同。
+  /// \returns the estimated flows statistics
+  FlowStatsContainer GetEstimatedFlowStats () const;
+
+  /// 采样计数换算为估计值的放大系数，probe中的统计也应乘以该系数
+  /// \returns 1 / SamplingRate
+  double GetSamplingScale () const;
+
+  /// \returns true if quantile sketches are used instead of the delay/jitter histograms
+  bool IsQuantileSketchEnabled () const;
+
+  /// 按FlowMonitor的属性配置一个sketch，probe中的链路sketch也用它配置，保证可以合并
+  /// \param sketch the sketch to configure
+  void ConfigureQuantileSketch (QuantileSketch &sketch) const;
+
+  /// 查询一个flow的端到端时延分位数，可在GetReward中使用
+  /// \param flowId the Flow identification
+  /// \param q the quantile, in [0, 1]
+  /// \returns the estimated delay, or zero if the flow or its sketch is empty
+  Time GetDelayQuantile (FlowId flowId, double q) const;
+
+  /// 查询一个flow的抖动分位数
+  /// \param flowId the Flow identification
+  /// \param q the quantile, in [0, 1]
+  /// \returns the estimated jitter, or zero if the flow or its sketch is empty
+  Time GetJitterQuantile (FlowId flowId, double q) const;
+
+  /// 清空所有flow和RLFlowProbe链路上的sketch，在每个step结束时调用即可得到逐step的分位数
+  void ResetQuantileSketches ();
+
+  /// 被淘汰的flow（超过FlowIdleTimeout没有收发包）的汇总统计。
+  /// 计数和时延/抖动之和是所有被淘汰flow的累加，sketch在启用时合并，
+  /// 直方图和时间戳不保留。按累计值求增量时应把它和GetFlowStats的结果加在一起。
+  /// \returns the aggregated stats of the evicted flows
+  const FlowStats& GetEvictedFlowStats () const;
+
+  /// \returns 已经被淘汰的flow数目
+  uint32_t GetNEvictedFlows () const;
+
+  /// \returns 正在跟踪的在途包数目
+  uint32_t GetNTrackedPackets () const;
+
+  /// 在途包数目达到MaxTrackedPackets后，新发出的包不再被跟踪，也不计入flow统计。
+  /// 该计数非零时GetEstimatedFlowStats的放大系数会偏小，应调大上限或降低SamplingRate
+  /// \returns 因超过MaxTrackedPackets而没有被跟踪的包数
+  uint64_t GetTrackingOverflowCount () const;
+
+  /// 所有RLFlowProbe都能提供的统计，观测构建前可以用它检查所需的统计是否可用
+  /// \returns RLFlowProbe::MetricFlag的位掩码，没有RLFlowProbe时为0
+  uint32_t GetAvailableMetrics () const;
+
   /// Get a list of all FlowProbe's associated with this FlowMonitor
   /// \returns a list of all the probes
   const FlowProbeContainer& GetAllProbes () const;
@@ -281,13 +390,18 @@ private:
     Time firstSeenTime; //!< absolute time when the packet was first seen by a probe
     Time lastSeenTime; //!< absolute time when the packet was last seen by a probe
     uint32_t timesForwarded; //!< number of times the packet was reportedly forwarded
+    RLFlowProbe *lastRLProbe; //!< 上一次看到该包的RL probe，用于把逐跳时延记到对应链路上
+    uint32_t lastInterface; //!< 上一次看到该包时的出接口
   };
 
   /// FlowId --> FlowStats
   FlowStatsContainer m_flowStats;
 
   /// (FlowId,PacketId) --> TrackedPacket
-  typedef std::map< std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
+  typedef std::map< std::pair<FlowId, FlowPacketId>, TrackedPacket,
+                    std::less<std::pair<FlowId, FlowPacketId> >,
+                    SlabAllocator<std::pair<const std::pair<FlowId, FlowPacketId>, TrackedPacket> > >
+      TrackedPacketMap;
   TrackedPacketMap m_trackedPackets; //!< Tracked packets
   Time m_maxPerHopDelay; //!< Minimum per-hop delay
   FlowProbeContainer m_flowProbes; //!< all the FlowProbes
@@ -303,12 +417,54 @@ private:
   double m_packetSizeBinWidth;  //!< packet size bin width (for histograms)
   double m_flowInterruptionsBinWidth; //!< Flow interruptions bin width (for histograms)
   Time m_flowInterruptionsMinTime; //!< Flow interruptions minimum time
+  bool m_quantileSketches; //!< 用分位数sketch代替时延/抖动直方图
+  double m_sketchRelativeAccuracy; //!< sketch的相对精度
+  double m_samplingRate;    //!< 采样的包比例
+  uint64_t m_samplingThreshold; //!< 哈希高32位小于该阈值的包被采样
+  std::vector<NodePair> m_flowNodePairs;  //!< 以FlowId为下标的node对
+  uint32_t m_nodePairNodeNum;             //!< node对矩阵的边长
+  std::vector<uint64_t> m_nodePairPackets; //!< 按node对统计的发送包数
+  std::vector<uint64_t> m_nodePairBytes;   //!< 按node对统计的发送字节数
+  Time m_flowIdleTimeout;         //!< 超过该时间没有收发包的flow被淘汰，0表示不淘汰
+  uint32_t m_maxTrackedPackets;   //!< 在途包的跟踪上限，0表示不限制
+  uint64_t m_trackingOverflows;   //!< 因超过跟踪上限而没有被跟踪的包数
+  FlowStats m_evictedStats;       //!< 被淘汰flow的汇总统计
+  uint32_t m_evictedFlows;        //!< 被淘汰的flow数目
+  std::vector<FlowId> m_evictedFlowIds; //!< 一次淘汰中的FlowId，复用以避免每次分配
+
+  /// 节点数增加时扩大node对矩阵，保留已有的计数
+  /// \param nodeNum the new number of nodes
+  void ResizeNodePairMatrix (uint32_t nodeNum);
+
+  /// 设置采样率，同时更新采样阈值
+  /// \param rate fraction of packets to track, in [0, 1]
+  void SetSamplingRate (double rate);
+  /// \returns the fraction of packets tracked
+  double GetSamplingRate () const;
 
   /// Get the stats for a given flow
   /// \param flowId the Flow identification
   /// \returns the stats of the flow
   FlowStats& GetStatsForFlow (FlowId flowId);
 
+  /// 把一个flow的统计初始化为零，并按属性设置直方图和sketch
+  /// \param stats the stats to initialize
+  void InitFlowStats (FlowStats &stats) const;
+
+  /// 检查在途包数目是否已达到MaxTrackedPackets，达到时计入溢出计数
+  /// \returns true if a new packet can be tracked
+  bool CheckTrackingLimit ();
+
+  /// 淘汰超过FlowIdleTimeout没有收发包且没有在途包的flow，
+  /// 把它们的统计并入m_evictedStats，并通知各probe淘汰对应的统计
+  void EvictIdleFlows ();
+
+  /// 把包自上一跳以来的时延记到上一跳probe的出接口上
+  /// \param tracked the tracked packet
+  /// \param flowId the Flow identification
+  /// \param now current time
+  void ReportHopDelay (const TrackedPacket &tracked, FlowId flowId, Time now);
+
   /// Periodic function to check for lost packets and prune statistics
   void PeriodicCheckForLostPackets ();
 };
@@ -26,6 +26,7 @@
 
 #include "ns3/flow-probe.h"
 #include "ns3/flow-monitor.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -81,15 +82,73 @@ FlowProbe::AddPacketDropStats (FlowId flowId, uint32_t packetSize, uint32_t reas
   ++flow.packetsDropped[reasonCode];
   flow.bytesDropped[reasonCode] += packetSize;
 }
- 
+
+void
+FlowProbe::FoldStats (FlowStats &aggregate, const FlowStats &stats)
+{
+  aggregate.delayFromFirstProbeSum += stats.delayFromFirstProbeSum;
+  aggregate.bytes += stats.bytes;
+  aggregate.packets += stats.packets;
+  aggregate.hopDelaySum += stats.hopDelaySum;
+  aggregate.hopDelayCount += stats.hopDelayCount;
+  if (aggregate.packetsDropped.size () < stats.packetsDropped.size ())
+    {
+      aggregate.packetsDropped.resize (stats.packetsDropped.size (), 0);
+      aggregate.bytesDropped.resize (stats.bytesDropped.size (), 0);
+    }
+  for (uint32_t reasonCode = 0; reasonCode < stats.packetsDropped.size (); reasonCode++)
+    {
+      aggregate.packetsDropped[reasonCode] += stats.packetsDropped[reasonCode];
+      aggregate.bytesDropped[reasonCode] += stats.bytesDropped[reasonCode];
+    }
+}
+
+void
+FlowProbe::EvictFlows (const std::vector<FlowId> &flowIds)
+{
+  if (flowIds.empty ())
+    {
+      return;
+    }
+  for (std::vector<FlowId>::const_iterator fit = flowIds.begin (); fit != flowIds.end (); fit++)
+    {
+      Stats::iterator iter = m_stats.find (*fit);
+      if (iter != m_stats.end ())
+        {
+          FoldStats (m_stats[EVICTED_FLOW_ID], iter->second);
+          m_stats.erase (iter);
+        }
+    }
+  // RLStats是哈希表，只能整体扫描一遍；遍历时插入可能rehash，所以先汇总到临时表
+  RLStats evicted;
+  for (RLStats::iterator iter = m_rlstats.begin (); iter != m_rlstats.end (); )
+    {
+      if (iter->first.flowId != EVICTED_FLOW_ID &&
+          std::binary_search (flowIds.begin (), flowIds.end (), iter->first.flowId))
+        {
+          FoldStats (evicted[RLFlowId (EVICTED_FLOW_ID, iter->first.nodeId, iter->first.interface)],
+                     iter->second);
+          iter = m_rlstats.erase (iter);
+        }
+      else
+        {
+          iter++;
+        }
+    }
+  for (RLStats::const_iterator iter = evicted.begin (); iter != evicted.end (); iter++)
+    {
+      FoldStats (m_rlstats[iter->first], iter->second);
+    }
+}
+
 FlowProbe::Stats
 FlowProbe::GetStats () const 
 {
   return m_stats;
 }
 
-FlowProbe::RLStats
-FlowProbe::GetRLStats () const 
+const FlowProbe::RLStats&
+FlowProbe::GetRLStats () const
 {
   return m_rlstats;
 }
@@ -128,7 +187,7 @@ FlowProbe::SerializeToXmlStream (std::ostream &os, uint16_t indent, uint32_t ind
       indent -= 2;
       os << std::string ( indent, ' ' ) << "</FlowStats>\n";
     }
-    for (auto iter = m_rlstats.begin (); iter != m_rlstats.end (); iter++)
+  for (RLStats::const_iterator iter = m_rlstats.begin (); iter != m_rlstats.end (); iter++)
     {
       os << std::string ( indent, ' ' );
       os << "<RLFlowStats "
@@ -138,8 +197,9 @@ FlowProbe::SerializeToXmlStream (std::ostream &os, uint16_t indent, uint32_t ind
          << " packets=\"" << iter->second.packets << "\""
          << " bytes=\"" << iter->second.bytes << "\""
          << " delayFromFirstProbeSum=\"" << iter->second.delayFromFirstProbeSum << "\""
-         << " >\n";
-      os << std::string ( indent, ' ' ) << "</FlowStats>\n";
+         << " hopDelaySum=\"" << iter->second.hopDelaySum << "\""
+         << " hopDelayCount=\"" << iter->second.hopDelayCount << "\""
+         << " />\n";
     }
   indent -= 2;
   os << std::string ( indent, ' ' ) << "</FlowProbe>\n";
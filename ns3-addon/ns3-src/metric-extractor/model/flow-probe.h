@@ -28,11 +28,15 @@
 #define FLOW_PROBE_H
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 
+#include "ns3/abort.h"
+#include "ns3/assert.h"
 #include "ns3/object.h"
 #include "ns3/flow-classifier.h"
 #include "ns3/nstime.h"
+#include "ns3/slab-allocator.h"
 
 namespace ns3 {
 
@@ -67,7 +71,9 @@ public:
   /// Structure to hold the statistics of a flow
   struct FlowStats
   {
-    FlowStats () : delayFromFirstProbeSum (Seconds (0)), bytes (0), packets (0) {}
+    FlowStats ()
+        : delayFromFirstProbeSum (Seconds (0)), bytes (0), packets (0),
+          hopDelaySum (Seconds (0)), hopDelayCount (0) {}
 
     /// packetsDropped[reasonCode] => number of dropped packets
     std::vector<uint32_t> packetsDropped;
@@ -80,39 +86,72 @@ public:
     uint64_t bytes;
     /// Number of packets seen of this flow
     uint32_t packets;
+    /// 逐跳时延之和：包从本probe发出到下一跳看到它的时间差，
+    /// 只由RLFlowProbe记录，除以hopDelayCount得到该链路上的平均时延
+    Time hopDelaySum;
+    /// 计入hopDelaySum的包数（被下一跳看到的包数）
+    uint32_t hopDelayCount;
   };
 
   /// Container to map FlowId -> FlowStats
-  typedef std::map<FlowId, FlowStats> Stats;
+  /// 节点从SlabPool分配，淘汰flow后释放的节点会被新flow复用
+  typedef std::map<FlowId, FlowStats, std::less<FlowId>,
+                   SlabAllocator<std::pair<const FlowId, FlowStats> > > Stats;
+
+  /// FlowClassifier分配的FlowId从1开始，0用来保存被淘汰flow的汇总统计
+  static const FlowId EVICTED_FLOW_ID = 0;
 
   /// 重新定义Stats，保留原内容的情况下增加interface项和nodeId
-  // TODO 确认nodeId和probe的index是否一致；若一致，可取消这一项。
+  /// 三个字段打包成一个64位的key（flowId:32 | nodeId:16 | interface:16），
+  /// 比较和哈希都基于完整的key，因此可以跨节点聚合使用。
   struct RLFlowId
   {
     RLFlowId (FlowId fid, uint32_t nid, uint32_t iid)
-        : flowId (fid), nodeId (nid), interface (iid){};
+        : flowId (fid), nodeId (nid), interface (iid)
+    {
+      // 超过16位的id会在key中被截断，与其他链路的key冲突，优化编译下也必须检查
+      NS_ABORT_MSG_IF (nid > 0xffff || iid > 0xffff,
+                       "RLFlowId: nodeId " << nid << "/interface " << iid << " exceed 16 bits");
+    };
     FlowId flowId;
     uint32_t nodeId;
     uint32_t interface;
-    // TODO 重载<运算符
+
+    /// \returns 打包后的64位key
+    uint64_t
+    GetKey (void) const
+    {
+      return MakeKey (flowId, nodeId, interface);
+    }
+    /// 按 flowId:32 | nodeId:16 | interface:16 的布局打包，构造函数保证nid和iid不超过16位
+    static uint64_t
+    MakeKey (FlowId fid, uint32_t nid, uint32_t iid)
+    {
+      return (static_cast<uint64_t> (fid) << 32) | (static_cast<uint64_t> (nid & 0xffff) << 16) |
+             static_cast<uint64_t> (iid & 0xffff);
+    }
     bool
     operator< (const RLFlowId &r2) const
     {
-      if (this->flowId < r2.flowId)
-        {
-          return true;
-        }
-      else if (this->flowId == r2.flowId)
-        {
-          return this->interface < r2.interface;
-        }
-      else
-        {
-          return false;
-        }
+      return GetKey () < r2.GetKey ();
+    }
+    bool
+    operator== (const RLFlowId &r2) const
+    {
+      return GetKey () == r2.GetKey ();
+    }
+  };
+  /// RLFlowId的哈希函数，打包后的key本身已经足够分散
+  struct RLFlowIdHash
+  {
+    std::size_t
+    operator() (const RLFlowId &id) const
+    {
+      return std::hash<uint64_t> () (id.GetKey ());
     }
   };
-  typedef std::map<RLFlowId, FlowStats> RLStats; //!< RL使用的stats
+  typedef std::unordered_map<RLFlowId, FlowStats, RLFlowIdHash, std::equal_to<RLFlowId>,
+                             SlabAllocator<std::pair<const RLFlowId, FlowStats> > > RLStats; //!< RL使用的stats
 
   /// Add a packet data to the flow stats
   /// \param flowId the flow Identifier
@@ -125,6 +164,11 @@ public:
   /// \param reasonCode reason code for the drop
   void AddPacketDropStats (FlowId flowId, uint32_t packetSize, uint32_t reasonCode);
 
+  /// 淘汰一组不再活跃的flow：它们的统计并入EVICTED_FLOW_ID下的汇总项后删除。
+  /// RLStats按(nodeId, interface)汇总，所以按链路累加的结果不受淘汰影响
+  /// \param flowIds 按升序排列的FlowId
+  void EvictFlows (const std::vector<FlowId> &flowIds);
+
   /// Get the partial flow statistics stored in this probe.  With this
   /// information you can, for example, find out what is the delay
   /// from the first probe to this one.
@@ -134,8 +178,9 @@ public:
   /// Get the partial rl flow statistics stored in this probe.  With this
   /// information you can, for example, find out what is the delay
   /// from the first probe to this one.
+  /// 返回引用，逐step读取时不拷贝整个map
   /// \returns the partial flow statistics
-  RLStats GetRLStats () const;
+  const RLStats& GetRLStats () const;
 
   /// Serializes the results to an std::ostream in XML format
   /// \param os the output stream
@@ -144,6 +189,11 @@ public:
   void SerializeToXmlStream (std::ostream &os, uint16_t indent, uint32_t index) const;
 
 protected:
+  /// 把stats累加到aggregate上
+  /// \param aggregate the aggregated stats
+  /// \param stats the stats to fold in
+  static void FoldStats (FlowStats &aggregate, const FlowStats &stats);
+
   Ptr<FlowMonitor> m_flowMonitor; //!< the FlowMonitor instance
   Stats m_stats; //!< The flow stats
   RLStats m_rlstats; //!< rl使用的stats
@@ -0,0 +1,196 @@
+/*
+ * @desc: 以seqlock方式发布flow统计和链路统计的快照，供仿真线程之外的线程无锁读取
+ */
+
+#include "ns3/flow-stats-publisher.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/rl-flow-probe.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+// 槽位布局：头部之后依次是flow项和链路项
+#define HEADER_SLOTS (4)
+#define FLOW_SLOTS (7)
+#define LINK_SLOTS (8)
+#define SLOT_TIME (0)
+#define SLOT_FLOW_NUM (1)
+#define SLOT_LINK_NUM (2)
+#define SLOT_TRUNCATED (3)
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FlowStatsPublisher");
+
+FlowStatsPublisher::FlowStatsPublisher (uint32_t maxFlows, uint32_t maxLinks)
+  : m_maxFlows (maxFlows),
+    m_maxLinks (maxLinks),
+    m_sequence (0),
+    m_slots (HEADER_SLOTS + maxFlows * FLOW_SLOTS + maxLinks * LINK_SLOTS)
+{
+  NS_LOG_FUNCTION (this << maxFlows << maxLinks);
+  for (uint32_t index = 0; index < m_slots.size (); index++)
+    {
+      m_slots[index].store (0, std::memory_order_relaxed);
+    }
+}
+
+FlowStatsPublisher::~FlowStatsPublisher ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FlowStatsPublisher::Store (uint32_t index, uint64_t value)
+{
+  m_slots[index].store (value, std::memory_order_relaxed);
+}
+
+uint64_t
+FlowStatsPublisher::Load (uint32_t index) const
+{
+  return m_slots[index].load (std::memory_order_relaxed);
+}
+
+void
+FlowStatsPublisher::Publish (Ptr<FlowMonitor> monitor)
+{
+  NS_LOG_FUNCTION (this);
+  const FlowMonitor::FlowStatsContainer &flowStats = monitor->GetFlowStats ();
+  const FlowMonitor::FlowProbeContainer &probes = monitor->GetAllProbes ();
+
+  // 只有本线程写序号，直接读取即可
+  uint64_t sequence = m_sequence.load (std::memory_order_relaxed);
+  m_sequence.store (sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence (std::memory_order_release);
+
+  bool truncated = false;
+  uint32_t nFlows = 0;
+  uint32_t slot = HEADER_SLOTS;
+  for (FlowMonitor::FlowStatsContainerCI iter = flowStats.begin (); iter != flowStats.end (); iter++)
+    {
+      if (nFlows == m_maxFlows)
+        {
+          truncated = true;
+          break;
+        }
+      const FlowMonitor::FlowStats &stats = iter->second;
+      Store (slot++, iter->first);
+      Store (slot++, stats.txPackets);
+      Store (slot++, stats.rxPackets);
+      Store (slot++, stats.lostPackets);
+      Store (slot++, stats.txBytes);
+      Store (slot++, stats.rxBytes);
+      Store (slot++, static_cast<uint64_t> (stats.delaySum.GetNanoSeconds ()));
+      nFlows++;
+    }
+
+  uint32_t nLinks = 0;
+  slot = HEADER_SLOTS + m_maxFlows * FLOW_SLOTS;
+  for (FlowMonitor::FlowProbeContainerCI iter = probes.begin (); iter != probes.end (); iter++)
+    {
+      Ptr<RLFlowProbe> probe = DynamicCast<RLFlowProbe> (*iter);
+      if (probe == 0)
+        {
+          continue;
+        }
+      // 发送计数直接取自每条链路的计数器，不遍历该节点的逐flow统计
+      const RLFlowProbe::LinkStatsContainer &links = probe->GetLinkStats ();
+      for (uint32_t interface = 0; interface < links.size (); interface++)
+        {
+          if (nLinks == m_maxLinks)
+            {
+              truncated = true;
+              break;
+            }
+          const RLFlowProbe::LinkStats &link = links[interface];
+          Store (slot++, probe->GetNodeId ());
+          Store (slot++, interface);
+          Store (slot++, link.txPackets);
+          Store (slot++, link.txBytes);
+          Store (slot++, link.delayCount);
+          Store (slot++, static_cast<uint64_t> (link.delaySum.GetNanoSeconds ()));
+          Store (slot++, link.queueCount);
+          Store (slot++, static_cast<uint64_t> (link.queueDelaySum.GetNanoSeconds ()));
+          nLinks++;
+        }
+    }
+
+  Store (SLOT_TIME, static_cast<uint64_t> (Simulator::Now ().GetNanoSeconds ()));
+  Store (SLOT_FLOW_NUM, nFlows);
+  Store (SLOT_LINK_NUM, nLinks);
+  Store (SLOT_TRUNCATED, truncated ? 1 : 0);
+
+  m_sequence.store (sequence + 2, std::memory_order_release);
+  if (truncated)
+    {
+      NS_LOG_WARN ("FlowStatsPublisher: capacity exceeded, snapshot truncated");
+    }
+}
+
+bool
+FlowStatsPublisher::ReadSnapshot (Snapshot &snapshot, uint32_t maxRetries) const
+{
+  for (uint32_t retry = 0; retry <= maxRetries; retry++)
+    {
+      uint64_t begin = m_sequence.load (std::memory_order_acquire);
+      if (begin & 1)
+        {
+          // 正在发布
+          continue;
+        }
+
+      snapshot.timeNs = static_cast<int64_t> (Load (SLOT_TIME));
+      uint32_t nFlows = Load (SLOT_FLOW_NUM);
+      uint32_t nLinks = Load (SLOT_LINK_NUM);
+      snapshot.truncated = Load (SLOT_TRUNCATED) != 0;
+      // 被并发写入时读到的数目可能不合理，先截断，稍后由序号检查丢弃
+      nFlows = nFlows > m_maxFlows ? m_maxFlows : nFlows;
+      nLinks = nLinks > m_maxLinks ? m_maxLinks : nLinks;
+
+      snapshot.flows.resize (nFlows);
+      uint32_t slot = HEADER_SLOTS;
+      for (uint32_t index = 0; index < nFlows; index++)
+        {
+          FlowRecord &flow = snapshot.flows[index];
+          flow.flowId = Load (slot++);
+          flow.txPackets = Load (slot++);
+          flow.rxPackets = Load (slot++);
+          flow.lostPackets = Load (slot++);
+          flow.txBytes = Load (slot++);
+          flow.rxBytes = Load (slot++);
+          flow.delaySumNs = static_cast<int64_t> (Load (slot++));
+        }
+
+      snapshot.links.resize (nLinks);
+      slot = HEADER_SLOTS + m_maxFlows * FLOW_SLOTS;
+      for (uint32_t index = 0; index < nLinks; index++)
+        {
+          LinkRecord &link = snapshot.links[index];
+          link.nodeId = Load (slot++);
+          link.interface = Load (slot++);
+          link.packets = Load (slot++);
+          link.bytes = Load (slot++);
+          link.delayCount = Load (slot++);
+          link.delaySumNs = static_cast<int64_t> (Load (slot++));
+          link.queueCount = Load (slot++);
+          link.queueDelaySumNs = static_cast<int64_t> (Load (slot++));
+        }
+
+      std::atomic_thread_fence (std::memory_order_acquire);
+      uint64_t end = m_sequence.load (std::memory_order_relaxed);
+      if (begin == end)
+        {
+          snapshot.epoch = begin / 2;
+          return true;
+        }
+    }
+  return false;
+}
+
+uint64_t
+FlowStatsPublisher::GetEpoch (void) const
+{
+  return m_sequence.load (std::memory_order_acquire) / 2;
+}
+
+} // namespace ns3
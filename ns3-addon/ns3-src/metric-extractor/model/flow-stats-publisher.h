@@ -0,0 +1,110 @@
+/*
+ * @desc: 以seqlock方式发布flow统计和链路统计的快照，供仿真线程之外的线程无锁读取
+ */
+
+#ifndef FLOW_STATS_PUBLISHER_H
+#define FLOW_STATS_PUBLISHER_H
+
+#include <atomic>
+#include <vector>
+
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class FlowMonitor;
+
+/**
+ * \ingroup flow-monitor
+ * \brief 把FlowMonitor的flow统计和RLFlowProbe的链路统计以seqlock的方式发布给其他线程
+ *
+ * 仿真线程在每个step（或任意时刻）调用Publish，把计数拷贝到容量固定的
+ * 原子数组中：写入前把序号加一（变为奇数），写完再加一（变回偶数）。
+ * 读线程（如ZMQ发送线程、指标导出线程）调用ReadSnapshot，读取前后比较序号，
+ * 序号为奇数或前后不一致时说明读到一半被覆盖，重新读取即可。
+ * 因此仿真线程不会被读线程阻塞，也不需要任何锁；序列化等耗时工作都在读线程完成。
+ *
+ * 只允许一个线程调用Publish；ReadSnapshot可以在任意多个线程中调用。
+ * 超出容量的flow和链路不会被发布，此时快照的truncated为true。
+ */
+class FlowStatsPublisher
+{
+public:
+  /// 快照中的一个flow
+  struct FlowRecord
+  {
+    uint64_t flowId;      //!< FlowId
+    uint64_t txPackets;   //!< 累计发送包数
+    uint64_t rxPackets;   //!< 累计接收包数
+    uint64_t lostPackets; //!< 累计丢失包数
+    uint64_t txBytes;     //!< 累计发送字节数
+    uint64_t rxBytes;     //!< 累计接收字节数
+    int64_t delaySumNs;   //!< 累计端到端时延（ns）
+  };
+
+  /// 快照中的一条链路（一个节点的一个出接口）
+  struct LinkRecord
+  {
+    uint64_t nodeId;          //!< 节点ID
+    uint64_t interface;       //!< 出接口
+    uint64_t packets;         //!< 累计从TxQueue发出的包数，不受采样影响
+    uint64_t bytes;           //!< 累计从TxQueue发出的字节数
+    uint64_t delayCount;      //!< 计入逐跳时延的包数
+    int64_t delaySumNs;       //!< 累计逐跳时延（ns）
+    uint64_t queueCount;      //!< 计入排队时延的包数
+    int64_t queueDelaySumNs;  //!< 累计排队时延（ns）
+  };
+
+  /// 一个一致的快照
+  struct Snapshot
+  {
+    uint64_t epoch;    //!< 第几次Publish，从1开始；0表示还没有发布过
+    int64_t timeNs;    //!< 发布时的仿真时间（ns）
+    bool truncated;    //!< 是否有flow或链路因超出容量而没有发布
+    std::vector<FlowRecord> flows;  //!< 各flow的统计
+    std::vector<LinkRecord> links;  //!< 各链路的统计
+  };
+
+  /// \param maxFlows 最多发布的flow数目
+  /// \param maxLinks 最多发布的链路数目
+  FlowStatsPublisher (uint32_t maxFlows, uint32_t maxLinks);
+  ~FlowStatsPublisher ();
+
+  /// 在仿真线程中发布当前的统计，之后读线程读到的都是这一时刻的数据
+  /// \param monitor the FlowMonitor to publish
+  void Publish (Ptr<FlowMonitor> monitor);
+
+  /// 在任意线程中读取最近一次发布的快照
+  /// \param snapshot the snapshot to fill; its vectors are reused across calls
+  /// \param maxRetries 读取过程中被Publish打断时的最大重试次数
+  /// \returns true if a consistent snapshot was read
+  bool ReadSnapshot (Snapshot &snapshot, uint32_t maxRetries = 64) const;
+
+  /// \returns 已经发布的次数，可在任意线程中调用，用于判断是否有新快照
+  uint64_t GetEpoch (void) const;
+
+private:
+  /// Defined and not implemented to avoid misuse
+  FlowStatsPublisher (FlowStatsPublisher const &);
+  /// Defined and not implemented to avoid misuse
+  /// \returns
+  FlowStatsPublisher& operator= (FlowStatsPublisher const &);
+
+  /// 仿真线程中写入一个槽位
+  /// \param index slot index
+  /// \param value the value
+  void Store (uint32_t index, uint64_t value);
+  /// 读线程中读取一个槽位
+  /// \param index slot index
+  /// \returns the value
+  uint64_t Load (uint32_t index) const;
+
+  uint32_t m_maxFlows;  //!< flow容量
+  uint32_t m_maxLinks;  //!< 链路容量
+  std::atomic<uint64_t> m_sequence;         //!< seqlock序号，奇数表示正在写
+  std::vector<std::atomic<uint64_t> > m_slots; //!< 头部、flow项和链路项依次排列
+};
+
+} // namespace ns3
+
+#endif /* FLOW_STATS_PUBLISHER_H */
@@ -0,0 +1,193 @@
+/*
+ * @desc: 逐step追加写入flow统计和链路统计的二进制文件，代替体积大、速度慢的XML
+ */
+
+#include <cstring>
+
+#include "ns3/flow-stats-writer.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/rl-flow-probe.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FlowStatsWriter");
+
+const uint16_t FlowStatsWriter::VERSION;
+
+FlowStatsWriter::FlowStatsWriter ()
+  : m_file (0),
+    m_used (0)
+{
+}
+
+FlowStatsWriter::~FlowStatsWriter ()
+{
+  Close ();
+}
+
+void
+FlowStatsWriter::Open (std::string fileName, uint32_t bufferSize)
+{
+  NS_LOG_FUNCTION (this << fileName << bufferSize);
+  Close ();
+  m_file = std::fopen (fileName.c_str (), "wb");
+  if (m_file == 0)
+    {
+      NS_FATAL_ERROR ("FlowStatsWriter: cannot open " << fileName);
+    }
+  // 缓冲区至少要能放下最长的单个字段
+  m_buffer.resize (bufferSize < 64 ? 64 : bufferSize);
+  m_used = 0;
+
+  Reserve (8);
+  std::memcpy (&m_buffer[m_used], "RLFS", 4);
+  m_used += 4;
+  PutU16 (VERSION);
+  PutU16 (0);
+}
+
+bool
+FlowStatsWriter::IsOpen (void) const
+{
+  return m_file != 0;
+}
+
+void
+FlowStatsWriter::WriteStep (uint64_t step, Ptr<FlowMonitor> monitor)
+{
+  NS_LOG_FUNCTION (this << step);
+  NS_ASSERT_MSG (m_file != 0, "FlowStatsWriter: WriteStep before Open");
+
+  const FlowMonitor::FlowStatsContainer &flowStats = monitor->GetFlowStats ();
+  const FlowMonitor::FlowProbeContainer &probes = monitor->GetAllProbes ();
+
+  // 先统计link项的数目，写step头时需要
+  uint32_t nLinks = 0;
+  for (FlowMonitor::FlowProbeContainerCI iter = probes.begin (); iter != probes.end (); iter++)
+    {
+      Ptr<RLFlowProbe> probe = DynamicCast<RLFlowProbe> (*iter);
+      if (probe != 0)
+        {
+          nLinks += probe->GetLinkStats ().size ();
+        }
+    }
+
+  PutU64 (step);
+  PutU64 (static_cast<uint64_t> (Simulator::Now ().GetNanoSeconds ()));
+  PutDouble (monitor->GetSamplingScale ());
+  PutU32 (flowStats.size ());
+  PutU32 (nLinks);
+
+  for (FlowMonitor::FlowStatsContainerCI iter = flowStats.begin (); iter != flowStats.end (); iter++)
+    {
+      const FlowMonitor::FlowStats &stats = iter->second;
+      PutU32 (iter->first);
+      PutU32 (stats.txPackets);
+      PutU32 (stats.rxPackets);
+      PutU32 (stats.lostPackets);
+      PutU32 (stats.timesForwarded);
+      PutU64 (stats.txBytes);
+      PutU64 (stats.rxBytes);
+      PutU64 (static_cast<uint64_t> (stats.delaySum.GetNanoSeconds ()));
+      PutU64 (static_cast<uint64_t> (stats.jitterSum.GetNanoSeconds ()));
+    }
+
+  for (FlowMonitor::FlowProbeContainerCI iter = probes.begin (); iter != probes.end (); iter++)
+    {
+      Ptr<RLFlowProbe> probe = DynamicCast<RLFlowProbe> (*iter);
+      if (probe == 0)
+        {
+          continue;
+        }
+      const RLFlowProbe::LinkStatsContainer &links = probe->GetLinkStats ();
+      for (uint32_t interface = 0; interface < links.size (); interface++)
+        {
+          const RLFlowProbe::LinkStats &link = links[interface];
+          PutU32 (probe->GetNodeId ());
+          PutU32 (interface);
+          PutU64 (link.txPackets);
+          PutU64 (link.txBytes);
+          PutU32 (link.delayCount);
+          PutU32 (link.queueCount);
+          PutU64 (static_cast<uint64_t> (link.delaySum.GetNanoSeconds ()));
+          PutU64 (static_cast<uint64_t> (link.delayMax.GetNanoSeconds ()));
+          PutU64 (static_cast<uint64_t> (link.queueDelaySum.GetNanoSeconds ()));
+          PutU64 (static_cast<uint64_t> (link.queueDelayMax.GetNanoSeconds ()));
+        }
+    }
+}
+
+void
+FlowStatsWriter::Flush (void)
+{
+  if (m_file == 0 || m_used == 0)
+    {
+      return;
+    }
+  if (std::fwrite (&m_buffer[0], 1, m_used, m_file) != m_used)
+    {
+      NS_FATAL_ERROR ("FlowStatsWriter: write failed");
+    }
+  m_used = 0;
+}
+
+void
+FlowStatsWriter::Close (void)
+{
+  if (m_file == 0)
+    {
+      return;
+    }
+  Flush ();
+  std::fclose (m_file);
+  m_file = 0;
+}
+
+void
+FlowStatsWriter::Reserve (uint32_t size)
+{
+  if (m_used + size > m_buffer.size ())
+    {
+      Flush ();
+    }
+}
+
+void
+FlowStatsWriter::PutU16 (uint16_t value)
+{
+  Reserve (2);
+  m_buffer[m_used++] = value & 0xff;
+  m_buffer[m_used++] = (value >> 8) & 0xff;
+}
+
+void
+FlowStatsWriter::PutU32 (uint32_t value)
+{
+  Reserve (4);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      m_buffer[m_used++] = (value >> (8 * i)) & 0xff;
+    }
+}
+
+void
+FlowStatsWriter::PutU64 (uint64_t value)
+{
+  Reserve (8);
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      m_buffer[m_used++] = (value >> (8 * i)) & 0xff;
+    }
+}
+
+void
+FlowStatsWriter::PutDouble (double value)
+{
+  uint64_t bits;
+  std::memcpy (&bits, &value, sizeof (bits));
+  PutU64 (bits);
+}
+
+} // namespace ns3
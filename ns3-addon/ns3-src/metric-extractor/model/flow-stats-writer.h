@@ -0,0 +1,95 @@
+/*
+ * @desc: 逐step追加写入flow统计和链路统计的二进制文件，代替体积大、速度慢的XML
+ */
+
+#ifndef FLOW_STATS_WRITER_H
+#define FLOW_STATS_WRITER_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class FlowMonitor;
+
+/**
+ * \ingroup flow-monitor
+ * \brief 把FlowMonitor的flow统计和RLFlowProbe的链路统计逐step追加写入二进制文件
+ *
+ * 所有写入先进入内部缓冲区，缓冲区满或Flush/Close时才一次性写入文件。
+ * 文件格式如下，所有字段均为小端：
+ *
+ *   文件头:  magic "RLFS" (4B) | version u16 | reserved u16
+ *   每个step一条记录，先是step头，随后是flow项和link项：
+ *   step头:  step u64 | time(ns) i64 | samplingScale f64 | flow数 u32 | link数 u32
+ *   flow项:  flowId u32 | txPackets u32 | rxPackets u32 | lostPackets u32 | timesForwarded u32 |
+ *            txBytes u64 | rxBytes u64 | delaySum(ns) i64 | jitterSum(ns) i64
+ *   link项:  nodeId u32 | interface u32 | packets u64 | bytes u64 | delayCount u32 | queueCount u32 |
+ *            delaySum(ns) i64 | delayMax(ns) i64 | queueDelaySum(ns) i64 | queueDelayMax(ns) i64
+ *
+ * 计数均为累计值。flow项只统计被采样的包（未按采样率放大），samplingScale用于换算；
+ * link项的packets/bytes是从接口TxQueue出队的全部包，不受采样影响。
+ * 读取和转换为CSV见python包pyns3中的flow_stats_reader.py。
+ */
+class FlowStatsWriter
+{
+public:
+  FlowStatsWriter ();
+  ~FlowStatsWriter ();
+
+  /// 文件格式版本，格式变化时递增
+  static const uint16_t VERSION = 1;
+
+  /// 打开文件并写入文件头，已有的同名文件会被覆盖
+  /// \param fileName name or path of the output file
+  /// \param bufferSize size of the write buffer in bytes
+  void Open (std::string fileName, uint32_t bufferSize = 1 << 16);
+
+  /// 追加一个step的flow统计和链路统计
+  /// \param step step index
+  /// \param monitor the FlowMonitor to dump
+  void WriteStep (uint64_t step, Ptr<FlowMonitor> monitor);
+
+  /// 把缓冲区中的内容写入文件
+  void Flush (void);
+
+  /// 写出剩余内容并关闭文件
+  void Close (void);
+
+  /// \returns true if a file is open
+  bool IsOpen (void) const;
+
+private:
+  /// Defined and not implemented to avoid misuse
+  FlowStatsWriter (FlowStatsWriter const &);
+  /// Defined and not implemented to avoid misuse
+  /// \returns
+  FlowStatsWriter& operator= (FlowStatsWriter const &);
+
+  /// 保证缓冲区中至少还有size字节的空间，不够时先写入文件
+  /// \param size number of bytes about to be written
+  void Reserve (uint32_t size);
+  /// 写入小端的16位无符号整数
+  /// \param value the value
+  void PutU16 (uint16_t value);
+  /// 写入小端的32位无符号整数
+  /// \param value the value
+  void PutU32 (uint32_t value);
+  /// 写入小端的64位无符号整数
+  /// \param value the value
+  void PutU64 (uint64_t value);
+  /// 写入64位浮点数（按IEEE 754位模式）
+  /// \param value the value
+  void PutDouble (double value);
+
+  std::FILE *m_file;              //!< 输出文件
+  std::vector<uint8_t> m_buffer;  //!< 写缓冲区
+  uint32_t m_used;                //!< 缓冲区中已使用的字节数
+};
+
+} // namespace ns3
+
+#endif /* FLOW_STATS_WRITER_H */
@@ -0,0 +1,160 @@
+/*
+ * @desc: 固定大小、可合并的分位数sketch（DDSketch），用于时延/抖动的p50/p95/p99
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "ns3/quantile-sketch.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+QuantileSketch::QuantileSketch ()
+  : m_relativeAccuracy (0),
+    m_gamma (0),
+    m_multiplier (0),
+    m_minValue (0),
+    m_minIndex (0),
+    m_nBins (0),
+    m_zeroCount (0),
+    m_count (0)
+{
+}
+
+QuantileSketch::QuantileSketch (double relativeAccuracy, double minValue, double maxValue)
+  : QuantileSketch ()
+{
+  Configure (relativeAccuracy, minValue, maxValue);
+}
+
+void
+QuantileSketch::Configure (double relativeAccuracy, double minValue, double maxValue)
+{
+  NS_ASSERT_MSG (relativeAccuracy > 0 && relativeAccuracy < 1, "relative accuracy must be in (0, 1)");
+  NS_ASSERT_MSG (minValue > 0 && maxValue > minValue, "invalid sketch range");
+  m_relativeAccuracy = relativeAccuracy;
+  m_gamma = (1 + relativeAccuracy) / (1 - relativeAccuracy);
+  m_multiplier = 1 / std::log (m_gamma);
+  m_minValue = minValue;
+  m_minIndex = static_cast<int32_t> (std::ceil (std::log (minValue) * m_multiplier));
+  int32_t maxIndex = static_cast<int32_t> (std::ceil (std::log (maxValue) * m_multiplier));
+  m_nBins = maxIndex - m_minIndex + 1;
+  m_bins.clear ();
+  m_zeroCount = 0;
+  m_count = 0;
+}
+
+bool
+QuantileSketch::IsConfigured (void) const
+{
+  return m_nBins > 0;
+}
+
+void
+QuantileSketch::AddValue (double value)
+{
+  NS_ASSERT_MSG (IsConfigured (), "QuantileSketch used before Configure");
+  ++m_count;
+  if (value < m_minValue)
+    {
+      ++m_zeroCount;
+      return;
+    }
+  if (m_bins.empty ())
+    {
+      m_bins.resize (m_nBins, 0);
+    }
+  int32_t index = static_cast<int32_t> (std::ceil (std::log (value) * m_multiplier)) - m_minIndex;
+  if (index < 0)
+    {
+      index = 0;
+    }
+  else if (index >= static_cast<int32_t> (m_nBins))
+    {
+      index = m_nBins - 1;
+    }
+  ++m_bins[index];
+}
+
+double
+QuantileSketch::GetQuantile (double q) const
+{
+  if (m_count == 0)
+    {
+      return 0;
+    }
+  if (q < 0)
+    {
+      q = 0;
+    }
+  else if (q > 1)
+    {
+      q = 1;
+    }
+  uint64_t rank = static_cast<uint64_t> (q * (m_count - 1));
+  if (rank < m_zeroCount)
+    {
+      return 0;
+    }
+  uint64_t seen = m_zeroCount;
+  for (uint32_t index = 0; index < m_bins.size (); index++)
+    {
+      seen += m_bins[index];
+      if (seen > rank)
+        {
+          // 桶 (gamma^(i-1), gamma^i] 的代表值，保证相对误差不超过精度
+          return 2 * std::pow (m_gamma, static_cast<int32_t> (index) + m_minIndex) / (m_gamma + 1);
+        }
+    }
+  return 2 * std::pow (m_gamma, static_cast<int32_t> (m_nBins) - 1 + m_minIndex) / (m_gamma + 1);
+}
+
+uint64_t
+QuantileSketch::GetCount (void) const
+{
+  return m_count;
+}
+
+void
+QuantileSketch::Merge (const QuantileSketch &other)
+{
+  if (!other.IsConfigured () || other.m_count == 0)
+    {
+      return;
+    }
+  if (!IsConfigured ())
+    {
+      *this = other;
+      return;
+    }
+  NS_ASSERT_MSG (m_nBins == other.m_nBins && m_minIndex == other.m_minIndex &&
+                 m_relativeAccuracy == other.m_relativeAccuracy,
+                 "merging sketches with different configurations");
+  if (!other.m_bins.empty ())
+    {
+      if (m_bins.empty ())
+        {
+          m_bins.resize (m_nBins, 0);
+        }
+      for (uint32_t index = 0; index < m_nBins; index++)
+        {
+          m_bins[index] += other.m_bins[index];
+        }
+    }
+  m_zeroCount += other.m_zeroCount;
+  m_count += other.m_count;
+}
+
+void
+QuantileSketch::Reset (void)
+{
+  if (!m_bins.empty ())
+    {
+      std::fill (m_bins.begin (), m_bins.end (), 0);
+    }
+  m_zeroCount = 0;
+  m_count = 0;
+}
+
+} // namespace ns3
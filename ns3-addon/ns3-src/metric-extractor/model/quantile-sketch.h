@@ -0,0 +1,74 @@
+/*
+ * @desc: 固定大小、可合并的分位数sketch（DDSketch），用于时延/抖动的p50/p95/p99
+ */
+
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup flow-monitor
+ * \brief 对数分桶的分位数sketch（DDSketch）
+ *
+ * 第i个桶覆盖 (gamma^(i-1), gamma^i]，其中 gamma = (1+a)/(1-a)，a为相对精度。
+ * 任意分位数的估计值与真实值的相对误差不超过a。桶的范围在Configure时由
+ * [minValue, maxValue]确定，之后内存大小固定：小于minValue的值单独计数，
+ * 大于maxValue的值计入最后一个桶。插入只需一次对数运算，为O(1)；
+ * 两个配置相同的sketch可以逐桶相加合并。
+ */
+class QuantileSketch
+{
+public:
+  QuantileSketch ();
+  /// \param relativeAccuracy relative accuracy of the quantile estimates, in (0, 1)
+  /// \param minValue smallest value distinguished from zero
+  /// \param maxValue largest value tracked without clamping
+  QuantileSketch (double relativeAccuracy, double minValue, double maxValue);
+
+  /// 设置精度和取值范围，并清空已有数据
+  /// \param relativeAccuracy relative accuracy of the quantile estimates, in (0, 1)
+  /// \param minValue smallest value distinguished from zero
+  /// \param maxValue largest value tracked without clamping
+  void Configure (double relativeAccuracy, double minValue, double maxValue);
+
+  /// \returns true if Configure has been called
+  bool IsConfigured (void) const;
+
+  /// 插入一个值
+  /// \param value the value (negative values are counted as zero)
+  void AddValue (double value);
+
+  /// 查询分位数
+  /// \param q the quantile, in [0, 1]
+  /// \returns the estimated value, or 0 if the sketch is empty
+  double GetQuantile (double q) const;
+
+  /// \returns the number of values added
+  uint64_t GetCount (void) const;
+
+  /// 合并另一个sketch，两者的配置必须相同
+  /// \param other the sketch to merge into this one
+  void Merge (const QuantileSketch &other);
+
+  /// 清空数据，保留配置；用于按step统计
+  void Reset (void);
+
+private:
+  double m_relativeAccuracy;     //!< 相对精度
+  double m_gamma;                //!< 相邻桶边界的比例
+  double m_multiplier;           //!< 1 / ln(gamma)
+  double m_minValue;             //!< 小于该值的计入m_zeroCount
+  int32_t m_minIndex;            //!< 第一个桶的下标
+  uint32_t m_nBins;              //!< 桶的数目
+  std::vector<uint32_t> m_bins;  //!< 各桶计数，首次插入时才分配
+  uint64_t m_zeroCount;          //!< 小于minValue的值的数目
+  uint64_t m_count;              //!< 值的总数
+};
+
+} // namespace ns3
+
+#endif /* QUANTILE_SKETCH_H */
@@ -13,8 +13,15 @@
 #include "ns3/flow-monitor.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
-#include "ns3/config.h"
 #include "ns3/flow-id-tag.h"
+#include "ns3/net-device.h"
+#include "ns3/queue.h"
+#include "ns3/queue-disc.h"
+#include "ns3/traffic-control-layer.h"
+#include "ns3/simulator.h"
+#include "ns3/node-list.h"
+
+#include <limits>
 
 namespace ns3 {
 
@@ -32,6 +39,9 @@ NS_LOG_COMPONENT_DEFINE ("RLFlowProbe");
  * This tag is added by FlowMonitor when a packet is seen for
  * the first time, and it is then used to classify the packet in
  * the following hops.
+ *
+ * The same tag is attached both as a byte tag and as a packet tag;
+ * the packet tag gives the following hops an O(1) lookup.
  */
 class RLFlowProbeTag : public Tag
 {
@@ -208,46 +218,144 @@ RLFlowProbeTag::IsSrcDstValid (Ipv4Address src, Ipv4Address dst) const
 // RLFlowProbe class implementation //
 ////////////////////////////////////////
 
+/**
+ * \brief 查找包上的RLFlowProbeTag
+ *
+ * 源节点同时打上byte tag和packet tag。后续每一跳优先读取packet tag，
+ * 只需在很短的packet tag链表中按TypeId匹配，不用遍历byte tag列表。
+ * 如果packet tag在途中被设备清掉，则回退到byte tag，并补回packet tag，
+ * 保证同一节点上后续的logger仍然走快速路径。
+ *
+ * \param packet the packet
+ * \param fTag the tag found
+ * \returns true if the packet carries a RLFlowProbeTag
+ */
+static bool
+LookupRLFlowProbeTag (Ptr<const Packet> packet, RLFlowProbeTag &fTag)
+{
+  if (packet->PeekPacketTag (fTag))
+    {
+      return true;
+    }
+  if (packet->FindFirstMatchingByteTag (fTag))
+    {
+      packet->AddPacketTag (fTag);
+      return true;
+    }
+  return false;
+}
+
 RLFlowProbe::RLFlowProbe (Ptr<FlowMonitor> monitor,
                               Ptr<Ipv4FlowClassifier> classifier,
-                              Ptr<Node> node)
+                              Ptr<Node> node,
+                              ProbeMode mode)
   : FlowProbe (monitor),
-    m_classifier (classifier)
+    m_classifier (classifier),
+    m_mode (mode),
+    m_metrics (0)
 {
-  NS_LOG_FUNCTION (this << node->GetId ());
+  NS_LOG_FUNCTION (this << node->GetId () << mode);
   m_nodeId = node->GetId();
   m_ipv4 = node->GetObject<Ipv4L3Protocol> ();
 
-  if (!m_ipv4->TraceConnectWithoutContext ("SendOutgoing",
-                                           MakeCallback (&RLFlowProbe::SendOutgoingLogger, Ptr<RLFlowProbe> (this))))
+  // 源和目的节点上的hook：分类打tag、端到端统计
+  if (mode != PROBE_LINKS)
     {
-      NS_FATAL_ERROR ("trace fail");
+      if (!m_ipv4->TraceConnectWithoutContext ("SendOutgoing",
+                                               MakeCallback (&RLFlowProbe::SendOutgoingLogger, Ptr<RLFlowProbe> (this))))
+        {
+          NS_FATAL_ERROR ("trace fail");
+        }
+      if (!m_ipv4->TraceConnectWithoutContext ("LocalDeliver",
+                                               MakeCallback (&RLFlowProbe::ForwardUpLogger, Ptr<RLFlowProbe> (this))))
+        {
+          NS_FATAL_ERROR ("trace fail");
+        }
+      m_metrics |= METRIC_FLOW_STATS | METRIC_NODE_PAIR_TM;
     }
-  if (!m_ipv4->TraceConnectWithoutContext ("UnicastForward",
-                                           MakeCallback (&RLFlowProbe::ForwardLogger, Ptr<RLFlowProbe> (this))))
+  // 丢包计数在所有模式下都需要；只有源节点打过tag的包才会报告给FlowMonitor
+  if (!m_ipv4->TraceConnectWithoutContext ("Drop",
+                                           MakeCallback (&RLFlowProbe::DropLogger, Ptr<RLFlowProbe> (this))))
     {
       NS_FATAL_ERROR ("trace fail");
     }
-  if (!m_ipv4->TraceConnectWithoutContext ("LocalDeliver",
-                                           MakeCallback (&RLFlowProbe::ForwardUpLogger, Ptr<RLFlowProbe> (this))))
+  m_metrics |= METRIC_DROP_COUNTS;
+  // 每一跳的hook
+  if (mode == PROBE_FULL)
     {
-      NS_FATAL_ERROR ("trace fail");
+      if (!m_ipv4->TraceConnectWithoutContext ("UnicastForward",
+                                               MakeCallback (&RLFlowProbe::ForwardLogger, Ptr<RLFlowProbe> (this))))
+        {
+          NS_FATAL_ERROR ("trace fail");
+        }
+      m_metrics |= METRIC_HOP_STATS;
     }
-
-  if (!m_ipv4->TraceConnectWithoutContext ("Drop",
-                                           MakeCallback (&RLFlowProbe::DropLogger, Ptr<RLFlowProbe> (this))))
+  if (mode == PROBE_END_TO_END)
     {
-      NS_FATAL_ERROR ("trace fail");
+      return;
     }
 
-  std::ostringstream qd;
-  qd << "/NodeList/" << node->GetId () << "/$ns3::TrafficControlLayer/RootQueueDiscList/*/Drop";
-  Config::ConnectWithoutContext (qd.str (), MakeCallback (&RLFlowProbe::QueueDiscDropLogger, Ptr<RLFlowProbe> (this)));
+  // 直接通过对象指针连接各设备的TxQueue和根queue disc，
+  // 不再用Config路径在全局命名空间里逐个节点做模式匹配
+  m_linkStats.resize (m_ipv4->GetNInterfaces ());
+  m_txQueueEnqueueTimes.resize (m_ipv4->GetNInterfaces ());
+  m_dropCounts.assign (GetDropIndex (m_ipv4->GetNInterfaces (), DROP_NO_ROUTE), 0);
+  m_dropCountsBase.assign (m_dropCounts.size (), 0);
+  Ptr<TrafficControlLayer> tc = node->GetObject<TrafficControlLayer> ();
+  for (uint32_t i = 0; i < node->GetNDevices (); i++)
+    {
+      Ptr<NetDevice> device = node->GetDevice (i);
+      // 没有IPv4接口的device上不会有被标记的包，丢包也无法对应到链路
+      int32_t interface = m_ipv4->GetInterfaceForDevice (device);
+      if (interface < 0)
+        {
+          continue;
+        }
+      if (tc != 0)
+        {
+          Ptr<QueueDisc> queueDisc = tc->GetRootQueueDiscOnDevice (device);
+          if (queueDisc != 0 &&
+              !queueDisc->TraceConnectWithoutContext ("Drop",
+                                                      MakeBoundCallback (&RLFlowProbe::QueueDiscDropLogger,
+                                                                         Ptr<RLFlowProbe> (this), interface)))
+            {
+              NS_FATAL_ERROR ("trace fail");
+            }
+        }
+
+      PointerValue txQueue;
+      if (!device->GetAttributeFailSafe ("TxQueue", txQueue))
+        {
+          continue;
+        }
+      Ptr<Queue<Packet> > queue = txQueue.Get<Queue<Packet> > ();
+      if (queue == 0)
+        {
+          continue;
+        }
+      if (!queue->TraceConnectWithoutContext ("Drop",
+                                              MakeBoundCallback (&RLFlowProbe::QueueDropLogger,
+                                                                 Ptr<RLFlowProbe> (this), interface)))
+        {
+          NS_FATAL_ERROR ("trace fail");
+        }
 
-  // code copied from point-to-point-helper.cc
-  std::ostringstream oss;
-  oss << "/NodeList/" << node->GetId () << "/DeviceList/*/TxQueue/Drop";
-  Config::ConnectWithoutContext (oss.str (), MakeCallback (&RLFlowProbe::QueueDropLogger, Ptr<RLFlowProbe> (this)));
+      // 统计每个出接口的排队时延
+      if (!queue->TraceConnectWithoutContext ("Enqueue",
+                                              MakeBoundCallback (&RLFlowProbe::TxQueueEnqueueLogger,
+                                                                 Ptr<RLFlowProbe> (this), interface)))
+        {
+          NS_FATAL_ERROR ("trace fail");
+        }
+      if (!queue->TraceConnectWithoutContext ("Dequeue",
+                                              MakeBoundCallback (&RLFlowProbe::TxQueueDequeueLogger,
+                                                                 Ptr<RLFlowProbe> (this), interface)))
+        {
+          NS_FATAL_ERROR ("trace fail");
+        }
+    }
+  // 本节点所有带TxQueue的设备都已连接入队/出队hook
+  m_metrics |= METRIC_QUEUE_STATS;
 }
 
 RLFlowProbe::~RLFlowProbe ()
@@ -275,6 +383,26 @@ RLFlowProbe::DoDispose ()
   FlowProbe::DoDispose ();
 }
 
+/**
+ * \brief 查找拥有该地址的节点
+ * \param address the IPv4 address
+ * \returns the node ID, or std::numeric_limits<uint32_t>::max () if no node owns the address
+ */
+static uint32_t
+ResolveNodeId (Ipv4Address address)
+{
+  for (NodeList::Iterator iter = NodeList::Begin (); iter != NodeList::End (); iter++)
+    {
+      Ptr<Ipv4> ipv4 = (*iter)->GetObject<Ipv4> ();
+      if (ipv4 != 0 && ipv4->GetInterfaceForAddress (address) >= 0)
+        {
+          return (*iter)->GetId ();
+        }
+    }
+  NS_LOG_WARN ("cannot resolve " << address << " to a node");
+  return std::numeric_limits<uint32_t>::max ();
+}
+
 void
 RLFlowProbe::SendOutgoingLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload, uint32_t interface)
 {
@@ -288,7 +416,7 @@ RLFlowProbe::SendOutgoingLogger (const Ipv4Header &ipHeader, Ptr<const Packet> i
     }
 
   RLFlowProbeTag fTag;
-  bool found = ipPayload->FindFirstMatchingByteTag (fTag);
+  bool found = LookupRLFlowProbeTag (ipPayload, fTag);
   if (found)
     {
       return;
@@ -297,14 +425,32 @@ RLFlowProbe::SendOutgoingLogger (const Ipv4Header &ipHeader, Ptr<const Packet> i
   if (m_classifier->Classify (ipHeader, ipPayload, &flowId, &packetId))
     {
       uint32_t size = (ipPayload->GetSize () + ipHeader.GetSerializedSize ());
+      // 按node对统计的TM在采样之前计数；目的地址只在flow第一次出现时解析
+      if (!m_flowMonitor->HasFlowNodePair (flowId))
+        {
+          m_flowMonitor->SetFlowNodePair (flowId, m_nodeId, ResolveNodeId (ipHeader.GetDestination ()));
+        }
+      m_flowMonitor->AddNodePairTx (flowId, size);
+
+      if (!m_flowMonitor->IsSampled (flowId, packetId))
+        {
+          // 未被采样的包不打tag，后续每一跳都不会再处理它
+          return;
+        }
       NS_LOG_DEBUG ("ReportFirstTx ("<<this<<", "<<flowId<<", "<<packetId<<", "<<size<<"); "
                                      << ipHeader << *ipPayload);
-      m_flowMonitor->ReportFirstTx (this, flowId, packetId, size, m_nodeId, interface);
+      if (!m_flowMonitor->ReportFirstTx (this, flowId, packetId, size, m_nodeId, interface))
+        {
+          // 在途包数目已达到上限，不打tag
+          return;
+        }
 
       // tag the packet with the flow id and packet id, so that the packet can be identified even
       // when Ipv4Header is not accessible at some non-IPv4 protocol layer
+      // byte tag在分片、封装时也能保留，packet tag供后续每一跳快速识别
       RLFlowProbeTag fTag (flowId, packetId, size, ipHeader.GetSource (), ipHeader.GetDestination ());
       ipPayload->AddByteTag (fTag);
+      ipPayload->AddPacketTag (fTag);
     }
 }
 
@@ -312,7 +458,7 @@ void
 RLFlowProbe::ForwardLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload, uint32_t interface)
 {
   RLFlowProbeTag fTag;
-  bool found = ipPayload->FindFirstMatchingByteTag (fTag);
+  bool found = LookupRLFlowProbeTag (ipPayload, fTag);
 
   if (found)
     {
@@ -340,19 +486,121 @@ RLFlowProbe::ForwardLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayl
 void
 RLFlowProbe::AddPacketStats (FlowId flowId, uint32_t nodeId, uint32_t interface, uint32_t packetSize, Time delayFromFirstProbe)
 {
-  RLFlowId rlFlowId = RLFlowId(flowId, nodeId, interface);
-  FlowStats &flow = m_rlstats[rlFlowId];
+  // 打包后的key直接做一次哈希查找
+  FlowStats &flow = m_rlstats[RLFlowId (flowId, nodeId, interface)];
   flow.delayFromFirstProbeSum += delayFromFirstProbe;
   flow.bytes += packetSize;
   ++flow.packets;
 }
 
+void
+RLFlowProbe::AddLinkDelayStats (FlowId flowId, uint32_t interface, Time hopDelay)
+{
+  if (m_mode != PROBE_FULL)
+    {
+      // 没有中转节点的hook时，这里得到的是多跳累计的时延，不能记到单条链路上
+      return;
+    }
+  if (interface >= m_linkStats.size ())
+    {
+      m_linkStats.resize (interface + 1);
+    }
+  LinkStats &link = m_linkStats[interface];
+  link.delaySum += hopDelay;
+  if (hopDelay > link.delayMax)
+    {
+      link.delayMax = hopDelay;
+    }
+  ++link.delayCount;
+  if (m_flowMonitor->IsQuantileSketchEnabled ())
+    {
+      if (!link.delaySketch.IsConfigured ())
+        {
+          m_flowMonitor->ConfigureQuantileSketch (link.delaySketch);
+        }
+      link.delaySketch.AddValue (hopDelay.GetSeconds ());
+    }
+
+  FlowStats &flow = m_rlstats[RLFlowId (flowId, m_nodeId, interface)];
+  flow.hopDelaySum += hopDelay;
+  ++flow.hopDelayCount;
+}
+
+const RLFlowProbe::LinkStatsContainer&
+RLFlowProbe::GetLinkStats () const
+{
+  return m_linkStats;
+}
+
+uint32_t
+RLFlowProbe::GetNodeId () const
+{
+  return m_nodeId;
+}
+
+RLFlowProbe::ProbeMode
+RLFlowProbe::GetProbeMode () const
+{
+  return m_mode;
+}
+
+uint32_t
+RLFlowProbe::GetAvailableMetrics () const
+{
+  return m_metrics;
+}
+
+uint32_t
+RLFlowProbe::GetDropIndex (uint32_t interface, DropReason reason)
+{
+  return interface * (DROP_INVALID_REASON + 1) + reason;
+}
+
+const RLFlowProbe::DropCountContainer&
+RLFlowProbe::GetDropCounts () const
+{
+  return m_dropCounts;
+}
+
+void
+RLFlowProbe::GetDropSnapshot (DropCountContainer &drops)
+{
+  drops.resize (m_dropCounts.size ());
+  m_dropCountsBase.resize (m_dropCounts.size (), 0);
+  for (uint32_t index = 0; index < m_dropCounts.size (); index++)
+    {
+      drops[index] = m_dropCounts[index] - m_dropCountsBase[index];
+      m_dropCountsBase[index] = m_dropCounts[index];
+    }
+}
+
+void
+RLFlowProbe::AddDropCount (uint32_t interface, DropReason reason)
+{
+  uint32_t index = GetDropIndex (interface, reason);
+  if (index >= m_dropCounts.size ())
+    {
+      // 安装probe之后新增的接口
+      m_dropCounts.resize (GetDropIndex (interface + 1, DROP_NO_ROUTE), 0);
+    }
+  ++m_dropCounts[index];
+}
+
+void
+RLFlowProbe::ResetQuantileSketches ()
+{
+  for (LinkStatsContainer::iterator iter = m_linkStats.begin (); iter != m_linkStats.end (); iter++)
+    {
+      iter->delaySketch.Reset ();
+      iter->queueDelaySketch.Reset ();
+    }
+}
 
 void
 RLFlowProbe::ForwardUpLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload, uint32_t interface)
 {
   RLFlowProbeTag fTag;
-  bool found = ipPayload->FindFirstMatchingByteTag (fTag);
+  bool found = LookupRLFlowProbeTag (ipPayload, fTag);
 
   if (found)
     {
@@ -394,8 +642,44 @@ RLFlowProbe::DropLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload
     }
 #endif
 
+  DropReason myReason;
+  switch (reason)
+    {
+    case Ipv4L3Protocol::DROP_TTL_EXPIRED:
+      myReason = DROP_TTL_EXPIRE;
+      NS_LOG_DEBUG ("DROP_TTL_EXPIRE");
+      break;
+    case Ipv4L3Protocol::DROP_NO_ROUTE:
+      myReason = DROP_NO_ROUTE;
+      NS_LOG_DEBUG ("DROP_NO_ROUTE");
+      break;
+    case Ipv4L3Protocol::DROP_BAD_CHECKSUM:
+      myReason = DROP_BAD_CHECKSUM;
+      NS_LOG_DEBUG ("DROP_BAD_CHECKSUM");
+      break;
+    case Ipv4L3Protocol::DROP_INTERFACE_DOWN:
+      myReason = DROP_INTERFACE_DOWN;
+      NS_LOG_DEBUG ("DROP_INTERFACE_DOWN");
+      break;
+    case Ipv4L3Protocol::DROP_ROUTE_ERROR:
+      myReason = DROP_ROUTE_ERROR;
+      NS_LOG_DEBUG ("DROP_ROUTE_ERROR");
+      break;
+    case Ipv4L3Protocol::DROP_FRAGMENT_TIMEOUT:
+      myReason = DROP_FRAGMENT_TIMEOUT;
+      NS_LOG_DEBUG ("DROP_FRAGMENT_TIMEOUT");
+      break;
+
+    default:
+      myReason = DROP_INVALID_REASON;
+      NS_FATAL_ERROR ("Unexpected drop reason code " << reason);
+    }
+
+  // 丢包计数不依赖采样和tag，所有包都计入
+  AddDropCount (ifIndex, myReason);
+
   RLFlowProbeTag fTag;
-  bool found = ipPayload->FindFirstMatchingByteTag (fTag);
+  bool found = LookupRLFlowProbeTag (ipPayload, fTag);
 
   if (found)
     {
@@ -407,50 +691,17 @@ RLFlowProbe::DropLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload
                             << ", destIp=" << ipHeader.GetDestination () << "); "
                             << "HDR: " << ipHeader << " PKT: " << *ipPayload);
 
-      DropReason myReason;
-
-
-      switch (reason)
-        {
-        case Ipv4L3Protocol::DROP_TTL_EXPIRED:
-          myReason = DROP_TTL_EXPIRE;
-          NS_LOG_DEBUG ("DROP_TTL_EXPIRE");
-          break;
-        case Ipv4L3Protocol::DROP_NO_ROUTE:
-          myReason = DROP_NO_ROUTE;
-          NS_LOG_DEBUG ("DROP_NO_ROUTE");
-          break;
-        case Ipv4L3Protocol::DROP_BAD_CHECKSUM:
-          myReason = DROP_BAD_CHECKSUM;
-          NS_LOG_DEBUG ("DROP_BAD_CHECKSUM");
-          break;
-        case Ipv4L3Protocol::DROP_INTERFACE_DOWN:
-          myReason = DROP_INTERFACE_DOWN;
-          NS_LOG_DEBUG ("DROP_INTERFACE_DOWN");
-          break;
-        case Ipv4L3Protocol::DROP_ROUTE_ERROR:
-          myReason = DROP_ROUTE_ERROR;
-          NS_LOG_DEBUG ("DROP_ROUTE_ERROR");
-          break;
-        case Ipv4L3Protocol::DROP_FRAGMENT_TIMEOUT:
-          myReason = DROP_FRAGMENT_TIMEOUT;
-          NS_LOG_DEBUG ("DROP_FRAGMENT_TIMEOUT");
-          break;
-
-        default:
-          myReason = DROP_INVALID_REASON;
-          NS_FATAL_ERROR ("Unexpected drop reason code " << reason);
-        }
-
       m_flowMonitor->ReportDrop (this, flowId, packetId, size, myReason);
     }
 }
 
 void 
-RLFlowProbe::QueueDropLogger (Ptr<const Packet> ipPayload)
+RLFlowProbe::QueueDropLogger (Ptr<RLFlowProbe> probe, uint32_t interface, Ptr<const Packet> ipPayload)
 {
+  probe->AddDropCount (interface, DROP_QUEUE);
+
   RLFlowProbeTag fTag;
-  bool tagFound = ipPayload->FindFirstMatchingByteTag (fTag);
+  bool tagFound = LookupRLFlowProbeTag (ipPayload, fTag);
 
   if (!tagFound)
     {
@@ -461,17 +712,19 @@ RLFlowProbe::QueueDropLogger (Ptr<const Packet> ipPayload)
   FlowPacketId packetId = fTag.GetPacketId ();
   uint32_t size = fTag.GetPacketSize ();
 
-  NS_LOG_DEBUG ("Drop ("<<this<<", "<<flowId<<", "<<packetId<<", "<<size<<", " << DROP_QUEUE 
+  NS_LOG_DEBUG ("Drop ("<<probe<<", "<<flowId<<", "<<packetId<<", "<<size<<", " << DROP_QUEUE 
                         << "); ");
 
-  m_flowMonitor->ReportDrop (this, flowId, packetId, size, DROP_QUEUE);
+  probe->m_flowMonitor->ReportDrop (probe, flowId, packetId, size, DROP_QUEUE);
 }
 
 void
-RLFlowProbe::QueueDiscDropLogger (Ptr<const QueueDiscItem> item)
+RLFlowProbe::QueueDiscDropLogger (Ptr<RLFlowProbe> probe, uint32_t interface, Ptr<const QueueDiscItem> item)
 {
+  probe->AddDropCount (interface, DROP_QUEUE_DISC);
+
   RLFlowProbeTag fTag;
-  bool tagFound = item->GetPacket ()->FindFirstMatchingByteTag (fTag);
+  bool tagFound = LookupRLFlowProbeTag (item->GetPacket (), fTag);
 
   if (!tagFound)
     {
@@ -482,10 +735,47 @@ RLFlowProbe::QueueDiscDropLogger (Ptr<const QueueDiscItem> item)
   FlowPacketId packetId = fTag.GetPacketId ();
   uint32_t size = fTag.GetPacketSize ();
 
-  NS_LOG_DEBUG ("Drop ("<<this<<", "<<flowId<<", "<<packetId<<", "<<size<<", " << DROP_QUEUE_DISC
+  NS_LOG_DEBUG ("Drop ("<<probe<<", "<<flowId<<", "<<packetId<<", "<<size<<", " << DROP_QUEUE_DISC
                         << "); ");
 
-  m_flowMonitor->ReportDrop (this, flowId, packetId, size, DROP_QUEUE_DISC);
+  probe->m_flowMonitor->ReportDrop (probe, flowId, packetId, size, DROP_QUEUE_DISC);
+}
+
+void
+RLFlowProbe::TxQueueEnqueueLogger (Ptr<RLFlowProbe> probe, uint32_t interface, Ptr<const Packet> packet)
+{
+  probe->m_txQueueEnqueueTimes[interface].push_back (Simulator::Now ());
+}
+
+void
+RLFlowProbe::TxQueueDequeueLogger (Ptr<RLFlowProbe> probe, uint32_t interface, Ptr<const Packet> packet)
+{
+  std::deque<Time> &enqueueTimes = probe->m_txQueueEnqueueTimes[interface];
+  if (enqueueTimes.empty ())
+    {
+      // probe安装之前就已经在队列中的包
+      return;
+    }
+  Time queueDelay = Simulator::Now () - enqueueTimes.front ();
+  enqueueTimes.pop_front ();
+
+  LinkStats &link = probe->m_linkStats[interface];
+  ++link.txPackets;
+  link.txBytes += packet->GetSize ();
+  link.queueDelaySum += queueDelay;
+  if (queueDelay > link.queueDelayMax)
+    {
+      link.queueDelayMax = queueDelay;
+    }
+  ++link.queueCount;
+  if (probe->m_flowMonitor->IsQuantileSketchEnabled ())
+    {
+      if (!link.queueDelaySketch.IsConfigured ())
+        {
+          probe->m_flowMonitor->ConfigureQuantileSketch (link.queueDelaySketch);
+        }
+      link.queueDelaySketch.AddValue (queueDelay.GetSeconds ());
+    }
 }
 
 } // namespace ns3
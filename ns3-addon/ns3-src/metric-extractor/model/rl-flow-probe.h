@@ -8,10 +8,14 @@
 #ifndef RL_FLOW_PROBE_H
 #define RL_FLOW_PROBE_H
 
+#include <deque>
+#include <vector>
+
 #include "ns3/flow-probe.h"
 #include "ns3/ipv4-flow-classifier.h"
 #include "ns3/ipv4-l3-protocol.h"
 #include "ns3/queue-item.h"
+#include "ns3/quantile-sketch.h"
 
 namespace ns3 {
 
@@ -29,11 +33,36 @@ class RLFlowProbe : public FlowProbe
 {
 
 public:
+  /// probe连接哪些trace，决定了能提供哪些统计
+  enum ProbeMode
+  {
+    /// 所有L3 hook、丢包hook和TxQueue hook，提供全部统计
+    PROBE_FULL = 0,
+    /// 只连接SendOutgoing、LocalDeliver和IPv4 Drop：端到端flow统计和node对TM，
+    /// 中转节点上不处理任何包
+    PROBE_END_TO_END,
+    /// 只连接TxQueue、queue disc和IPv4 Drop的hook：链路发送计数、排队时延和丢包计数，
+    /// 不对包做分类和打tag
+    PROBE_LINKS
+  };
+
+  /// 可用统计的位掩码，见GetAvailableMetrics
+  enum MetricFlag
+  {
+    METRIC_FLOW_STATS = 1 << 0,   //!< FlowMonitor的端到端flow统计（时延、抖动、丢包等）
+    METRIC_NODE_PAIR_TM = 1 << 1, //!< 按node对统计的TM
+    METRIC_HOP_STATS = 1 << 2,    //!< 每跳的flow统计（GetRLStats）和逐跳时延
+    METRIC_QUEUE_STATS = 1 << 3,  //!< 链路发送计数和TxQueue排队时延
+    METRIC_DROP_COUNTS = 1 << 4   //!< 按(interface, reason)的丢包计数，需要IPv4 Drop trace
+  };
+
   /// \brief Constructor
   /// \param monitor the FlowMonitor this probe is associated with
   /// \param classifier the Ipv4FlowClassifier this probe is associated with
   /// \param node the Node this probe is associated with
-  RLFlowProbe (Ptr<FlowMonitor> monitor, Ptr<Ipv4FlowClassifier> classifier, Ptr<Node> node);
+  /// \param mode which trace sources to connect
+  RLFlowProbe (Ptr<FlowMonitor> monitor, Ptr<Ipv4FlowClassifier> classifier, Ptr<Node> node,
+               ProbeMode mode = PROBE_FULL);
   virtual ~RLFlowProbe ();
 
   /// Register this type.
@@ -44,6 +73,59 @@ public:
   void AddPacketStats (FlowId flowId, uint32_t nodeId, uint32_t interface, uint32_t packetSize,
                        Time delayFromFirstProbe);
 
+  /// 单条链路（本节点的一个出接口）上的时延统计
+  struct LinkStats
+  {
+    LinkStats ()
+        : delaySum (Seconds (0)), delayMax (Seconds (0)), delayCount (0),
+          queueDelaySum (Seconds (0)), queueDelayMax (Seconds (0)), queueCount (0),
+          txPackets (0), txBytes (0) {}
+    /// 逐跳时延之和：从本接口发出到下一跳看到包，包含排队、发送和传播时延
+    Time delaySum;
+    /// 最大逐跳时延
+    Time delayMax;
+    /// 计入delaySum的包数
+    uint32_t delayCount;
+    /// 在设备TxQueue中的排队时延之和（所有包，不区分flow）
+    Time queueDelaySum;
+    /// 最大排队时延
+    Time queueDelayMax;
+    /// 计入queueDelaySum的出队包数
+    uint32_t queueCount;
+    /// 从TxQueue出队（即开始发送）的包数，不区分flow、不受采样影响
+    uint64_t txPackets;
+    /// 从TxQueue出队的字节数
+    uint64_t txBytes;
+    /// 逐跳时延（秒）的分位数sketch，仅在FlowMonitor启用EnableQuantileSketches时使用
+    QuantileSketch delaySketch;
+    /// 排队时延（秒）的分位数sketch，仅在FlowMonitor启用EnableQuantileSketches时使用
+    QuantileSketch queueDelaySketch;
+  };
+  /// 以interface为下标的链路统计
+  typedef std::vector<LinkStats> LinkStatsContainer;
+
+  /// 记录一个包在本节点某个出接口对应链路上的逐跳时延，由FlowMonitor在下一跳看到该包时调用
+  /// \param flowId the flow Identifier
+  /// \param interface outgoing interface of this node
+  /// \param hopDelay time since the packet was seen by this probe
+  void AddLinkDelayStats (FlowId flowId, uint32_t interface, Time hopDelay);
+
+  /// 获取本节点各出接口的链路统计，返回引用，每个step读取时无需拷贝
+  /// \returns the per-interface link statistics
+  const LinkStatsContainer& GetLinkStats () const;
+
+  /// \returns probe绑定的node的ID
+  uint32_t GetNodeId () const;
+
+  /// \returns the mode the probe was installed with
+  ProbeMode GetProbeMode () const;
+
+  /// \returns 本probe能提供的统计，MetricFlag的位掩码，由构造时实际连接的trace决定
+  uint32_t GetAvailableMetrics () const;
+
+  /// 清空各链路的分位数sketch，由FlowMonitor::ResetQuantileSketches调用
+  void ResetQuantileSketches ();
+
   /// \brief enumeration of possible reasons why a packet may be dropped
   enum DropReason {
     /// Packet dropped due to missing route to the destination
@@ -71,6 +153,24 @@ public:
     DROP_INVALID_REASON, /**< Fallback reason (no known reason) */
   };
 
+  /// 按(interface, reason)排列的丢包计数，下标见GetDropIndex
+  typedef std::vector<uint32_t> DropCountContainer;
+
+  /// 丢包计数数组的下标：interface * (DROP_INVALID_REASON + 1) + reason
+  /// \param interface interface of this node where the packet was dropped
+  /// \param reason drop reason
+  /// \returns the index into DropCountContainer
+  static uint32_t GetDropIndex (uint32_t interface, DropReason reason);
+
+  /// 获取本节点自安装以来的累计丢包计数，包括未被采样、没有tag的包
+  /// \returns the cumulative drop counts
+  const DropCountContainer& GetDropCounts () const;
+
+  /// 把上次调用以来的丢包数写入drops（调用者的数组会被调整为相同大小，可重复使用），
+  /// 并开始新的统计窗口
+  /// \param drops the per-(interface, reason) drops in the last window
+  void GetDropSnapshot (DropCountContainer &drops);
+
 protected:
   virtual void DoDispose (void);
 
@@ -101,15 +201,41 @@ private:
   void DropLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload,
                    Ipv4L3Protocol::DropReason reason, Ptr<Ipv4> ipv4, uint32_t ifIndex);
   /// Log a packet being dropped by a queue
+  /// \param probe the probe
+  /// \param interface interface of the device
   /// \param ipPayload IP payload
-  void QueueDropLogger (Ptr<const Packet> ipPayload);
+  static void QueueDropLogger (Ptr<RLFlowProbe> probe, uint32_t interface, Ptr<const Packet> ipPayload);
   /// Log a packet being dropped by a queue disc
+  /// \param probe the probe
+  /// \param interface interface of the device
   /// \param item queue disc item
-  void QueueDiscDropLogger (Ptr<const QueueDiscItem> item);
+  static void QueueDiscDropLogger (Ptr<RLFlowProbe> probe, uint32_t interface, Ptr<const QueueDiscItem> item);
+  /// 累加一次丢包计数
+  /// \param interface interface where the packet was dropped
+  /// \param reason drop reason
+  void AddDropCount (uint32_t interface, DropReason reason);
+  /// 记录包进入设备TxQueue的时间
+  /// \param probe the probe
+  /// \param interface interface of the device
+  /// \param packet the packet
+  static void TxQueueEnqueueLogger (Ptr<RLFlowProbe> probe, uint32_t interface, Ptr<const Packet> packet);
+  /// 包离开设备TxQueue时计算排队时延
+  /// \param probe the probe
+  /// \param interface interface of the device
+  /// \param packet the packet
+  static void TxQueueDequeueLogger (Ptr<RLFlowProbe> probe, uint32_t interface, Ptr<const Packet> packet);
 
   Ptr<Ipv4FlowClassifier> m_classifier; //!< the Ipv4FlowClassifier this probe is associated with
   Ptr<Ipv4L3Protocol> m_ipv4; //!< the Ipv4L3Protocol this probe is bound to
   uint32_t m_nodeId; //!< probe绑定的node的ID
+  ProbeMode m_mode; //!< 连接了哪些trace
+  uint32_t m_metrics; //!< 已连接的trace能提供的统计，MetricFlag的位掩码
+  LinkStatsContainer m_linkStats; //!< 各出接口的链路统计
+  /// 各接口TxQueue中包的入队时间；TxQueue是FIFO（默认的DropTailQueue），
+  /// 出队时取队首即可，不需要按包查表
+  std::vector<std::deque<Time> > m_txQueueEnqueueTimes;
+  DropCountContainer m_dropCounts;     //!< 累计丢包计数
+  DropCountContainer m_dropCountsBase; //!< 上一次GetDropSnapshot时的累计丢包计数
 };
 
 } // namespace ns3
@@ -0,0 +1,249 @@
+/*
+ * @desc: 基于TxQueue入队/出队trace的链路利用率与平均队列长度统计
+ */
+
+#include "ns3/rl-link-monitor.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/pointer.h"
+#include "ns3/data-rate.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RLLinkMonitor");
+
+NS_OBJECT_ENSURE_REGISTERED (RLLinkMonitor);
+
+TypeId
+RLLinkMonitor::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RLLinkMonitor")
+    .SetParent<Object> ()
+    .SetGroupName ("FlowMonitor")
+    .AddConstructor<RLLinkMonitor> ()
+  ;
+  return tid;
+}
+
+RLLinkMonitor::RLLinkMonitor ()
+  : m_windowStart (Seconds (0)),
+    m_windowDuration (Seconds (0))
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RLLinkMonitor::~RLLinkMonitor ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+RLLinkMonitor::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_links.clear ();
+  Object::DoDispose ();
+}
+
+void
+RLLinkMonitor::Install (NodeContainer nodes, const std::vector<int> &adjacencyVec)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t nodeNum = nodes.GetN ();
+  NS_ASSERT_MSG (adjacencyVec.size () == nodeNum * nodeNum, "adjacency matrix does not match node number");
+
+  m_edges.clear ();
+  m_links.clear ();
+  // 与RLRoutingDB相同，src优先遍历邻接矩阵
+  for (uint32_t src = 0; src < nodeNum; src++)
+    {
+      Ptr<Node> srcNode = nodes.Get (src);
+      for (uint32_t dst = 0; dst < nodeNum; dst++)
+        {
+          if (adjacencyVec[src * nodeNum + dst] != 1)
+            {
+              continue;
+            }
+          Ptr<Node> dstNode = nodes.Get (dst);
+
+          // 查找src上对端为dst的device
+          Ptr<NetDevice> srcDevice = 0;
+          for (uint32_t deviceIndex = 0; deviceIndex < srcNode->GetNDevices (); deviceIndex++)
+            {
+              Ptr<NetDevice> device = srcNode->GetDevice (deviceIndex);
+              Ptr<Channel> channel = device->GetChannel ();
+              if (channel == 0 || channel->GetNDevices () != 2)
+                {
+                  continue;
+                }
+              Ptr<NetDevice> peerDevice =
+                  channel->GetDevice (0) == device ? channel->GetDevice (1) : channel->GetDevice (0);
+              if (peerDevice->GetNode () == dstNode)
+                {
+                  srcDevice = device;
+                  break;
+                }
+            }
+          if (srcDevice == 0)
+            {
+              NS_FATAL_ERROR ("RLLinkMonitor: no point-to-point link from node " << src << " to node " << dst);
+            }
+
+          PointerValue txQueue;
+          DataRateValue dataRate;
+          if (!srcDevice->GetAttributeFailSafe ("TxQueue", txQueue) ||
+              !srcDevice->GetAttributeFailSafe ("DataRate", dataRate))
+            {
+              NS_FATAL_ERROR ("RLLinkMonitor: device of link " << src << "->" << dst
+                              << " has no TxQueue or DataRate");
+            }
+
+          LinkState link;
+          link.queue = txQueue.Get<Queue<Packet> > ();
+          link.bitRate = dataRate.Get ().GetBitRate ();
+          link.queueLength = link.queue->GetNPackets ();
+          link.lastChange = Simulator::Now ();
+          link.queueIntegral = 0;
+          link.maxQueueLength = link.queueLength;
+          link.txBytes = 0;
+
+          uint32_t linkIndex = m_links.size ();
+          Ptr<RLLinkMonitor> monitor = this;
+          if (!link.queue->TraceConnectWithoutContext ("Enqueue",
+                                                       MakeBoundCallback (&RLLinkMonitor::QueueChangeLogger,
+                                                                          monitor, linkIndex)) ||
+              !link.queue->TraceConnectWithoutContext ("DropAfterDequeue",
+                                                       MakeBoundCallback (&RLLinkMonitor::QueueChangeLogger,
+                                                                          monitor, linkIndex)) ||
+              !link.queue->TraceConnectWithoutContext ("Dequeue",
+                                                       MakeBoundCallback (&RLLinkMonitor::DequeueLogger,
+                                                                          monitor, linkIndex)))
+            {
+              NS_FATAL_ERROR ("trace fail");
+            }
+          NS_LOG_LOGIC ("link " << linkIndex << ": " << src << "->" << dst
+                                << ", oif: " << srcDevice->GetIfIndex ()
+                                << ", rate: " << link.bitRate);
+
+          m_edges.push_back (Edge (src, dst));
+          m_links.push_back (link);
+        }
+    }
+
+  uint32_t linkNum = m_links.size ();
+  m_txBytes.assign (linkNum, 0);
+  m_utilization.assign (linkNum, 0);
+  m_avgQueueLength.assign (linkNum, 0);
+  m_maxQueueLength.assign (linkNum, 0);
+  m_windowStart = Simulator::Now ();
+  m_windowDuration = Seconds (0);
+}
+
+uint32_t
+RLLinkMonitor::GetNLinks () const
+{
+  return m_links.size ();
+}
+
+const std::vector<RLLinkMonitor::Edge>&
+RLLinkMonitor::GetEdges () const
+{
+  return m_edges;
+}
+
+void
+RLLinkMonitor::Snapshot ()
+{
+  NS_LOG_FUNCTION (this);
+  Time now = Simulator::Now ();
+  m_windowDuration = now - m_windowStart;
+  m_windowStart = now;
+  double window = m_windowDuration.GetSeconds ();
+
+  for (uint32_t index = 0; index < m_links.size (); index++)
+    {
+      LinkState &link = m_links[index];
+      UpdateQueueLength (link);
+
+      m_txBytes[index] = link.txBytes;
+      m_maxQueueLength[index] = link.maxQueueLength;
+      if (window > 0)
+        {
+          m_utilization[index] = link.bitRate > 0 ? link.txBytes * 8.0 / (link.bitRate * window) : 0;
+          m_avgQueueLength[index] = link.queueIntegral / window;
+        }
+      else
+        {
+          m_utilization[index] = 0;
+          m_avgQueueLength[index] = link.queueLength;
+        }
+
+      // 开始新窗口
+      link.queueIntegral = 0;
+      link.maxQueueLength = link.queueLength;
+      link.txBytes = 0;
+    }
+}
+
+Time
+RLLinkMonitor::GetWindowDuration () const
+{
+  return m_windowDuration;
+}
+
+const std::vector<uint64_t>&
+RLLinkMonitor::GetTxBytes () const
+{
+  return m_txBytes;
+}
+
+const std::vector<double>&
+RLLinkMonitor::GetUtilization () const
+{
+  return m_utilization;
+}
+
+const std::vector<double>&
+RLLinkMonitor::GetAverageQueueLength () const
+{
+  return m_avgQueueLength;
+}
+
+const std::vector<uint32_t>&
+RLLinkMonitor::GetMaxQueueLength () const
+{
+  return m_maxQueueLength;
+}
+
+void
+RLLinkMonitor::UpdateQueueLength (LinkState &link)
+{
+  Time now = Simulator::Now ();
+  link.queueIntegral += link.queueLength * (now - link.lastChange).GetSeconds ();
+  link.lastChange = now;
+  // trace触发时队列内部的计数已经更新
+  link.queueLength = link.queue->GetNPackets ();
+  if (link.queueLength > link.maxQueueLength)
+    {
+      link.maxQueueLength = link.queueLength;
+    }
+}
+
+void
+RLLinkMonitor::QueueChangeLogger (Ptr<RLLinkMonitor> monitor, uint32_t linkIndex, Ptr<const Packet> packet)
+{
+  UpdateQueueLength (monitor->m_links[linkIndex]);
+}
+
+void
+RLLinkMonitor::DequeueLogger (Ptr<RLLinkMonitor> monitor, uint32_t linkIndex, Ptr<const Packet> packet)
+{
+  LinkState &link = monitor->m_links[linkIndex];
+  UpdateQueueLength (link);
+  link.txBytes += packet->GetSize ();
+}
+
+} // namespace ns3
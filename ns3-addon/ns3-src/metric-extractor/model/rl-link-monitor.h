@@ -0,0 +1,126 @@
+/*
+ * @desc: 基于TxQueue入队/出队trace的链路利用率与平均队列长度统计
+ */
+
+#ifndef RL_LINK_MONITOR_H
+#define RL_LINK_MONITOR_H
+
+#include <vector>
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/node-container.h"
+#include "ns3/packet.h"
+#include "ns3/queue.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup flow-monitor
+ * \brief 统计每条有向链路的发送字节数、利用率和时间加权平均队列长度
+ *
+ * 链路按邻接矩阵的顺序编号：src从小到大，同一src内dst从小到大，
+ * 只包含邻接矩阵中值为1的边，与RLRoutingDB和各场景中动作的顺序一致。
+ * 每条链路对应src节点上通往dst的PointToPointNetDevice，连接其TxQueue的
+ * Enqueue/Dequeue/DropAfterDequeue trace：队列长度每次变化时累加
+ * “长度×持续时间”的积分，因此不需要为每条链路调度周期性的采样事件。
+ *
+ * 调用Snapshot时结束当前统计窗口，计算窗口内的各项指标并开始新窗口，
+ * 结果以按链路下标排列的数组形式给出。
+ */
+class RLLinkMonitor : public Object
+{
+public:
+  typedef std::pair<uint32_t, uint32_t> Edge; //!< 由src和dst节点标识的一条有向边
+
+  /// Register this type.
+  /// \return The TypeId.
+  static TypeId GetTypeId (void);
+
+  RLLinkMonitor ();
+  virtual ~RLLinkMonitor ();
+
+  /**
+   * @brief 按邻接矩阵在各链路的TxQueue上安装统计
+   *
+   * @param nodes 所有节点，下标即邻接矩阵中的节点编号
+   * @param adjacencyVec 展开为一维的邻接矩阵，长度为节点数的平方
+   */
+  void Install (NodeContainer nodes, const std::vector<int> &adjacencyVec);
+
+  /// \returns 链路数目
+  uint32_t GetNLinks () const;
+
+  /// \returns 各链路对应的有向边，下标即链路编号
+  const std::vector<Edge>& GetEdges () const;
+
+  /**
+   * @brief 结束当前统计窗口并开始新窗口
+   *
+   * 计算窗口内各链路的发送字节数、利用率、平均和最大队列长度，
+   * 之后可以通过Get*方法读取。
+   */
+  void Snapshot ();
+
+  /// \returns 上一个窗口的时长
+  Time GetWindowDuration () const;
+
+  /// \returns 上一个窗口内各链路从TxQueue出队（即开始发送）的字节数
+  const std::vector<uint64_t>& GetTxBytes () const;
+
+  /// \returns 上一个窗口内各链路的利用率：发送比特数 / (DataRate × 窗口时长)
+  const std::vector<double>& GetUtilization () const;
+
+  /// \returns 上一个窗口内各链路TxQueue的时间加权平均长度（包）
+  const std::vector<double>& GetAverageQueueLength () const;
+
+  /// \returns 上一个窗口内各链路TxQueue的最大长度（包）
+  const std::vector<uint32_t>& GetMaxQueueLength () const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// 一条链路的运行时状态
+  struct LinkState
+  {
+    Ptr<Queue<Packet> > queue; //!< 链路src端设备的TxQueue
+    double bitRate;            //!< 设备的DataRate（bit/s）
+    uint32_t queueLength;      //!< 最近一次变化后的队列长度
+    Time lastChange;           //!< 队列长度最近一次变化的时刻
+    double queueIntegral;      //!< 当前窗口内队列长度对时间（秒）的积分
+    uint32_t maxQueueLength;   //!< 当前窗口内的最大队列长度
+    uint64_t txBytes;          //!< 当前窗口内出队的字节数
+  };
+
+  /// 把队列长度积分推进到当前时刻，并读取新的队列长度
+  /// \param link the link state
+  static void UpdateQueueLength (LinkState &link);
+
+  /// TxQueue的Enqueue和DropAfterDequeue trace
+  /// \param monitor the link monitor
+  /// \param linkIndex index of the link
+  /// \param packet the packet
+  static void QueueChangeLogger (Ptr<RLLinkMonitor> monitor, uint32_t linkIndex, Ptr<const Packet> packet);
+
+  /// TxQueue的Dequeue trace
+  /// \param monitor the link monitor
+  /// \param linkIndex index of the link
+  /// \param packet the packet
+  static void DequeueLogger (Ptr<RLLinkMonitor> monitor, uint32_t linkIndex, Ptr<const Packet> packet);
+
+  std::vector<Edge> m_edges;       //!< 各链路对应的有向边
+  std::vector<LinkState> m_links;  //!< 各链路的运行时状态
+  Time m_windowStart;              //!< 当前窗口的开始时刻
+  Time m_windowDuration;           //!< 上一个窗口的时长
+
+  std::vector<uint64_t> m_txBytes;          //!< 上一个窗口的发送字节数
+  std::vector<double> m_utilization;        //!< 上一个窗口的利用率
+  std::vector<double> m_avgQueueLength;     //!< 上一个窗口的平均队列长度
+  std::vector<uint32_t> m_maxQueueLength;   //!< 上一个窗口的最大队列长度
+};
+
+} // namespace ns3
+
+#endif /* RL_LINK_MONITOR_H */
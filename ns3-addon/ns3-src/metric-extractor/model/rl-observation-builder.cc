@@ -0,0 +1,159 @@
+/*
+ * @desc: 直接从FlowMonitor的稠密计数生成逐step观测，写入调用者提供的缓冲区
+ */
+
+#include "ns3/rl-observation-builder.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/rl-flow-probe.h"
+#include "ns3/ipv4.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RLObservationBuilder");
+
+RLObservationBuilder::RLObservationBuilder ()
+  : m_source (NODE_PAIR_PACKETS),
+    m_nodeNum (0),
+    m_firstNodeId (0),
+    m_scale (1.0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RLObservationBuilder::~RLObservationBuilder ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+RLObservationBuilder::Setup (Ptr<FlowMonitor> monitor, Source source, uint32_t nodeNum, double scale,
+                             uint32_t firstNodeId)
+{
+  NS_LOG_FUNCTION (this << source << nodeNum << scale << firstNodeId);
+  m_monitor = monitor;
+  m_source = source;
+  m_nodeNum = nodeNum;
+  m_firstNodeId = firstNodeId;
+  m_scale = scale;
+  m_links.clear ();
+  m_current.assign (nodeNum * nodeNum, 0);
+  m_last.assign (nodeNum * nodeNum, 0);
+
+  uint32_t required = RLFlowProbe::METRIC_NODE_PAIR_TM;
+  if (source == LINK_TX_PACKETS || source == LINK_TX_BYTES)
+    {
+      required = RLFlowProbe::METRIC_QUEUE_STATS;
+    }
+  NS_ABORT_MSG_IF ((monitor->GetAvailableMetrics () & required) != required,
+                   "RLObservationBuilder: flow monitor probes do not provide the source counters");
+
+  if (required == RLFlowProbe::METRIC_QUEUE_STATS)
+    {
+      // 链路统计以probe的IPv4接口为下标，通过接口的device和信道找到对端节点
+      const FlowMonitor::FlowProbeContainer &probes = monitor->GetAllProbes ();
+      for (FlowMonitor::FlowProbeContainerCI iter = probes.begin (); iter != probes.end (); iter++)
+        {
+          Ptr<RLFlowProbe> probe = DynamicCast<RLFlowProbe> (*iter);
+          if (probe == 0)
+            {
+              continue;
+            }
+          uint32_t src = probe->GetNodeId () - firstNodeId;
+          Ptr<Ipv4> ipv4 = NodeList::GetNode (probe->GetNodeId ())->GetObject<Ipv4> ();
+          uint32_t nInterfaces = std::min<uint32_t> (ipv4->GetNInterfaces (), probe->GetLinkStats ().size ());
+          for (uint32_t interface = 0; interface < nInterfaces; interface++)
+            {
+              Ptr<NetDevice> device = ipv4->GetNetDevice (interface);
+              Ptr<Channel> channel = device->GetChannel ();
+              if (channel == 0 || channel->GetNDevices () != 2)
+                {
+                  continue;
+                }
+              Ptr<NetDevice> peerDevice =
+                  channel->GetDevice (0) == device ? channel->GetDevice (1) : channel->GetDevice (0);
+              // id小于firstNodeId时减法回绕，同样被跳过
+              uint32_t dst = peerDevice->GetNode ()->GetId () - firstNodeId;
+              if (src >= nodeNum || dst >= nodeNum)
+                {
+                  continue;
+                }
+              LinkSlot link;
+              link.probe = probe;
+              link.interface = interface;
+              link.index = src * nodeNum + dst;
+              m_links.push_back (link);
+              NS_LOG_LOGIC ("link " << src << "->" << dst << ", interface " << interface);
+            }
+        }
+    }
+
+  Rebase ();
+}
+
+uint32_t
+RLObservationBuilder::GetSize (void) const
+{
+  return m_nodeNum * m_nodeNum;
+}
+
+void
+RLObservationBuilder::Rebase (void)
+{
+  const uint64_t *current = Collect ();
+  std::copy (current, current + GetSize (), m_last.begin ());
+}
+
+const uint64_t*
+RLObservationBuilder::Collect (void)
+{
+  switch (m_source)
+    {
+    case NODE_PAIR_PACKETS:
+    case NODE_PAIR_BYTES:
+      {
+        const std::vector<uint64_t> &counts = m_source == NODE_PAIR_PACKETS ?
+                                              m_monitor->GetNodePairPackets () :
+                                              m_monitor->GetNodePairBytes ();
+        uint32_t countNodeNum = m_monitor->GetNodePairNodeNum ();
+        if (countNodeNum == m_nodeNum && m_firstNodeId == 0)
+          {
+            // 布局相同，直接使用FlowMonitor的矩阵
+            return counts.data ();
+          }
+        // 还没有统计任何包，或NodeList中有不参与观测的节点，取从m_firstNodeId开始的子矩阵
+        uint32_t nodeNum = countNodeNum > m_firstNodeId ? std::min (countNodeNum - m_firstNodeId, m_nodeNum) : 0;
+        for (uint32_t src = 0; src < nodeNum; src++)
+          {
+            uint32_t row = (m_firstNodeId + src) * countNodeNum + m_firstNodeId;
+            std::copy (counts.begin () + row,
+                       counts.begin () + row + nodeNum,
+                       m_current.begin () + src * m_nodeNum);
+          }
+        return m_current.data ();
+      }
+    case LINK_TX_PACKETS:
+      for (std::vector<LinkSlot>::const_iterator iter = m_links.begin (); iter != m_links.end (); iter++)
+        {
+          m_current[iter->index] = iter->probe->GetLinkStats ()[iter->interface].txPackets;
+        }
+      return m_current.data ();
+    case LINK_TX_BYTES:
+      for (std::vector<LinkSlot>::const_iterator iter = m_links.begin (); iter != m_links.end (); iter++)
+        {
+          m_current[iter->index] = iter->probe->GetLinkStats ()[iter->interface].txBytes;
+        }
+      return m_current.data ();
+    default:
+      NS_FATAL_ERROR ("RLObservationBuilder: unknown source " << m_source);
+    }
+  return m_current.data ();
+}
+
+} // namespace ns3
@@ -0,0 +1,112 @@
+/*
+ * @desc: 直接从FlowMonitor的稠密计数生成逐step观测，写入调用者提供的缓冲区
+ */
+
+#ifndef RL_OBSERVATION_BUILDER_H
+#define RL_OBSERVATION_BUILDER_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/assert.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class FlowMonitor;
+class RLFlowProbe;
+
+/**
+ * \ingroup flow-monitor
+ * \brief 把FlowMonitor的累计计数转换为逐step的N×N观测
+ *
+ * 观测的下标为 src * N + dst，取值为上一次Build以来计数的增量乘以scale。
+ * 计数来源可以是FlowMonitor按node对统计的TM，也可以是RLFlowProbe按出接口统计的
+ * 链路发送计数（按链路两端的节点放到矩阵中）。链路与矩阵下标的对应关系在Setup时
+ * 解析一次，之后每次Build只读一遍计数、在同一个循环中求增量和缩放，
+ * 直接写入调用者的缓冲区（如OpenEnvBoxContainer::GetRawData），不分配内存。
+ */
+class RLObservationBuilder
+{
+public:
+  /// 观测的计数来源
+  enum Source
+  {
+    NODE_PAIR_PACKETS = 0,  //!< 按node对统计的发送包数，需要METRIC_NODE_PAIR_TM
+    NODE_PAIR_BYTES,        //!< 按node对统计的发送字节数，需要METRIC_NODE_PAIR_TM
+    LINK_TX_PACKETS,        //!< 各链路从TxQueue发出的包数，需要METRIC_QUEUE_STATS
+    LINK_TX_BYTES           //!< 各链路从TxQueue发出的字节数，需要METRIC_QUEUE_STATS
+  };
+
+  RLObservationBuilder ();
+  ~RLObservationBuilder ();
+
+  /// 选择计数来源并解析链路，此时的计数作为第一个step的基准
+  /// \param monitor the FlowMonitor to read
+  /// \param source 计数来源
+  /// \param nodeNum 节点数N，观测的长度为N×N
+  /// \param scale 增量的缩放系数，用于归一化
+  /// \param firstNodeId 观测的第0个节点的node id，同一进程中有多个拓扑时为该拓扑第一个节点的id
+  void Setup (Ptr<FlowMonitor> monitor, Source source, uint32_t nodeNum, double scale = 1.0,
+              uint32_t firstNodeId = 0);
+
+  /// \returns 观测的长度N×N
+  uint32_t GetSize (void) const;
+
+  /// 把当前计数作为新的基准，下一次Build只包含此后的增量
+  void Rebase (void);
+
+  /// 生成一个step的观测
+  /// \param data 长度为GetSize()的缓冲区
+  /// \param size 缓冲区长度
+  template <typename T>
+  void Build (T *data, uint32_t size);
+
+private:
+  /// Defined and not implemented to avoid misuse
+  RLObservationBuilder (RLObservationBuilder const &);
+  /// Defined and not implemented to avoid misuse
+  /// \returns
+  RLObservationBuilder& operator= (RLObservationBuilder const &);
+
+  /// 一条链路：某个probe的出接口对应观测中的一个下标
+  struct LinkSlot
+  {
+    Ptr<RLFlowProbe> probe; //!< 链路源节点的probe
+    uint32_t interface;     //!< 出接口
+    uint32_t index;         //!< 观测中的下标 src * N + dst
+  };
+
+  /// 读取当前的累计计数
+  /// \returns 长度为N×N的计数
+  const uint64_t* Collect (void);
+
+  Ptr<FlowMonitor> m_monitor;       //!< 读取的FlowMonitor
+  Source m_source;                  //!< 计数来源
+  uint32_t m_nodeNum;               //!< 节点数
+  uint32_t m_firstNodeId;           //!< 第0个节点的node id
+  double m_scale;                   //!< 增量的缩放系数
+  std::vector<LinkSlot> m_links;    //!< 链路来源时的各链路
+  std::vector<uint64_t> m_current;  //!< 需要重新排列计数时使用的缓冲区
+  std::vector<uint64_t> m_last;     //!< 上一次Build时的计数
+};
+
+template <typename T>
+void
+RLObservationBuilder::Build (T *data, uint32_t size)
+{
+  NS_ASSERT_MSG (size == GetSize (), "observation buffer does not match N x N");
+  const uint64_t *current = Collect ();
+  uint64_t *last = m_last.data ();
+  double scale = m_scale;
+  for (uint32_t index = 0; index < size; index++)
+    {
+      uint64_t delta = current[index] - last[index];
+      last[index] = current[index];
+      data[index] = static_cast<T> (delta * scale);
+    }
+}
+
+} // namespace ns3
+
+#endif /* RL_OBSERVATION_BUILDER_H */
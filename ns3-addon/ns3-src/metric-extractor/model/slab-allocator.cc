@@ -0,0 +1,83 @@
+/*
+ * @desc: 按对象大小分slab分配的内存池，供FlowMonitor和FlowProbe的统计容器使用
+ */
+
+#include "ns3/slab-allocator.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+SlabPool::SlabPool (std::size_t objectSize, uint32_t objectsPerSlab)
+  : m_objectsPerSlab (objectsPerSlab),
+    m_freeList (0),
+    m_inUse (0)
+{
+  NS_ASSERT (objectsPerSlab > 0);
+  // 空闲时要能放下链表指针，并保持operator new的对齐
+  std::size_t align = alignof (std::max_align_t);
+  if (objectSize < sizeof (FreeNode))
+    {
+      objectSize = sizeof (FreeNode);
+    }
+  m_objectSize = (objectSize + align - 1) / align * align;
+}
+
+SlabPool::~SlabPool ()
+{
+  for (uint32_t index = 0; index < m_slabs.size (); index++)
+    {
+      ::operator delete (m_slabs[index]);
+    }
+  m_slabs.clear ();
+}
+
+void
+SlabPool::Grow (void)
+{
+  char *slab = static_cast<char *> (::operator new (m_objectSize * m_objectsPerSlab));
+  m_slabs.push_back (slab);
+  // 倒序挂到链表上，分配时按地址顺序取出
+  for (uint32_t index = m_objectsPerSlab; index > 0; index--)
+    {
+      FreeNode *node = reinterpret_cast<FreeNode *> (slab + (index - 1) * m_objectSize);
+      node->next = m_freeList;
+      m_freeList = node;
+    }
+}
+
+void*
+SlabPool::Allocate (void)
+{
+  if (m_freeList == 0)
+    {
+      Grow ();
+    }
+  FreeNode *node = m_freeList;
+  m_freeList = node->next;
+  m_inUse++;
+  return node;
+}
+
+void
+SlabPool::Deallocate (void *object)
+{
+  NS_ASSERT (m_inUse > 0);
+  FreeNode *node = static_cast<FreeNode *> (object);
+  node->next = m_freeList;
+  m_freeList = node;
+  m_inUse--;
+}
+
+uint64_t
+SlabPool::GetNInUse (void) const
+{
+  return m_inUse;
+}
+
+uint32_t
+SlabPool::GetNSlabs (void) const
+{
+  return m_slabs.size ();
+}
+
+} // namespace ns3
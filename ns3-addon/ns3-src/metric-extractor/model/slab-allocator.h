@@ -0,0 +1,144 @@
+/*
+ * @desc: 按对象大小分slab分配的内存池，供FlowMonitor和FlowProbe的统计容器使用
+ */
+
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup flow-monitor
+ * \brief 固定大小对象的slab内存池
+ *
+ * 每次向系统申请一整块（slab）可容纳objectsPerSlab个对象的内存，
+ * 释放的对象挂到空闲链表上，下次分配时优先复用。slab在进程结束前不会归还，
+ * 所以flow不断产生和淘汰时占用的内存只取决于同时存在的对象数的峰值，不会持续增长，
+ * 也避免了大量小对象反复new/delete造成的碎片。
+ *
+ * 不是线程安全的，只能在仿真线程中使用。
+ */
+class SlabPool
+{
+public:
+  /// \param objectSize 每个对象的字节数
+  /// \param objectsPerSlab 每个slab中的对象数
+  SlabPool (std::size_t objectSize, uint32_t objectsPerSlab);
+  ~SlabPool ();
+
+  /// \returns 一个对象大小的内存
+  void* Allocate (void);
+  /// \param object 由Allocate返回的内存
+  void Deallocate (void *object);
+
+  /// \returns 正在使用的对象数
+  uint64_t GetNInUse (void) const;
+  /// \returns 已申请的slab数
+  uint32_t GetNSlabs (void) const;
+
+private:
+  /// Defined and not implemented to avoid misuse
+  SlabPool (SlabPool const &);
+  /// Defined and not implemented to avoid misuse
+  /// \returns
+  SlabPool& operator= (SlabPool const &);
+
+  /// 空闲链表的节点，直接复用空闲对象的内存
+  struct FreeNode
+  {
+    FreeNode *next; //!< 下一个空闲对象
+  };
+
+  /// 申请一个新的slab，把其中的对象都挂到空闲链表上
+  void Grow (void);
+
+  std::size_t m_objectSize;     //!< 对齐后的对象大小
+  uint32_t m_objectsPerSlab;    //!< 每个slab中的对象数
+  FreeNode *m_freeList;         //!< 空闲链表
+  uint64_t m_inUse;             //!< 正在使用的对象数
+  std::vector<void *> m_slabs;  //!< 已申请的slab
+};
+
+/**
+ * \ingroup flow-monitor
+ * \brief 从SlabPool分配单个对象的STL分配器
+ *
+ * std::map、std::unordered_map的节点每次只分配一个，走各自类型的SlabPool；
+ * 一次分配多个对象（如unordered_map的桶数组）时直接使用operator new。
+ * 分配器本身没有状态，同一类型的所有容器共享一个SlabPool。
+ */
+template <typename T>
+class SlabAllocator
+{
+public:
+  typedef T value_type; //!< 分配的对象类型
+
+  /// 每个slab中的对象数
+  static const uint32_t OBJECTS_PER_SLAB = 256;
+
+  SlabAllocator ()
+  {
+  }
+  /// 用于rebind之间的转换
+  template <typename U>
+  SlabAllocator (const SlabAllocator<U> &)
+  {
+  }
+
+  /// \param n 对象数
+  /// \returns the allocated memory
+  T*
+  allocate (std::size_t n)
+  {
+    if (n != 1)
+      {
+        return static_cast<T *> (::operator new (n * sizeof (T)));
+      }
+    return static_cast<T *> (GetPool ().Allocate ());
+  }
+
+  /// \param object the memory returned by allocate
+  /// \param n 对象数
+  void
+  deallocate (T *object, std::size_t n)
+  {
+    if (n != 1)
+      {
+        ::operator delete (object);
+        return;
+      }
+    GetPool ().Deallocate (object);
+  }
+
+  /// \returns 该类型对象使用的SlabPool
+  static SlabPool&
+  GetPool (void)
+  {
+    // 故意不释放：容器可能在静态对象析构之后才被销毁
+    static SlabPool *pool = new SlabPool (sizeof (T), OBJECTS_PER_SLAB);
+    return *pool;
+  }
+};
+
+template <typename T, typename U>
+bool
+operator== (const SlabAllocator<T> &, const SlabAllocator<U> &)
+{
+  return true;
+}
+
+template <typename T, typename U>
+bool
+operator!= (const SlabAllocator<T> &, const SlabAllocator<U> &)
+{
+  return false;
+}
+
+} // namespace ns3
+
+#endif /* SLAB_ALLOCATOR_H */
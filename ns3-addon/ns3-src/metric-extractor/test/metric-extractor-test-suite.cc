@@ -0,0 +1,930 @@
+/*
+ * @desc: 测试metric-extractor中各统计组件是否按照预期工作
+ */
+
+// 测试metric-extractor中各统计组件是否按照预期工作。
+//
+// QuantileSketchTestCase 介绍
+//
+//      相对精度a = 0.01，取值范围[1e-6, 100]，插入0.001, 0.002, ..., 1.000共1000个值。
+//
+//      a. 测试空sketch:      没有插入值时任意分位数都为0，count为0；没有Configure的sketch也返回0
+//      b. 测试相对误差:      q = 0, 0.01, 0.5, 0.95, 0.99, 1时，估计值与排序后第floor(q*(n-1))个值
+//                            的相对误差不超过a
+//      c. 测试合并:          前500个值和后500个值分别插入两个sketch再合并，count为1000，
+//                            各分位数与直接插入全部值的sketch相同；合并到没有Configure的sketch等于复制
+//      d. 测试下限:          小于minValue的值计入0，只有这类值时分位数为0
+//
+// FlowSamplingTestCase 介绍
+//
+//      SamplingRate = 0.25，4个flow各发送4000个包（包长100~149），每个包都在同一个probe上报告发送和接收。
+//
+//      a. 测试采样决策:      同一个(flowId, packetId)多次判断、以及在另一个采样率相同的monitor上判断，
+//                            结果都相同；SamplingRate为1时全部采样，为0时全部不采样
+//      b. 测试原始计数:      GetFlowStats中各flow的收发包数、字节数等于被采样的包数、字节数
+//      c. 测试放大:          GetSamplingScale为4，GetEstimatedFlowStats中的计数等于原始计数乘以4，
+//                            且与真实值4000的偏差不超过10%
+//
+// FlowStatsWriterTestCase 介绍
+//
+//      flow 1发送并收到3个100字节的包，flow 2发送2个200字节的包、收到1个，写入step 0；
+//      flow 1再收发1个包后写入step 1。缓冲区设为64字节，写入过程中多次flush。
+//
+//      a. 测试文件头:        magic为"RLFS"，version为FlowStatsWriter::VERSION
+//      b. 测试step记录:      step编号、samplingScale、flow数和link数正确（测试probe不是RLFlowProbe，没有link项）
+//      c. 测试flow项:        flowId和收发包数、字节数与写入时FlowMonitor中的值相同
+//      d. 测试文件长度:      读完两个step后正好到达文件末尾
+//      e. 测试link项:        两个节点间用RLInstall安装的FlowMonitor以0.5的采样率统计，node 0向node 1发送10个包，
+//                            写入一个step；每个link项的packets/bytes应该等于对应RLFlowProbe的txPackets/txBytes，
+//                            node 0发出的包数不少于10（不受采样影响）
+//
+// FlowStatsPublisherTestCase 介绍
+//
+//      4个flow，仿真线程（测试主线程）每一轮给每个flow收发1个100字节的包后Publish一次，共2000轮；
+//      读线程在此期间不断ReadSnapshot。
+//
+//      a. 测试初始状态:      发布之前epoch为0，快照中没有flow
+//      b. 测试没有撕裂:      读线程读到的每个快照中，4个flow的txPackets相同且等于epoch，
+//                            txBytes等于100倍的txPackets；epoch不减小
+//      c. 测试序号:          结束后GetEpoch和最后一次读到的epoch都等于发布次数
+//      d. 测试截断:          容量为2个flow时只发布前2个flow，truncated为true
+//
+// NodePairTrafficMatrixTestCase 介绍
+//
+//      3个节点组成的链路 n0 -- n1 -- n2（SimpleNetDevice），全局路由，在所有节点上安装RLFlowProbe。
+//      各节点在9号端口上接收UDP，发送负载为100字节的UDP包（IP包长128字节）：
+//          n0 -> n2 3个包，n2 -> n1 2个包，n1 -> n0 1个包
+//
+//      a. 测试矩阵大小:      N等于节点数
+//      b. 测试TM:            src * N + dst处的包数和字节数与发送的相同，其他位置为0；
+//                            经过n1转发的n0 -> n2不会计入n1的行
+//      c. 测试flow对应:      每个flow都能O(1)查到发送和接收节点
+//
+// FlowEvictionTestCase 介绍
+//
+//      FlowIdleTimeout = 2s，DelayBinWidth = 0.01，启用分位数sketch，仿真到4.5s。
+//          flow 1: 0.1s起发送3个100字节的包，各在50ms后收到
+//          flow 2: 0.1s起发送2个200字节的包，第一个20ms后收到，第二个在0.25s被丢弃
+//          flow 3: 0.1s起每0.5s发送1个50字节的包，10ms后收到，一直持续到仿真结束
+//
+//      a. 测试构造:          属性设置之后才初始化汇总统计：sketch已配置，直方图使用DelayBinWidth
+//      b. 测试淘汰:          3s的周期检查淘汰flow 1和flow 2，flow 3仍然保留
+//      c. 测试守恒:          汇总统计与剩余flow统计之和等于报告过的收发包数、字节数、丢包数和时延和，
+//                            汇总的时延sketch包含被淘汰flow收到的所有包
+//
+#include "ns3/core-module.h"
+#include "ns3/test.h"
+#include "ns3/quantile-sketch.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+#include "ns3/flow-stats-writer.h"
+#include "ns3/flow-stats-publisher.h"
+#include "ns3/rl-flow-probe.h"
+#include "ns3/flow-monitor-helper.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("MetricExtractorTestSuite");
+
+/**
+ * \ingroup flow-monitor
+ * \ingroup tests
+ *
+ * \brief 用于检测QuantileSketch的误差界、合并和空sketch
+ */
+class QuantileSketchTestCase : public TestCase
+{
+public:
+  QuantileSketchTestCase ();
+  virtual void DoRun (void);
+};
+
+QuantileSketchTestCase::QuantileSketchTestCase () : TestCase ("QuantileSketchTestCase")
+{
+}
+
+void
+QuantileSketchTestCase::DoRun (void)
+{
+  const double accuracy = 0.01;
+  const uint32_t n = 1000;
+  const double qs[] = {0, 0.01, 0.5, 0.95, 0.99, 1};
+  std::vector<double> values;
+  for (uint32_t i = 1; i <= n; i++)
+    {
+      values.push_back (i * 0.001);
+    }
+
+  // 测试空sketch
+  QuantileSketch unconfigured;
+  NS_TEST_ASSERT_MSG_EQ (unconfigured.IsConfigured (), false, "Error: 默认构造的sketch不应该已经配置");
+  NS_TEST_ASSERT_MSG_EQ (unconfigured.GetQuantile (0.5), 0, "Error: 没有配置的sketch分位数应该为0");
+  QuantileSketch full (accuracy, 1e-6, 100);
+  NS_TEST_ASSERT_MSG_EQ (full.GetCount (), 0, "Error: 空sketch的count应该为0");
+  for (double q : qs)
+    {
+      NS_TEST_ASSERT_MSG_EQ (full.GetQuantile (q), 0, "Error: 空sketch的分位数应该为0");
+    }
+
+  // 测试相对误差
+  for (double value : values)
+    {
+      full.AddValue (value);
+    }
+  NS_TEST_ASSERT_MSG_EQ (full.GetCount (), n, "Error: count错误");
+  for (double q : qs)
+    {
+      double exact = values[static_cast<uint32_t> (q * (n - 1))];
+      double estimate = full.GetQuantile (q);
+      NS_TEST_ASSERT_MSG_EQ_TOL (estimate, exact, accuracy * exact,
+                                 "Error: q=" << q << "的相对误差超过" << accuracy);
+    }
+
+  // 测试合并
+  QuantileSketch low (accuracy, 1e-6, 100);
+  QuantileSketch high (accuracy, 1e-6, 100);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      (i < n / 2 ? low : high).AddValue (values[i]);
+    }
+  low.Merge (high);
+  NS_TEST_ASSERT_MSG_EQ (low.GetCount (), n, "Error: 合并后的count错误");
+  for (double q : qs)
+    {
+      NS_TEST_ASSERT_MSG_EQ (low.GetQuantile (q), full.GetQuantile (q),
+                             "Error: 合并后q=" << q << "的分位数与直接插入不一致");
+    }
+  unconfigured.Merge (full);
+  NS_TEST_ASSERT_MSG_EQ (unconfigured.IsConfigured (), true, "Error: 合并到没有配置的sketch应该复制配置");
+  NS_TEST_ASSERT_MSG_EQ (unconfigured.GetQuantile (0.99), full.GetQuantile (0.99), "Error: 合并到没有配置的sketch应该复制数据");
+
+  // 测试下限
+  QuantileSketch tiny (accuracy, 1e-6, 100);
+  tiny.AddValue (1e-9);
+  tiny.AddValue (-1);
+  NS_TEST_ASSERT_MSG_EQ (tiny.GetCount (), 2, "Error: 小于下限的值也要计数");
+  NS_TEST_ASSERT_MSG_EQ (tiny.GetQuantile (1), 0, "Error: 小于下限的值应该按0计");
+}
+
+/**
+ * \ingroup flow-monitor
+ * \ingroup tests
+ *
+ * \brief 直接向FlowMonitor报告包事件的probe，不挂接任何trace
+ */
+class MetricExtractorTestProbe : public FlowProbe
+{
+public:
+  MetricExtractorTestProbe (Ptr<FlowMonitor> monitor) : FlowProbe (monitor)
+  {
+  }
+};
+
+/**
+ * \ingroup flow-monitor
+ * \ingroup tests
+ *
+ * \brief 用于检测FlowMonitor的包采样和计数放大
+ */
+class FlowSamplingTestCase : public TestCase
+{
+public:
+  FlowSamplingTestCase ();
+  virtual void DoRun (void);
+};
+
+FlowSamplingTestCase::FlowSamplingTestCase () : TestCase ("FlowSamplingTestCase")
+{
+}
+
+void
+FlowSamplingTestCase::DoRun (void)
+{
+  const uint32_t nFlows = 4;
+  const uint32_t nPackets = 4000;
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  monitor->SetAttribute ("SamplingRate", DoubleValue (0.25));
+  Ptr<FlowMonitor> other = CreateObject<FlowMonitor> ();
+  other->SetAttribute ("SamplingRate", DoubleValue (0.25));
+  Ptr<FlowMonitor> all = CreateObject<FlowMonitor> ();
+  Ptr<FlowMonitor> none = CreateObject<FlowMonitor> ();
+  none->SetAttribute ("SamplingRate", DoubleValue (0.0));
+  NS_TEST_ASSERT_MSG_EQ_TOL (monitor->GetSamplingScale (), 4, 1e-12, "Error: 放大系数应该为1/SamplingRate");
+
+  Ptr<FlowProbe> probe = Create<MetricExtractorTestProbe> (monitor);
+  monitor->StartRightNow ();
+  std::vector<uint32_t> sampledPackets (nFlows + 1, 0);
+  std::vector<uint64_t> sampledBytes (nFlows + 1, 0);
+  for (uint32_t flowId = 1; flowId <= nFlows; flowId++)
+    {
+      for (uint32_t packetId = 0; packetId < nPackets; packetId++)
+        {
+          // 测试采样决策
+          bool sampled = monitor->IsSampled (flowId, packetId);
+          NS_TEST_ASSERT_MSG_EQ (monitor->IsSampled (flowId, packetId), sampled, "Error: 同一个包两次判断的结果不同");
+          NS_TEST_ASSERT_MSG_EQ (other->IsSampled (flowId, packetId), sampled, "Error: 采样率相同的monitor判断的结果不同");
+          NS_TEST_ASSERT_MSG_EQ (all->IsSampled (flowId, packetId), true, "Error: SamplingRate为1时应该全部采样");
+          NS_TEST_ASSERT_MSG_EQ (none->IsSampled (flowId, packetId), false, "Error: SamplingRate为0时不应该采样");
+
+          uint32_t packetSize = 100 + packetId % 50;
+          if (sampled)
+            {
+              sampledPackets[flowId]++;
+              sampledBytes[flowId] += packetSize;
+            }
+          monitor->ReportFirstTx (probe, flowId, packetId, packetSize);
+          monitor->ReportLastRx (probe, flowId, packetId, packetSize);
+        }
+    }
+
+  const FlowMonitor::FlowStatsContainer &stats = monitor->GetFlowStats ();
+  FlowMonitor::FlowStatsContainer estimated = monitor->GetEstimatedFlowStats ();
+  NS_TEST_ASSERT_MSG_EQ (stats.size (), nFlows, "Error: flow数目错误");
+  NS_TEST_ASSERT_MSG_EQ (estimated.size (), nFlows, "Error: 估计的flow数目错误");
+  for (uint32_t flowId = 1; flowId <= nFlows; flowId++)
+    {
+      // 测试原始计数
+      const FlowMonitor::FlowStats &raw = stats.find (flowId)->second;
+      NS_TEST_ASSERT_MSG_EQ (raw.txPackets, sampledPackets[flowId], "Error: flow " << flowId << "的发送包数应该等于采样的包数");
+      NS_TEST_ASSERT_MSG_EQ (raw.rxPackets, sampledPackets[flowId], "Error: flow " << flowId << "的接收包数应该等于采样的包数");
+      NS_TEST_ASSERT_MSG_EQ (raw.txBytes, sampledBytes[flowId], "Error: flow " << flowId << "的发送字节数应该等于采样的字节数");
+
+      // 测试放大
+      const FlowMonitor::FlowStats &scaled = estimated.find (flowId)->second;
+      NS_TEST_ASSERT_MSG_EQ (scaled.txPackets, sampledPackets[flowId] * 4, "Error: flow " << flowId << "的发送包数没有按1/SamplingRate放大");
+      NS_TEST_ASSERT_MSG_EQ (scaled.rxPackets, sampledPackets[flowId] * 4, "Error: flow " << flowId << "的接收包数没有按1/SamplingRate放大");
+      NS_TEST_ASSERT_MSG_EQ (scaled.txBytes, sampledBytes[flowId] * 4, "Error: flow " << flowId << "的发送字节数没有按1/SamplingRate放大");
+      NS_TEST_ASSERT_MSG_EQ (scaled.rxBytes, sampledBytes[flowId] * 4, "Error: flow " << flowId << "的接收字节数没有按1/SamplingRate放大");
+      NS_TEST_ASSERT_MSG_EQ_TOL (scaled.txPackets, nPackets, nPackets / 10, "Error: flow " << flowId << "的估计包数偏离真实值超过10%");
+    }
+
+  monitor->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup flow-monitor
+ * \ingroup tests
+ *
+ * \brief 用于检测FlowStatsWriter写出的文件能按格式读回
+ */
+class FlowStatsWriterTestCase : public TestCase
+{
+public:
+  FlowStatsWriterTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /// 按小端读取一个整数，并前移offset
+  /// \param offset 读取位置
+  /// \param size 字节数
+  /// \returns 读到的值
+  uint64_t Read (uint32_t &offset, uint32_t size);
+  /// 读回文件的全部内容到m_data
+  /// \param fileName 文件名
+  void Load (std::string fileName);
+  /// 发送一个UDP包
+  /// \param socket 已经connect的socket
+  /// \param size 负载字节数
+  void SendPacket (Ptr<Socket> socket, uint32_t size);
+  /// 测试flow项
+  void TestFlowRecords (void);
+  /// 测试link项
+  void TestLinkRecords (void);
+
+  std::vector<uint8_t> m_data; //!< 读回的文件内容
+};
+
+FlowStatsWriterTestCase::FlowStatsWriterTestCase () : TestCase ("FlowStatsWriterTestCase")
+{
+}
+
+uint64_t
+FlowStatsWriterTestCase::Read (uint32_t &offset, uint32_t size)
+{
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < size && offset + i < m_data.size (); i++)
+    {
+      value |= static_cast<uint64_t> (m_data[offset + i]) << (8 * i);
+    }
+  offset += size;
+  return value;
+}
+
+void
+FlowStatsWriterTestCase::Load (std::string fileName)
+{
+  std::ifstream file (fileName.c_str (), std::ios::binary);
+  m_data.assign (std::istreambuf_iterator<char> (file), std::istreambuf_iterator<char> ());
+}
+
+void
+FlowStatsWriterTestCase::SendPacket (Ptr<Socket> socket, uint32_t size)
+{
+  socket->Send (Create<Packet> (size));
+}
+
+void
+FlowStatsWriterTestCase::DoRun (void)
+{
+  TestFlowRecords ();
+  TestLinkRecords ();
+}
+
+void
+FlowStatsWriterTestCase::TestFlowRecords (void)
+{
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  Ptr<FlowProbe> probe = Create<MetricExtractorTestProbe> (monitor);
+  monitor->StartRightNow ();
+  for (uint32_t packetId = 0; packetId < 3; packetId++)
+    {
+      monitor->ReportFirstTx (probe, 1, packetId, 100);
+      monitor->ReportLastRx (probe, 1, packetId, 100);
+    }
+  monitor->ReportFirstTx (probe, 2, 0, 200);
+  monitor->ReportFirstTx (probe, 2, 1, 200);
+  monitor->ReportLastRx (probe, 2, 0, 200);
+
+  std::string fileName = CreateTempDirFilename ("flow-stats.bin");
+  FlowStatsWriter writer;
+  writer.Open (fileName, 64);
+  NS_TEST_ASSERT_MSG_EQ (writer.IsOpen (), true, "Error: 文件没有打开");
+  writer.WriteStep (0, monitor);
+  monitor->ReportFirstTx (probe, 1, 3, 100);
+  monitor->ReportLastRx (probe, 1, 3, 100);
+  writer.WriteStep (1, monitor);
+  writer.Close ();
+  NS_TEST_ASSERT_MSG_EQ (writer.IsOpen (), false, "Error: 文件没有关闭");
+
+  Load (fileName);
+
+  // 测试文件头
+  uint32_t offset = 0;
+  NS_TEST_ASSERT_MSG_EQ (m_data.size () >= 8 && std::memcmp (&m_data[0], "RLFS", 4) == 0, true, "Error: magic错误");
+  offset += 4;
+  NS_TEST_ASSERT_MSG_EQ (Read (offset, 2), FlowStatsWriter::VERSION, "Error: version错误");
+  offset += 2;
+
+  // 两个step中flow 1的累计包数分别为3和4，flow 2始终为发送2个、收到1个
+  const uint32_t flow1Packets[] = {3, 4};
+  for (uint32_t step = 0; step < 2; step++)
+    {
+      // 测试step记录
+      NS_TEST_ASSERT_MSG_EQ (Read (offset, 8), step, "Error: step编号错误");
+      offset += 8;
+      uint64_t scaleBits = Read (offset, 8);
+      double scale;
+      std::memcpy (&scale, &scaleBits, sizeof (scale));
+      NS_TEST_ASSERT_MSG_EQ (scale, 1.0, "Error: samplingScale错误");
+      NS_TEST_ASSERT_MSG_EQ (Read (offset, 4), 2, "Error: step " << step << "的flow数错误");
+      NS_TEST_ASSERT_MSG_EQ (Read (offset, 4), 0, "Error: step " << step << "不应该有link项");
+
+      // 测试flow项
+      NS_TEST_ASSERT_MSG_EQ (Read (offset, 4), 1, "Error: 第一个flow应该是flow 1");
+      NS_TEST_ASSERT_MSG_EQ (Read (offset, 4), flow1Packets[step], "Error: flow 1的txPackets错误");
+      NS_TEST_ASSERT_MSG_EQ (Read (offset, 4), flow1Packets[step], "Error: flow 1的rxPackets错误");
+      offset += 8;
+      NS_TEST_ASSERT_MSG_EQ (Read (offset, 8), flow1Packets[step] * 100, "Error: flow 1的txBytes错误");
+      NS_TEST_ASSERT_MSG_EQ (Read (offset, 8), flow1Packets[step] * 100, "Error: flow 1的rxBytes错误");
+      offset += 16;
+      NS_TEST_ASSERT_MSG_EQ (Read (offset, 4), 2, "Error: 第二个flow应该是flow 2");
+      NS_TEST_ASSERT_MSG_EQ (Read (offset, 4), 2, "Error: flow 2的txPackets错误");
+      NS_TEST_ASSERT_MSG_EQ (Read (offset, 4), 1, "Error: flow 2的rxPackets错误");
+      offset += 8;
+      NS_TEST_ASSERT_MSG_EQ (Read (offset, 8), 400, "Error: flow 2的txBytes错误");
+      NS_TEST_ASSERT_MSG_EQ (Read (offset, 8), 200, "Error: flow 2的rxBytes错误");
+      offset += 16;
+    }
+
+  // 测试文件长度
+  NS_TEST_ASSERT_MSG_EQ (offset, m_data.size (), "Error: 文件长度与写入的记录不符");
+
+  monitor->Dispose ();
+  Simulator::Destroy ();
+}
+
+void
+FlowStatsWriterTestCase::TestLinkRecords (void)
+{
+  const uint16_t port = 9;
+  const uint32_t nPackets = 10;
+  const uint32_t flowRecordSize = 5 * 4 + 4 * 8;
+  const uint32_t linkRecordSize = 4 * 4 + 6 * 8;
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  SimpleNetDeviceHelper deviceHelper;
+  NetDeviceContainer devices = deviceHelper.Install (nodes);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+
+  FlowMonitorHelper flowHelper;
+  flowHelper.SetMonitorAttribute ("SamplingRate", DoubleValue (0.5));
+  Ptr<FlowMonitor> monitor = flowHelper.RLInstall (nodes);
+
+  Ptr<Socket> sink = Socket::CreateSocket (nodes.Get (1), UdpSocketFactory::GetTypeId ());
+  sink->Bind (InetSocketAddress (Ipv4Address::GetAny (), port));
+  Ptr<Socket> socket = Socket::CreateSocket (nodes.Get (0), UdpSocketFactory::GetTypeId ());
+  socket->Connect (InetSocketAddress (interfaces.GetAddress (1), port));
+  for (uint32_t packet = 0; packet < nPackets; packet++)
+    {
+      Simulator::Schedule (Seconds (1 + 0.01 * packet), &FlowStatsWriterTestCase::SendPacket, this, socket, 100);
+    }
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  std::string fileName = CreateTempDirFilename ("flow-stats-links.bin");
+  FlowStatsWriter writer;
+  writer.Open (fileName);
+  writer.WriteStep (0, monitor);
+  writer.Close ();
+  Load (fileName);
+
+  // 跳过文件头和step头中的step、time，最后跳过flow项
+  uint32_t offset = 8 + 16;
+  uint64_t scaleBits = Read (offset, 8);
+  double scale;
+  std::memcpy (&scale, &scaleBits, sizeof (scale));
+  NS_TEST_ASSERT_MSG_EQ (scale, 2.0, "Error: 0.5的采样率下samplingScale应该为2");
+  uint32_t nFlows = Read (offset, 4);
+  uint32_t nLinks = Read (offset, 4);
+  offset += nFlows * flowRecordSize;
+
+  // link项按probe的顺序写出，每个probe按interface的顺序
+  uint32_t expectedLinks = 0;
+  uint64_t node0Packets = 0;
+  const FlowMonitor::FlowProbeContainer &probes = monitor->GetAllProbes ();
+  for (FlowMonitor::FlowProbeContainerCI iter = probes.begin (); iter != probes.end (); iter++)
+    {
+      Ptr<RLFlowProbe> probe = DynamicCast<RLFlowProbe> (*iter);
+      NS_TEST_ASSERT_MSG_NE (probe, 0, "Error: RLInstall应该安装RLFlowProbe");
+      const RLFlowProbe::LinkStatsContainer &links = probe->GetLinkStats ();
+      for (uint32_t interface = 0; interface < links.size (); interface++)
+        {
+          expectedLinks++;
+          if (offset + linkRecordSize > m_data.size ())
+            {
+              continue;
+            }
+          NS_TEST_ASSERT_MSG_EQ (Read (offset, 4), probe->GetNodeId (), "Error: link项的nodeId错误");
+          NS_TEST_ASSERT_MSG_EQ (Read (offset, 4), interface, "Error: link项的interface错误");
+          uint64_t packets = Read (offset, 8);
+          NS_TEST_ASSERT_MSG_EQ (packets, links[interface].txPackets,
+                                 "Error: node " << probe->GetNodeId () << " interface " << interface << "的packets错误");
+          NS_TEST_ASSERT_MSG_EQ (Read (offset, 8), links[interface].txBytes,
+                                 "Error: node " << probe->GetNodeId () << " interface " << interface << "的bytes错误");
+          offset += linkRecordSize - 24;
+          if (probe->GetNodeId () == nodes.Get (0)->GetId ())
+            {
+              node0Packets += packets;
+            }
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (nLinks, expectedLinks, "Error: link数错误");
+  NS_TEST_ASSERT_MSG_EQ (node0Packets >= nPackets, true, "Error: link项的packets应该包括没有被采样的包");
+  NS_TEST_ASSERT_MSG_EQ (offset, m_data.size (), "Error: 文件长度与写入的记录不符");
+
+  monitor->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup flow-monitor
+ * \ingroup tests
+ *
+ * \brief 用于检测FlowStatsPublisher在并发读取时不会读到撕裂的快照
+ */
+class FlowStatsPublisherTestCase : public TestCase
+{
+public:
+  FlowStatsPublisherTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /// 读线程：不断读取快照并检查一致性，直到m_done被置位
+  /// \param publisher the publisher to read
+  void ReadLoop (const FlowStatsPublisher *publisher);
+
+  std::atomic<bool> m_done;         //!< 仿真线程是否已经发布完
+  std::atomic<uint32_t> m_reads;    //!< 读到的一致快照数
+  std::atomic<uint32_t> m_torn;     //!< 内容不一致的快照数
+  std::atomic<uint32_t> m_backward; //!< epoch减小的次数
+};
+
+FlowStatsPublisherTestCase::FlowStatsPublisherTestCase ()
+    : TestCase ("FlowStatsPublisherTestCase"), m_done (false), m_reads (0), m_torn (0), m_backward (0)
+{
+}
+
+void
+FlowStatsPublisherTestCase::ReadLoop (const FlowStatsPublisher *publisher)
+{
+  // 测试框架的断言不是线程安全的，读线程只计数，由主线程检查
+  FlowStatsPublisher::Snapshot snapshot;
+  uint64_t lastEpoch = 0;
+  while (!m_done.load ())
+    {
+      if (!publisher->ReadSnapshot (snapshot))
+        {
+          continue;
+        }
+      m_reads++;
+      if (snapshot.epoch < lastEpoch)
+        {
+          m_backward++;
+        }
+      lastEpoch = snapshot.epoch;
+      for (uint32_t index = 0; index < snapshot.flows.size (); index++)
+        {
+          const FlowStatsPublisher::FlowRecord &flow = snapshot.flows[index];
+          if (flow.txPackets != snapshot.epoch || flow.txBytes != flow.txPackets * 100)
+            {
+              m_torn++;
+              break;
+            }
+        }
+    }
+}
+
+void
+FlowStatsPublisherTestCase::DoRun (void)
+{
+  const uint32_t nFlows = 4;
+  const uint32_t nRounds = 2000;
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  Ptr<FlowProbe> probe = Create<MetricExtractorTestProbe> (monitor);
+  monitor->StartRightNow ();
+  FlowStatsPublisher publisher (nFlows, 0);
+
+  // 测试初始状态
+  FlowStatsPublisher::Snapshot snapshot;
+  NS_TEST_ASSERT_MSG_EQ (publisher.GetEpoch (), 0, "Error: 发布之前epoch应该为0");
+  NS_TEST_ASSERT_MSG_EQ (publisher.ReadSnapshot (snapshot), true, "Error: 发布之前也应该能读到快照");
+  NS_TEST_ASSERT_MSG_EQ (snapshot.epoch, 0, "Error: 发布之前快照的epoch应该为0");
+  NS_TEST_ASSERT_MSG_EQ (snapshot.flows.size (), 0, "Error: 发布之前快照中不应该有flow");
+
+  // 测试没有撕裂
+  std::thread reader (&FlowStatsPublisherTestCase::ReadLoop, this, &publisher);
+  for (uint32_t round = 0; round < nRounds; round++)
+    {
+      for (uint32_t flowId = 1; flowId <= nFlows; flowId++)
+        {
+          monitor->ReportFirstTx (probe, flowId, round, 100);
+          monitor->ReportLastRx (probe, flowId, round, 100);
+        }
+      publisher.Publish (monitor);
+    }
+  m_done.store (true);
+  reader.join ();
+  NS_TEST_ASSERT_MSG_EQ (m_torn.load (), 0, "Error: 读到了" << m_torn.load () << "个不一致的快照");
+  NS_TEST_ASSERT_MSG_EQ (m_backward.load (), 0, "Error: 读到的epoch减小了");
+  NS_TEST_ASSERT_MSG_GT (m_reads.load (), 0, "Error: 读线程没有读到任何快照");
+
+  // 测试序号
+  NS_TEST_ASSERT_MSG_EQ (publisher.GetEpoch (), nRounds, "Error: epoch应该等于发布次数");
+  NS_TEST_ASSERT_MSG_EQ (publisher.ReadSnapshot (snapshot), true, "Error: 没有并发写入时应该能读到快照");
+  NS_TEST_ASSERT_MSG_EQ (snapshot.epoch, nRounds, "Error: 最后读到的epoch应该等于发布次数");
+  NS_TEST_ASSERT_MSG_EQ (snapshot.flows.size (), nFlows, "Error: 快照中的flow数错误");
+  NS_TEST_ASSERT_MSG_EQ (snapshot.truncated, false, "Error: 容量足够时不应该截断");
+  NS_TEST_ASSERT_MSG_EQ (snapshot.flows[nFlows - 1].rxPackets, nRounds, "Error: 快照中的rxPackets错误");
+
+  // 测试截断
+  FlowStatsPublisher small (2, 0);
+  small.Publish (monitor);
+  NS_TEST_ASSERT_MSG_EQ (small.ReadSnapshot (snapshot), true, "Error: 没有并发写入时应该能读到快照");
+  NS_TEST_ASSERT_MSG_EQ (snapshot.truncated, true, "Error: 超出容量时应该标记截断");
+  NS_TEST_ASSERT_MSG_EQ (snapshot.flows.size (), 2, "Error: 只应该发布容量内的flow");
+  NS_TEST_ASSERT_MSG_EQ (snapshot.flows[1].flowId, 2, "Error: 应该按FlowId顺序发布");
+
+  monitor->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup flow-monitor
+ * \ingroup tests
+ *
+ * \brief 用于检测在已知拓扑上按node对统计的TM
+ */
+class NodePairTrafficMatrixTestCase : public TestCase
+{
+public:
+  NodePairTrafficMatrixTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /// 发送一个负载为size字节的包
+  /// \param socket the sending socket
+  /// \param size payload size
+  void SendPacket (Ptr<Socket> socket, uint32_t size);
+};
+
+NodePairTrafficMatrixTestCase::NodePairTrafficMatrixTestCase () : TestCase ("NodePairTrafficMatrixTestCase")
+{
+}
+
+void
+NodePairTrafficMatrixTestCase::SendPacket (Ptr<Socket> socket, uint32_t size)
+{
+  socket->Send (Create<Packet> (size));
+}
+
+void
+NodePairTrafficMatrixTestCase::DoRun (void)
+{
+  const uint16_t port = 9;
+  const uint32_t payloadSize = 100;
+  const uint32_t packetSize = payloadSize + 8 + 20; // UDP头和IPv4头
+
+  NodeContainer nodes;
+  nodes.Create (3);
+  SimpleNetDeviceHelper deviceHelper;
+  NetDeviceContainer devices01 = deviceHelper.Install (NodeContainer (nodes.Get (0), nodes.Get (1)));
+  NetDeviceContainer devices12 = deviceHelper.Install (NodeContainer (nodes.Get (1), nodes.Get (2)));
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces01 = address.Assign (devices01);
+  address.SetBase ("10.1.2.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces12 = address.Assign (devices12);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  FlowMonitorHelper flowHelper;
+  Ptr<FlowMonitor> monitor = flowHelper.RLInstall (nodes);
+
+  // 每个节点在port上接收，避免目的端口不可达
+  for (uint32_t index = 0; index < nodes.GetN (); index++)
+    {
+      Ptr<Socket> sink = Socket::CreateSocket (nodes.Get (index), UdpSocketFactory::GetTypeId ());
+      sink->Bind (InetSocketAddress (Ipv4Address::GetAny (), port));
+    }
+
+  // 一组发送：源节点下标、目的地址、目的节点下标和包数
+  struct Traffic
+  {
+    uint32_t src;
+    Ipv4Address dstAddress;
+    uint32_t dst;
+    uint32_t packets;
+  };
+  const Traffic traffics[] = {
+    {0, interfaces12.GetAddress (1), 2, 3},
+    {2, interfaces12.GetAddress (0), 1, 2},
+    {1, interfaces01.GetAddress (0), 0, 1},
+  };
+  for (uint32_t index = 0; index < 3; index++)
+    {
+      const Traffic &traffic = traffics[index];
+      Ptr<Socket> socket = Socket::CreateSocket (nodes.Get (traffic.src), UdpSocketFactory::GetTypeId ());
+      socket->Connect (InetSocketAddress (traffic.dstAddress, port));
+      for (uint32_t packet = 0; packet < traffic.packets; packet++)
+        {
+          Simulator::Schedule (Seconds (1 + 0.1 * index + 0.01 * packet),
+                               &NodePairTrafficMatrixTestCase::SendPacket, this, socket, payloadSize);
+        }
+    }
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+
+  // 测试矩阵大小
+  uint32_t nodeNum = monitor->GetNodePairNodeNum ();
+  NS_TEST_ASSERT_MSG_EQ (nodeNum, NodeList::GetNNodes (), "Error: TM的边长应该等于节点数");
+
+  // 测试TM
+  std::vector<uint64_t> expectedPackets (nodeNum * nodeNum, 0);
+  for (uint32_t index = 0; index < 3; index++)
+    {
+      const Traffic &traffic = traffics[index];
+      uint32_t srcId = nodes.Get (traffic.src)->GetId ();
+      uint32_t dstId = nodes.Get (traffic.dst)->GetId ();
+      expectedPackets[srcId * nodeNum + dstId] = traffic.packets;
+    }
+  const std::vector<uint64_t> &packets = monitor->GetNodePairPackets ();
+  const std::vector<uint64_t> &bytes = monitor->GetNodePairBytes ();
+  NS_TEST_ASSERT_MSG_EQ (packets.size (), nodeNum * nodeNum, "Error: 包数TM的大小错误");
+  NS_TEST_ASSERT_MSG_EQ (bytes.size (), nodeNum * nodeNum, "Error: 字节数TM的大小错误");
+  for (uint32_t src = 0; src < nodeNum; src++)
+    {
+      for (uint32_t dst = 0; dst < nodeNum; dst++)
+        {
+          uint32_t index = src * nodeNum + dst;
+          NS_TEST_ASSERT_MSG_EQ (packets[index], expectedPackets[index],
+                                 "Error: " << src << " -> " << dst << "的包数错误");
+          NS_TEST_ASSERT_MSG_EQ (bytes[index], expectedPackets[index] * packetSize,
+                                 "Error: " << src << " -> " << dst << "的字节数错误");
+        }
+    }
+
+  // 测试flow对应
+  const FlowMonitor::FlowStatsContainer &stats = monitor->GetFlowStats ();
+  NS_TEST_ASSERT_MSG_EQ (stats.size (), 3, "Error: 应该有3个flow");
+  for (FlowMonitor::FlowStatsContainerCI iter = stats.begin (); iter != stats.end (); iter++)
+    {
+      FlowMonitor::NodePair pair;
+      NS_TEST_ASSERT_MSG_EQ (monitor->GetFlowNodePair (iter->first, pair), true,
+                             "Error: flow " << iter->first << "没有对应的node对");
+      NS_TEST_ASSERT_MSG_EQ (expectedPackets[pair.first * nodeNum + pair.second], iter->second.txPackets,
+                             "Error: flow " << iter->first << "对应的node对错误");
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup flow-monitor
+ * \ingroup tests
+ *
+ * \brief 用于检测淘汰空闲flow时统计守恒
+ */
+class FlowEvictionTestCase : public TestCase
+{
+public:
+  FlowEvictionTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /// 报告一个包的发送，并在delay之后报告接收或丢包
+  /// \param flowId flow identification
+  /// \param packetId packet identification
+  /// \param size packet size
+  /// \param delay 接收（或丢包）相对发送的时间
+  /// \param lost 是否被丢弃
+  void Transmit (uint32_t flowId, uint32_t packetId, uint32_t size, Time delay, bool lost);
+  /// 报告一个包的接收
+  /// \param flowId flow identification
+  /// \param packetId packet identification
+  /// \param size packet size
+  void Receive (uint32_t flowId, uint32_t packetId, uint32_t size);
+  /// 报告一个包被丢弃
+  /// \param flowId flow identification
+  /// \param packetId packet identification
+  /// \param size packet size
+  void Drop (uint32_t flowId, uint32_t packetId, uint32_t size);
+
+  Ptr<FlowMonitor> m_monitor; //!< 被测试的FlowMonitor
+  Ptr<FlowProbe> m_probe;     //!< 报告包事件的probe
+  uint32_t m_txPackets;       //!< 报告过的发送包数
+  uint32_t m_rxPackets;       //!< 报告过的接收包数
+  uint32_t m_lostPackets;     //!< 报告过的丢包数
+  uint64_t m_txBytes;         //!< 报告过的发送字节数
+  uint64_t m_rxBytes;         //!< 报告过的接收字节数
+  Time m_delaySum;            //!< 收到的包的时延和
+};
+
+FlowEvictionTestCase::FlowEvictionTestCase ()
+    : TestCase ("FlowEvictionTestCase"),
+      m_txPackets (0),
+      m_rxPackets (0),
+      m_lostPackets (0),
+      m_txBytes (0),
+      m_rxBytes (0)
+{
+}
+
+void
+FlowEvictionTestCase::Transmit (uint32_t flowId, uint32_t packetId, uint32_t size, Time delay, bool lost)
+{
+  m_monitor->ReportFirstTx (m_probe, flowId, packetId, size);
+  m_txPackets++;
+  m_txBytes += size;
+  if (lost)
+    {
+      Simulator::Schedule (delay, &FlowEvictionTestCase::Drop, this, flowId, packetId, size);
+    }
+  else
+    {
+      m_delaySum += delay;
+      Simulator::Schedule (delay, &FlowEvictionTestCase::Receive, this, flowId, packetId, size);
+    }
+}
+
+void
+FlowEvictionTestCase::Receive (uint32_t flowId, uint32_t packetId, uint32_t size)
+{
+  m_monitor->ReportLastRx (m_probe, flowId, packetId, size);
+  m_rxPackets++;
+  m_rxBytes += size;
+}
+
+void
+FlowEvictionTestCase::Drop (uint32_t flowId, uint32_t packetId, uint32_t size)
+{
+  m_monitor->ReportDrop (m_probe, flowId, packetId, size, 0);
+  m_lostPackets++;
+}
+
+void
+FlowEvictionTestCase::DoRun (void)
+{
+  const double binWidth = 0.01;
+  ObjectFactory factory;
+  factory.SetTypeId ("ns3::FlowMonitor");
+  factory.Set ("FlowIdleTimeout", TimeValue (Seconds (2)));
+  factory.Set ("DelayBinWidth", DoubleValue (binWidth));
+  factory.Set ("EnableQuantileSketches", BooleanValue (true));
+  m_monitor = factory.Create<FlowMonitor> ();
+  m_probe = Create<MetricExtractorTestProbe> (m_monitor);
+
+  // 测试构造
+  Histogram histogram = m_monitor->GetEvictedFlowStats ().delayHistogram;
+  histogram.AddValue (0.5 * binWidth);
+  NS_TEST_ASSERT_MSG_EQ (histogram.GetNBins (), 1, "Error: 汇总统计的直方图没有使用DelayBinWidth");
+  NS_TEST_ASSERT_MSG_EQ_TOL (histogram.GetBinWidth (0), binWidth, 1e-12, "Error: 汇总统计的直方图宽度错误");
+  NS_TEST_ASSERT_MSG_EQ (m_monitor->GetEvictedFlowStats ().delaySketch.IsConfigured (), true,
+                         "Error: 启用sketch时汇总统计的sketch应该已经配置");
+
+  for (uint32_t packetId = 0; packetId < 3; packetId++)
+    {
+      Simulator::Schedule (Seconds (0.1 * (packetId + 1)), &FlowEvictionTestCase::Transmit, this,
+                           1, packetId, 100, MilliSeconds (50), false);
+    }
+  Simulator::Schedule (Seconds (0.1), &FlowEvictionTestCase::Transmit, this, 2, 0, 200, MilliSeconds (20), false);
+  Simulator::Schedule (Seconds (0.2), &FlowEvictionTestCase::Transmit, this, 2, 1, 200, MilliSeconds (50), true);
+  for (uint32_t packetId = 0; packetId < 9; packetId++)
+    {
+      Simulator::Schedule (Seconds (0.1 + 0.5 * packetId), &FlowEvictionTestCase::Transmit, this,
+                           3, packetId, 50, MilliSeconds (10), false);
+    }
+  Simulator::Stop (Seconds (4.5));
+  Simulator::Run ();
+
+  // 测试淘汰
+  const FlowMonitor::FlowStatsContainer &flowStats = m_monitor->GetFlowStats ();
+  NS_TEST_ASSERT_MSG_EQ (m_monitor->GetNEvictedFlows (), 2, "Error: 应该淘汰2个flow");
+  NS_TEST_ASSERT_MSG_EQ (flowStats.size (), 1, "Error: 应该只剩下1个flow");
+  NS_TEST_ASSERT_MSG_EQ ((flowStats.find (3) != flowStats.end ()), true, "Error: 仍然活跃的flow 3不应该被淘汰");
+
+  // 测试守恒
+  const FlowMonitor::FlowStats &evicted = m_monitor->GetEvictedFlowStats ();
+  uint32_t txPackets = evicted.txPackets;
+  uint32_t rxPackets = evicted.rxPackets;
+  uint32_t lostPackets = evicted.lostPackets;
+  uint64_t txBytes = evicted.txBytes;
+  uint64_t rxBytes = evicted.rxBytes;
+  Time delaySum = evicted.delaySum;
+  for (FlowMonitor::FlowStatsContainerCI iter = flowStats.begin (); iter != flowStats.end (); iter++)
+    {
+      txPackets += iter->second.txPackets;
+      rxPackets += iter->second.rxPackets;
+      lostPackets += iter->second.lostPackets;
+      txBytes += iter->second.txBytes;
+      rxBytes += iter->second.rxBytes;
+      delaySum += iter->second.delaySum;
+    }
+  NS_TEST_ASSERT_MSG_EQ (txPackets, m_txPackets, "Error: 发送包数不守恒");
+  NS_TEST_ASSERT_MSG_EQ (rxPackets, m_rxPackets, "Error: 接收包数不守恒");
+  NS_TEST_ASSERT_MSG_EQ (lostPackets, m_lostPackets, "Error: 丢包数不守恒");
+  NS_TEST_ASSERT_MSG_EQ (txBytes, m_txBytes, "Error: 发送字节数不守恒");
+  NS_TEST_ASSERT_MSG_EQ (rxBytes, m_rxBytes, "Error: 接收字节数不守恒");
+  NS_TEST_ASSERT_MSG_EQ (delaySum, m_delaySum, "Error: 时延和不守恒");
+  NS_TEST_ASSERT_MSG_EQ (evicted.txPackets, 5, "Error: 被淘汰flow的发送包数错误");
+  NS_TEST_ASSERT_MSG_EQ (evicted.bytesDropped.size () > 0 && evicted.bytesDropped[0] == 200, true,
+                         "Error: 被淘汰flow的丢包字节数错误");
+  NS_TEST_ASSERT_MSG_EQ (evicted.delaySketch.GetCount (), evicted.rxPackets,
+                         "Error: 汇总的sketch应该包含被淘汰flow收到的所有包");
+
+  m_monitor->Dispose ();
+  m_monitor = 0;
+  m_probe = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup flow-monitor
+ * \ingroup tests
+ *
+ * \brief metric-extractor TestSuite
+ */
+class MetricExtractorTestSuite : public TestSuite
+{
+public:
+  MetricExtractorTestSuite ();
+};
+
+MetricExtractorTestSuite::MetricExtractorTestSuite ()
+    : TestSuite ("metric-extractor", UNIT)
+{
+  AddTestCase (new QuantileSketchTestCase (), TestCase::QUICK);
+  AddTestCase (new FlowSamplingTestCase (), TestCase::QUICK);
+  AddTestCase (new FlowStatsWriterTestCase (), TestCase::QUICK);
+  AddTestCase (new FlowStatsPublisherTestCase (), TestCase::QUICK);
+  AddTestCase (new NodePairTrafficMatrixTestCase (), TestCase::QUICK);
+  AddTestCase (new FlowEvictionTestCase (), TestCase::QUICK);
+}
+
+static MetricExtractorTestSuite g_metricExtractorTestSuite; //!< Static variable for test initialization
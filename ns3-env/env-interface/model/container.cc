@@ -61,6 +61,65 @@ OpenEnvDataContainer::DoInitialize (void)
   //NS_LOG_FUNCTION (this);
 }
 
+bool
+OpenEnvDataContainer::GetRawBuffer(const void **data, uint32_t *bytes, ns3openenv::Dtype *dtype, uint32_t *elementSize)
+{
+  return false;
+}
+
+bool
+OpenEnvDataContainer::SetFromRawBuffer(ns3openenv::Dtype dtype, uint32_t elementSize, const void *data, uint32_t bytes)
+{
+  return false;
+}
+
+uint32_t
+OpenEnvDataContainer::GetRawElementSize(ns3openenv::Dtype dtype)
+{
+  return dtype == ns3openenv::DOUBLE ? sizeof(double) : sizeof(float);
+}
+
+template <typename T>
+static Ptr<OpenEnvDataContainer>
+CreateBoxFromRawBuffer(ns3openenv::Dtype dtype, const void *data, uint32_t bytes, const std::vector<uint32_t> &shape)
+{
+  Ptr<OpenEnvBoxContainer<T> > box = CreateObject<OpenEnvBoxContainer<T> >(shape);
+  box->SetFromRawBuffer(dtype, sizeof(T), data, bytes);
+  return box;
+}
+
+Ptr<OpenEnvDataContainer>
+OpenEnvDataContainer::CreateFromRawBuffer(ns3openenv::Dtype dtype, uint32_t elementSize, const void *data, uint32_t bytes,
+                                          const std::vector<uint32_t> &shape)
+{
+  // 与CreateFromDataContainerPbMsg中各dtype使用的类型一致
+  if (dtype == ns3openenv::INT && elementSize == sizeof(int32_t)) {
+    return CreateBoxFromRawBuffer<int32_t>(dtype, data, bytes, shape);
+  } else if (dtype == ns3openenv::UINT && elementSize == sizeof(uint32_t)) {
+    return CreateBoxFromRawBuffer<uint32_t>(dtype, data, bytes, shape);
+  } else if (dtype == ns3openenv::FLOAT && elementSize == sizeof(float)) {
+    return CreateBoxFromRawBuffer<float>(dtype, data, bytes, shape);
+  } else if (dtype == ns3openenv::DOUBLE && elementSize == sizeof(double)) {
+    return CreateBoxFromRawBuffer<double>(dtype, data, bytes, shape);
+  }
+  NS_LOG_WARN("Unsupported raw buffer, dtype: " << dtype << ", element size: " << elementSize);
+  return 0;
+}
+
+Ptr<OpenEnvDataContainer>
+OpenEnvDataContainer::CreateFromRawBoxPbMsg(const ns3openenv::RawBoxContainer &rawBoxPbMsg)
+{
+  return CreateFromRawBuffer(rawBoxPbMsg.dtype(), GetRawElementSize(rawBoxPbMsg.dtype()),
+                             rawBoxPbMsg.data().data(), rawBoxPbMsg.data().size());
+}
+
+const std::vector<uint32_t>&
+OpenEnvDataContainer::GetShape()
+{
+  static const std::vector<uint32_t> noShape;
+  return noShape;
+}
+
 Ptr<OpenEnvDataContainer>
 OpenEnvDataContainer::CreateFromDataContainerPbMsg(ns3openenv::DataContainer &dataContainerPbMsg)
 {
@@ -25,6 +25,7 @@
 #include "ns3/object.h"
 #include "ns3/type-name.h"
 #include "messages.pb.h"
+#include <cstring>
 
 namespace ns3 {
 
@@ -39,6 +40,19 @@ public:
   virtual ns3openenv::DataContainer GetDataContainerPbMsg() = 0;
   static Ptr<OpenEnvDataContainer> CreateFromDataContainerPbMsg(ns3openenv::DataContainer &dataContainer);
 
+  // 能以连续的原始数组传输时返回true（目前只有Box），共享内存传输用它代替protobuf的repeated字段
+  virtual bool GetRawBuffer(const void **data, uint32_t *bytes, ns3openenv::Dtype *dtype, uint32_t *elementSize);
+  // 由原始数组创建Box，不支持的dtype/元素大小返回0
+  static Ptr<OpenEnvDataContainer> CreateFromRawBuffer(ns3openenv::Dtype dtype, uint32_t elementSize, const void *data, uint32_t bytes,
+                                                       const std::vector<uint32_t> &shape = std::vector<uint32_t>());
+  static Ptr<OpenEnvDataContainer> CreateFromRawBoxPbMsg(const ns3openenv::RawBoxContainer &rawBoxPbMsg);
+  // 用原始数组原地更新容器（不重新分配），dtype或元素大小不一致时返回false
+  virtual bool SetFromRawBuffer(ns3openenv::Dtype dtype, uint32_t elementSize, const void *data, uint32_t bytes);
+  // RawBoxContainer中每个元素的字节数
+  static uint32_t GetRawElementSize(ns3openenv::Dtype dtype);
+  // Box的形状，其他容器返回空
+  virtual const std::vector<uint32_t>& GetShape();
+
   virtual void Print(std::ostream& where) const = 0;
   friend std::ostream& operator<< (std::ostream& os, const Ptr<OpenEnvDataContainer> container)
   {
@@ -94,6 +108,8 @@ public:
   static TypeId GetTypeId ();
 
   virtual ns3openenv::DataContainer GetDataContainerPbMsg();
+  virtual bool GetRawBuffer(const void **data, uint32_t *bytes, ns3openenv::Dtype *dtype, uint32_t *elementSize);
+  virtual bool SetFromRawBuffer(ns3openenv::Dtype dtype, uint32_t elementSize, const void *data, uint32_t bytes);
 
   virtual void Print(std::ostream& where) const;
   friend std::ostream& operator<< (std::ostream& os, const Ptr<OpenEnvBoxContainer> container)
@@ -108,7 +124,12 @@ public:
   bool SetData(std::vector<T> data);
   std::vector<T> GetData();
 
-  std::vector<uint32_t> GetShape();
+  // 直接读写内部数组，每个step复用同一个box时不需要逐个AddValue或拷贝vector
+  T* GetRawData();
+  uint32_t GetSize();
+  void Resize(uint32_t size);
+
+  virtual const std::vector<uint32_t>& GetShape();
 
 protected:
   // Inherited
@@ -217,6 +238,30 @@ OpenEnvBoxContainer<T>::GetDataContainerPbMsg()
   return dataContainerPbMsg;
 }
 
+template <typename T>
+bool
+OpenEnvBoxContainer<T>::GetRawBuffer(const void **data, uint32_t *bytes, ns3openenv::Dtype *dtype, uint32_t *elementSize)
+{
+  *data = m_data.data();
+  *bytes = m_data.size() * sizeof(T);
+  *dtype = m_dtype;
+  *elementSize = sizeof(T);
+  return true;
+}
+
+template <typename T>
+bool
+OpenEnvBoxContainer<T>::SetFromRawBuffer(ns3openenv::Dtype dtype, uint32_t elementSize, const void *data, uint32_t bytes)
+{
+  if (dtype != m_dtype || elementSize != sizeof(T)) {
+    return false;
+  }
+  // 大小不变时resize不会重新分配
+  m_data.resize(bytes / sizeof(T));
+  std::memcpy(m_data.data(), data, m_data.size() * sizeof(T));
+  return true;
+}
+
 template <typename T>
 bool
 OpenEnvBoxContainer<T>::AddValue(T value)
@@ -246,7 +291,7 @@ OpenEnvBoxContainer<T>::SetData(std::vector<T> data)
 }
 
 template <typename T>
-std::vector<uint32_t>
+const std::vector<uint32_t>&
 OpenEnvBoxContainer<T>::GetShape()
 {
   return m_shape;
@@ -259,6 +304,27 @@ OpenEnvBoxContainer<T>::GetData()
   return m_data;
 }
 
+template <typename T>
+T*
+OpenEnvBoxContainer<T>::GetRawData()
+{
+  return m_data.data();
+}
+
+template <typename T>
+uint32_t
+OpenEnvBoxContainer<T>::GetSize()
+{
+  return m_data.size();
+}
+
+template <typename T>
+void
+OpenEnvBoxContainer<T>::Resize(uint32_t size)
+{
+  m_data.resize(size);
+}
+
 template <typename T>
 void
 OpenEnvBoxContainer<T>::Print(std::ostream& where) const
@@ -25,6 +25,7 @@
 #include "container.h"
 #include "spaces.h"
 #include "openenv_interface.h"
+#include "openenv_vector_env.h"
 
 namespace ns3 {
 
@@ -43,6 +44,7 @@ OpenEnvAbstract::GetTypeId (void)
 }
 
 OpenEnvAbstract::OpenEnvAbstract()
+  : m_vectorEnv(0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -56,6 +58,7 @@ void
 OpenEnvAbstract::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_vectorEnv = 0;
 }
 
 void
@@ -78,11 +81,23 @@ OpenEnvAbstract::SetOpenEnvInterface(Ptr<OpenEnvInterface> openEnvInterface)
   openEnvInterface->SetExecuteActionsCb( MakeCallback (&OpenEnvAbstract::ExecuteActions, this) );
 }
 
+bool
+OpenEnvAbstract::Reset()
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_WARN("OpenEnvAbstract: in-process reset is not supported by this environment");
+  return false;
+}
+
 void
 OpenEnvAbstract::Notify()
 {
   NS_LOG_FUNCTION (this);
-  if (m_openEnvInterface)
+  if (m_vectorEnv)
+  {
+    m_vectorEnv->NotifyEnv(this);
+  }
+  else if (m_openEnvInterface)
   {
     m_openEnvInterface->Notify(this);
   }
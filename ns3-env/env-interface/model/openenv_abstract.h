@@ -29,6 +29,7 @@ namespace ns3 {
 class OpenEnvSpace;
 class OpenEnvDataContainer;
 class OpenEnvInterface;
+class OpenEnvVectorEnv;
 
 class OpenEnvAbstract : public Object
 {
@@ -47,8 +48,10 @@ public:
   virtual float GetReward() = 0;
   virtual std::string GetExtraInfo() = 0;
   virtual bool ExecuteActions(Ptr<OpenEnvDataContainer> action) = 0;
+  // 把环境恢复到新episode的开始，用于OpenEnvInterface::SetResetCb，默认不支持原地reset
+  virtual bool Reset();
 
-  void SetOpenEnvInterface(Ptr<OpenEnvInterface> openEnvInterface);
+  virtual void SetOpenEnvInterface(Ptr<OpenEnvInterface> openEnvInterface);
   void Notify();
   void NotifySimulationEnd();
 
@@ -60,6 +63,10 @@ protected:
 
   Ptr<OpenEnvInterface> m_openEnvInterface;
 private:
+  friend class OpenEnvVectorEnv;
+
+  // 作为OpenEnvVectorEnv的子环境时，Notify交给它汇总，不持有引用以免循环
+  OpenEnvVectorEnv *m_vectorEnv;
 
 };
 
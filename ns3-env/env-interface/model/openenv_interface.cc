@@ -20,15 +20,29 @@
  */
 
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 #include "ns3/log.h"
+#include "ns3/abort.h"
 #include "ns3/config.h"
 #include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/rng-seed-manager.h"
 #include "openenv_interface.h"
 #include "openenv_abstract.h"
 #include "container.h"
 #include "spaces.h"
 #include "messages.pb.h"
+#include <google/protobuf/io/coded_stream.h>
 
 namespace ns3 {
 
@@ -36,6 +50,16 @@ NS_LOG_COMPONENT_DEFINE ("OpenEnvInterface");
 
 NS_OBJECT_ENSURE_REGISTERED (OpenEnvInterface);
 
+// RawBoxContainer的data按本机字节序直接写出，协议规定为小端
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "RawBoxContainer requires a little-endian host");
+
+// length-delimited字段的tag
+static inline uint32_t
+LengthDelimitedTag(uint32_t fieldNumber)
+{
+  return (fieldNumber << 3) | 2;
+}
+
 
 TypeId
 OpenEnvInterface::GetTypeId (void)
@@ -44,6 +68,51 @@ OpenEnvInterface::GetTypeId (void)
     .SetParent<Object> ()
     .SetGroupName ("OpenEnv")
     .AddConstructor<OpenEnvInterface> ()
+    .AddAttribute ("EnableProfiler",
+                   "Record per-step wall-clock time of each phase of the simulation loop.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&OpenEnvInterface::m_enableProfiler),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ProfilerTraceFile",
+                   "CSV file receiving one line per step; empty to print only the summary.",
+                   StringValue (""),
+                   MakeStringAccessor (&OpenEnvInterface::m_profilerTraceFile),
+                   MakeStringChecker ())
+    .AddAttribute ("Transport",
+                   "Transport to the Python process: zmq, or shm for the shared-memory rings.",
+                   StringValue ("zmq"),
+                   MakeStringAccessor (&OpenEnvInterface::m_transport),
+                   MakeStringChecker ())
+    .AddAttribute ("ShmName",
+                   "Name of the shared memory created by the Python process; empty for /ns3openenv-<port>.",
+                   StringValue (""),
+                   MakeStringAccessor (&OpenEnvInterface::m_shmName),
+                   MakeStringChecker ())
+    .AddAttribute ("MaxStaleness",
+                   "Asynchronous stepping: the simulation keeps running while the agent computes, and an action "
+                   "may lag the latest state by up to this many steps. 0 keeps the REQ/REP lockstep.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&OpenEnvInterface::m_maxStaleness),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SnapshotServer",
+                   "Stop before the first step (after warm-up) and fork a child process from that state for "
+                   "each fork request of the Python snapshot server; each child runs one environment.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&OpenEnvInterface::m_snapshotServer),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Endpoint",
+                   "ZMQ endpoint to connect to, e.g. ipc:///tmp/ns3env, ipc://@ns3env (abstract namespace) or "
+                   "inproc://ns3env for an agent sharing the ZMQ context; empty for $NS3_OPENENV_ENDPOINT, "
+                   "then tcp://localhost:<port>.",
+                   StringValue (""),
+                   MakeStringAccessor (&OpenEnvInterface::m_endpoint),
+                   MakeStringChecker ())
+    .AddAttribute ("PolicyFile",
+                   "Evaluate the MLP policy exported to this file (RLAgent/AgentDDPG.py export_actor) inside the "
+                   "simulation and execute its actions directly, without connecting to Python; empty to use Python.",
+                   StringValue (""),
+                   MakeStringAccessor (&OpenEnvInterface::m_policyFile),
+                   MakeStringChecker ())
     ;
   return tid;
 }
@@ -79,7 +148,14 @@ OpenEnvInterface::Delete (void)
 
 OpenEnvInterface::OpenEnvInterface(uint32_t port):
   m_port(port), m_zmq_context(1), m_zmq_socket(m_zmq_context, ZMQ_REQ),
-  m_simEnd(false), m_stopEnvRequested(false), m_initSimMsgSent(false)
+  m_useShm(false), m_rawBox(false),
+  m_snapshotServer(false), m_forkedChild(false),
+  m_maxStaleness(0), m_stepId(0), m_actedStepId(0),
+  m_simEnd(false), m_stopEnvRequested(false), m_initSimMsgSent(false),
+  m_resetRequested(false), m_resetSeed(0), m_resetTime(0),
+  m_repeatLeft(0),
+  m_policySteps(0), m_policyReward(0),
+  m_enableProfiler(false), m_summaryPrinted(false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -93,6 +169,8 @@ void
 OpenEnvInterface::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_actContainer = 0;
+  m_repeatAction = 0;
 }
 
 void
@@ -150,6 +228,41 @@ OpenEnvInterface::SetExecuteActionsCb(Callback<bool, Ptr<OpenEnvDataContainer> >
   m_actionCb = cb;
 }
 
+void
+OpenEnvInterface::SetGetRouteTimeCb(Callback<double> cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_routeTimeCb = cb;
+}
+
+void
+OpenEnvInterface::SetGetNumEnvsCb(Callback<uint32_t> cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_numEnvsCb = cb;
+}
+
+void
+OpenEnvInterface::SetGetEnvRewardCb(Callback<float, uint32_t> cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_envRewardCb = cb;
+}
+
+void
+OpenEnvInterface::SetGetEnvGameOverCb(Callback<bool, uint32_t> cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_envGameOverCb = cb;
+}
+
+void
+OpenEnvInterface::SetResetCb(Callback<bool> cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_resetCb = cb;
+}
+
 void 
 OpenEnvInterface::Init()
 {
@@ -160,19 +273,35 @@ OpenEnvInterface::Init()
   }
   m_initSimMsgSent = true;
 
-  std::string connectAddr = "tcp://localhost:" + std::to_string(m_port);
-  zmq_connect ((void*)m_zmq_socket, connectAddr.c_str());
-
   Ptr<OpenEnvSpace> obsSpace = GetObservationSpace();
   Ptr<OpenEnvSpace> actionSpace = GetActionSpace();
 
   NS_LOG_UNCOND("Simulation process id: " << ::getpid() << " (parent (waf shell) id: " << ::getppid() << ")");
-  NS_LOG_UNCOND("Waiting for Python process to connect on port: "<< connectAddr);
-  NS_LOG_UNCOND("Please start proper Python Env Agent");
+  NS_ABORT_MSG_IF(m_transport == "shm" && m_maxStaleness > 0, "OpenEnvInterface: MaxStaleness requires the zmq transport");
+  if (m_transport == "shm") {
+    m_useShm = true;
+    std::string shmName = m_shmName.empty() ? "/ns3openenv-" + std::to_string(m_port) : m_shmName;
+    m_shm.Open(shmName);
+  } else if (m_transport == "zmq") {
+    if (m_maxStaleness > 0) {
+      // REQ要求严格的一问一答，异步模式与Python端的DEALER配对
+      m_zmq_socket = zmq::socket_t(m_zmq_context, ZMQ_DEALER);
+    }
+    std::string connectAddr = GetEndpoint();
+    zmq_connect ((void*)m_zmq_socket, connectAddr.c_str());
+    NS_LOG_UNCOND("Waiting for Python process to connect on: "<< connectAddr);
+    NS_LOG_UNCOND("Please start proper Python Env Agent");
+  } else {
+    NS_FATAL_ERROR("Unknown OpenEnvInterface transport: " << m_transport);
+  }
 
   ns3openenv::SimInitMsg simInitMsg;
   simInitMsg.set_simprocessid(::getpid());
-  simInitMsg.set_wafshellprocessid(::getppid());
+  // fork出的子进程的父进程是快照服务器，不能让Python端当作waf shell结束掉
+  simInitMsg.set_wafshellprocessid(m_forkedChild ? 0 : ::getppid());
+  simInitMsg.set_rawboxsupported(true);
+  // 异步模式下Python端会跳过过时的状态，不支持原地reset
+  simInitMsg.set_resetsupported(!m_resetCb.IsNull() && m_maxStaleness == 0);
 
   if (obsSpace) {
     ns3openenv::SpaceDescription spaceDesc;
@@ -187,26 +316,26 @@ OpenEnvInterface::Init()
   }
 
   // send init msg to python
-  zmq::message_t request(simInitMsg.ByteSize());;
-  simInitMsg.SerializeToArray(request.data(), simInitMsg.ByteSize());
-  m_zmq_socket.send (request);
+  SendMsg(simInitMsg);
 
   // receive init ack msg form python
   ns3openenv::SimInitAck simInitAck;
-  zmq::message_t reply;
-  m_zmq_socket.recv (&reply);
-  simInitAck.ParseFromArray(reply.data(), reply.size());
+  RecvMsg(simInitAck);
 
   bool done = simInitAck.done();
   NS_LOG_DEBUG("Sim Init Ack: " << done);
+  // 旧版本的Python端不认识这个字段，仍然使用repeated字段
+  m_rawBox = simInitAck.rawboxenabled();
 
   bool stopSim = simInitAck.stopsimreq();
   if (stopSim) {
     NS_LOG_DEBUG("---Stop requested: " << stopSim);
-    m_stopEnvRequested = true;
-    Simulator::Stop();
-    Simulator::Destroy ();
-    std::exit(0);
+    StopSimulation();
+  }
+
+  // 握手完成后才开始计时，等待Python连接的时间不计入
+  if (m_enableProfiler) {
+    m_profiler.Enable(m_profilerTraceFile);
   }
 }
 
@@ -215,7 +344,16 @@ OpenEnvInterface::NotifyCurrentState()
 {
   NS_LOG_FUNCTION (this);
 
+  if (!m_policyFile.empty()) {
+    NotifyCurrentStatePolicy();
+    return;
+  }
+
   if (!m_initSimMsgSent) {
+    if (m_snapshotServer && !m_forkedChild) {
+      // 热身已经结束，之后的step都在fork出的子进程中进行
+      RunSnapshotServer();
+    }
     Init();
   }
 
@@ -223,66 +361,519 @@ OpenEnvInterface::NotifyCurrentState()
     return;
   }
 
+  m_profiler.BeginStep();
+
   // collect current env state
   Ptr<OpenEnvDataContainer> obsDataContainer = GetObservation();
   float reward = GetReward();
   bool isGameOver = IsGameOver();
   std::string extraInfo = GetExtraInfo();
+  m_profiler.Mark(OpenEnvProfiler::COLLECT);
+
+  if (m_repeatLeft > 0 && !isGameOver) {
+    // 动作宏中间的step：状态留在本地，继续执行同一个动作，不与Python交互
+    AppendMacroStep(obsDataContainer, reward);
+    m_repeatLeft--;
+    m_profiler.Mark(OpenEnvProfiler::SERIALIZE);
+    ApplyActions(m_repeatAction);
+    m_profiler.EndStep();
+    return;
+  }
+  m_repeatLeft = 0;
+  m_repeatAction = 0;
+
+  Ptr<OpenEnvDataContainer> rawObs = FillStateMsg(obsDataContainer, reward, isGameOver, extraInfo);
+
+  if (m_maxStaleness > 0) {
+    NotifyCurrentStateAsync(rawObs);
+    return;
+  }
+
+  // send env state msg to python
+  m_profiler.Mark(OpenEnvProfiler::SERIALIZE);
+  SendMsg(m_envStateMsg, rawObs);
+  ClearMacroSteps();
+
+  // receive act msg form python
+  ClearActMsg();
+  Ptr<OpenEnvDataContainer> rawAct = RecvMsg(m_envActMsg);
+  m_profiler.Mark(OpenEnvProfiler::WAIT);
+
+  if (m_envActMsg.resetreq()) {
+    // reset请求代替本step的动作
+    RequestReset();
+    m_profiler.Mark(OpenEnvProfiler::ACTION);
+    m_profiler.EndStep();
+    return;
+  }
+
+  if (m_simEnd) {
+    // if sim end only rx ms and quit
+    m_profiler.Mark(OpenEnvProfiler::ACTION);
+    m_profiler.EndStep();
+    return;
+  }
+
+  if (m_envActMsg.stopsimreq()) {
+    StopSimulation();
+  }
+  m_actedStepId = m_stepId;
+
+  // first step after reset is called without actions, just to get current state
+  Ptr<OpenEnvDataContainer> actDataContainer = GetActionsFromMsg(rawAct);
+  if (m_envActMsg.repeat() > 1) {
+    // 动作宏：之后的repeat-1个step在本地执行同一个动作
+    m_repeatLeft = m_envActMsg.repeat() - 1;
+    m_repeatAction = actDataContainer;
+  }
+  ApplyActions(actDataContainer);
+  m_profiler.EndStep();
+}
+
+void
+OpenEnvInterface::NotifyCurrentStatePolicy()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_policy.GetInputSize() == 0) {
+    bool loaded = m_policy.Load(m_policyFile);
+    NS_ABORT_MSG_IF(!loaded, "OpenEnvInterface: cannot load policy file " << m_policyFile);
+    NS_LOG_UNCOND("Evaluating policy " << m_policyFile << " inside the simulation, Python is not used");
+    if (m_enableProfiler) {
+      m_profiler.Enable(m_profilerTraceFile);
+    }
+  }
+
+  m_profiler.BeginStep();
+  Ptr<OpenEnvDataContainer> obsDataContainer = GetObservation();
+  float reward = GetReward();
+  bool isGameOver = IsGameOver();
+  m_profiler.Mark(OpenEnvProfiler::COLLECT);
+  m_policySteps++;
+  m_policyReward += reward;
+
+  if (isGameOver) {
+    // Python端在游戏结束时会关闭仿真，这里让Run返回，由脚本正常结束
+    Simulator::Stop();
+    m_profiler.EndStep();
+    return;
+  }
+
+  // 策略的前向计算记在WAIT中，对应Python端计算动作的时间
+  Ptr<OpenEnvDataContainer> action = m_policy.ComputeAction(obsDataContainer);
+  NS_ABORT_MSG_IF(action == 0, "OpenEnvInterface: policy " << m_policyFile << " cannot handle the observation");
+  m_profiler.Mark(OpenEnvProfiler::WAIT);
+  ApplyActions(action);
+  m_profiler.EndStep();
+}
+
+void
+OpenEnvInterface::ApplyActions(Ptr<OpenEnvDataContainer> action)
+{
+  NS_LOG_FUNCTION (this);
+  double routeTime = 0;
+  if (m_profiler.IsEnabled() && !m_routeTimeCb.IsNull()) {
+    routeTime = -m_routeTimeCb();
+  }
+  ExecuteActions(action);
+  m_profiler.Mark(OpenEnvProfiler::ACTION);
+  if (m_profiler.IsEnabled() && !m_routeTimeCb.IsNull()) {
+    routeTime += m_routeTimeCb();
+    m_profiler.Transfer(OpenEnvProfiler::ACTION, OpenEnvProfiler::ROUTE, routeTime);
+  }
+}
+
+void
+OpenEnvInterface::AppendMacroStep(Ptr<OpenEnvDataContainer> obsDataContainer, float reward)
+{
+  NS_LOG_FUNCTION (this);
+  const void *rawData;
+  uint32_t rawBytes, rawElementSize;
+  ns3openenv::Dtype rawDtype;
+  m_envStateMsg.add_stepreward(reward);
+  if ((m_useShm || m_rawBox) && obsDataContainer &&
+      obsDataContainer->GetRawBuffer(&rawData, &rawBytes, &rawDtype, &rawElementSize)) {
+    // 观测容器可能在下一个step被原地改写，这里复制一份；Clear之后的子消息会被复用
+    ns3openenv::RawBoxContainer *stepObs = m_envStateMsg.add_stepobsraw();
+    stepObs->set_dtype(rawDtype);
+    const std::vector<uint32_t> &shape = obsDataContainer->GetShape();
+    google::protobuf::RepeatedField<uint32_t> *stepShape = stepObs->mutable_shape();
+    stepShape->Clear();
+    for (uint32_t i = 0; i < shape.size(); i++) {
+      stepShape->Add(shape[i]);
+    }
+    stepObs->set_data(rawData, rawBytes);
+  } else if (obsDataContainer) {
+    m_envStateMsg.add_stepobsdata()->CopyFrom(obsDataContainer->GetDataContainerPbMsg());
+  }
+}
+
+void
+OpenEnvInterface::ClearMacroSteps()
+{
+  NS_LOG_FUNCTION (this);
+  m_envStateMsg.clear_stepobsdata();
+  m_envStateMsg.clear_stepobsraw();
+  m_envStateMsg.clear_stepreward();
+}
+
+void
+OpenEnvInterface::NotifyCurrentStateAsync(Ptr<OpenEnvDataContainer> rawObs)
+{
+  NS_LOG_FUNCTION (this);
+  m_profiler.Mark(OpenEnvProfiler::SERIALIZE);
+  SendMsg(m_envStateMsg, rawObs);
+
+  if (m_simEnd) {
+    // 丢弃还在路上的动作，直到Python端回复结束
+    while (RecvAsyncActMsg(true) && !m_envActMsg.stopsimreq()) {
+    }
+    m_profiler.Mark(OpenEnvProfiler::WAIT);
+    m_profiler.EndStep();
+    return;
+  }
+
+  // 先取走已经到达的动作，只保留最新的一个；动作落后超过MaxStaleness时等待
+  bool received = false;
+  while (RecvAsyncActMsg(false)) {
+    received = true;
+  }
+  while (m_stepId - m_actedStepId > m_maxStaleness) {
+    RecvAsyncActMsg(true);
+    received = true;
+  }
+  m_profiler.Mark(OpenEnvProfiler::WAIT);
+
+  if (received) {
+    ApplyActions(GetActionsFromMsg(0));
+  }
+  m_profiler.EndStep();
+}
+
+bool
+OpenEnvInterface::RecvAsyncActMsg(bool wait)
+{
+  NS_LOG_FUNCTION (this << wait);
+  if (!m_zmq_socket.recv (&m_recvMsg, wait ? 0 : ZMQ_DONTWAIT)) {
+    return false;
+  }
+  // 只有最新的动作会被执行，这里覆盖之前收到的
+  ClearActMsg();
+  MergeMsg(m_envActMsg, m_recvMsg.data(), m_recvMsg.size());
+  if (m_envActMsg.stopsimreq()) {
+    if (!m_simEnd) {
+      StopSimulation();
+    }
+    return true;
+  }
+  NS_ABORT_MSG_IF(m_envActMsg.stepid() > m_stepId, "OpenEnvInterface: action for unknown step " << m_envActMsg.stepid());
+  m_actedStepId = std::max(m_actedStepId, m_envActMsg.stepid());
+  return true;
+}
+
+void
+OpenEnvInterface::StopSimulation()
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_DEBUG("---Stop requested");
+  m_stopEnvRequested = true;
+  // 进程直接退出，不会再经过NotifySimulationEnd，在这里输出统计
+  PrintSummary();
+  Simulator::Stop();
+  Simulator::Destroy ();
+  std::exit(0);
+}
+
+void
+OpenEnvInterface::RequestReset()
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF(m_resetCb.IsNull(), "OpenEnvInterface: reset requested but no reset callback is set");
+  NS_LOG_DEBUG("---Reset requested, seed " << m_envActMsg.resetseed());
+  m_resetRequested = true;
+  m_resetSeed = m_envActMsg.resetseed();
+  if (!m_simEnd) {
+    // 当前事件执行完后Run返回，reset在事件之外进行
+    Simulator::Stop();
+  }
+}
+
+void
+OpenEnvInterface::RunSnapshotServer()
+{
+  NS_LOG_FUNCTION (this);
+  // 控制连接总是使用ZMQ，Transport只用于子进程
+  std::string connectAddr = GetEndpoint();
+  zmq_connect ((void*)m_zmq_socket, connectAddr.c_str());
+  NS_LOG_UNCOND("Snapshot server at " << Simulator::Now().GetSeconds() << "s, waiting for fork requests on: " << connectAddr);
+
+  ns3openenv::SnapshotMsg snapshotMsg;
+  snapshotMsg.set_simprocessid(::getpid());
+  snapshotMsg.set_wafshellprocessid(::getppid());
+  snapshotMsg.set_simtime(Simulator::Now().GetSeconds());
+  ns3openenv::ForkReq forkReq;
+  while (true) {
+    // 回收已经结束的子进程
+    while (::waitpid(-1, NULL, WNOHANG) > 0) {
+    }
+    SendMsg(snapshotMsg);
+    forkReq.Clear();
+    RecvMsg(forkReq);
+    if (forkReq.stopserver()) {
+      NS_LOG_UNCOND("Snapshot server stopped");
+      StopSimulation();
+    }
+
+    pid_t pid = ::fork();
+    NS_ABORT_MSG_IF(pid < 0, "OpenEnvInterface: fork failed: " << std::strerror(errno));
+    if (pid == 0) {
+      break;
+    }
+    NS_LOG_UNCOND("Forked snapshot child " << pid << " for port " << forkReq.port() << " " << forkReq.endpoint());
+    snapshotMsg.set_childpid(pid);
+  }
+
+  // 子进程：父进程ZMQ context的后台线程没有被fork过来，析构它会阻塞，
+  // 因此不析构，直接在原处构造新的context和socket，旧的留给进程退出时回收
+  new (&m_zmq_context) zmq::context_t(1);
+  new (&m_zmq_socket) zmq::socket_t(m_zmq_context, ZMQ_REQ);
+  m_forkedChild = true;
+  m_port = forkReq.port();
+  // 没有指定endpoint的子进程使用TCP端口，不能继承服务器的控制连接
+  m_endpoint = forkReq.endpoint();
+  // 共享内存按端口命名，各子进程互不干扰
+  m_shmName.clear();
+  if (forkReq.seed() != 0) {
+    // 只影响此后创建的随机变量流
+    RngSeedManager::SetRun(forkReq.seed());
+  }
+}
 
-  ns3openenv::EnvStateMsg envStateMsg;
+std::string
+OpenEnvInterface::GetEndpoint() const
+{
+  if (!m_endpoint.empty()) {
+    return m_endpoint;
+  }
+  // 环境变量只对直接启动的仿真生效，fork出的子进程会继承服务器的环境变量
+  const char *envEndpoint = m_forkedChild ? NULL : std::getenv("NS3_OPENENV_ENDPOINT");
+  if (envEndpoint && *envEndpoint) {
+    return envEndpoint;
+  }
+  return "tcp://localhost:" + std::to_string(m_port);
+}
+
+zmq::context_t &
+OpenEnvInterface::GetZmqContext()
+{
+  return m_zmq_context;
+}
+
+Ptr<OpenEnvDataContainer>
+OpenEnvInterface::FillStateMsg(Ptr<OpenEnvDataContainer> obsDataContainer, float reward, bool isGameOver,
+                               const std::string &extraInfo)
+{
+  NS_LOG_FUNCTION (this);
   // observation
-  ns3openenv::DataContainer obsDataContainerPbMsg;
-  if (obsDataContainer) {
-    obsDataContainerPbMsg = obsDataContainer->GetDataContainerPbMsg();
-    envStateMsg.mutable_obsdata()->CopyFrom(obsDataContainerPbMsg);
+  const void *rawData;
+  uint32_t rawBytes, rawElementSize;
+  ns3openenv::Dtype rawDtype;
+  Ptr<OpenEnvDataContainer> rawObs;
+  if ((m_useShm || m_rawBox) && obsDataContainer &&
+      obsDataContainer->GetRawBuffer(&rawData, &rawBytes, &rawDtype, &rawElementSize)) {
+    // Box观测作为原始数组在SendMsg中直接写出，obsData留空
+    rawObs = obsDataContainer;
+    m_envStateMsg.clear_obsdata();
+  } else if (obsDataContainer) {
+    m_envStateMsg.mutable_obsdata()->CopyFrom(obsDataContainer->GetDataContainerPbMsg());
+  } else {
+    m_envStateMsg.clear_obsdata();
   }
   // reward
-  envStateMsg.set_reward(reward);
+  m_envStateMsg.set_reward(reward);
   // game over
-  envStateMsg.set_isgameover(false);
+  m_envStateMsg.set_isgameover(false);
+  m_envStateMsg.set_reason(ns3openenv::EnvStateMsg::SimulationEnd);
   if (isGameOver)
   {
-    envStateMsg.set_isgameover(true);
+    m_envStateMsg.set_isgameover(true);
     if (m_simEnd) {
-      envStateMsg.set_reason(ns3openenv::EnvStateMsg::SimulationEnd);
+      m_envStateMsg.set_reason(ns3openenv::EnvStateMsg::SimulationEnd);
     } else {
-      envStateMsg.set_reason(ns3openenv::EnvStateMsg::GameOver);
+      m_envStateMsg.set_reason(ns3openenv::EnvStateMsg::GameOver);
+    }
+  }
+
+  // 向量化环境逐个子环境的奖励和结束标志，清空时保留容量
+  m_envStateMsg.clear_envreward();
+  m_envStateMsg.clear_envgameover();
+  if (!m_numEnvsCb.IsNull()) {
+    uint32_t numEnvs = m_numEnvsCb();
+    for (uint32_t k = 0; k < numEnvs; k++) {
+      m_envStateMsg.add_envreward(m_envRewardCb(k));
+      m_envStateMsg.add_envgameover(m_envGameOverCb(k));
     }
   }
 
   // extra info
-  envStateMsg.set_info(extraInfo);
+  m_envStateMsg.set_info(extraInfo);
+  if (m_maxStaleness > 0) {
+    // 当前生效的动作落后了多少个状态，锁步时总是0
+    std::string *info = m_envStateMsg.mutable_info();
+    if (!info->empty()) {
+      info->append("|");
+    }
+    info->append("staleness=");
+    info->append(std::to_string(m_stepId - m_actedStepId));
+  }
+  m_envStateMsg.set_stepid(++m_stepId);
+  // 只在reset后的第一个状态中发送
+  m_envStateMsg.set_resettime(m_resetTime);
+  m_resetTime = 0;
+  return rawObs;
+}
 
-  // send env state msg to python
-  zmq::message_t request(envStateMsg.ByteSize());;
-  envStateMsg.SerializeToArray(request.data(), envStateMsg.ByteSize());
-  m_zmq_socket.send (request);
+void
+OpenEnvInterface::ClearActMsg()
+{
+  NS_LOG_FUNCTION (this);
+  // proto3的Clear会释放子消息，这里只清空字段，保留actRaw及其数组的容量，之后以Merge方式解析
+  m_envActMsg.clear_actdata();
+  m_envActMsg.set_stopsimreq(false);
+  m_envActMsg.set_resetreq(false);
+  m_envActMsg.set_resetseed(0);
+  m_envActMsg.set_repeat(0);
+  m_envActMsg.mutable_actraw()->Clear();
+}
 
-  // receive act msg form python
-  ns3openenv::EnvActMsg envActMsg;
-  zmq::message_t reply;
-  m_zmq_socket.recv (&reply);
-  envActMsg.ParseFromArray(reply.data(), reply.size());
+Ptr<OpenEnvDataContainer>
+OpenEnvInterface::GetActionsFromMsg(Ptr<OpenEnvDataContainer> rawAct)
+{
+  NS_LOG_FUNCTION (this);
+  if (rawAct) {
+    return rawAct;
+  }
+  const ns3openenv::RawBoxContainer &actRaw = m_envActMsg.actraw();
+  if (actRaw.dtype() != ns3openenv::NoDType) {
+    return UpdateActContainer(actRaw.dtype(), OpenEnvDataContainer::GetRawElementSize(actRaw.dtype()),
+                              actRaw.data().data(), actRaw.data().size());
+  }
+  // 旧格式的动作，每个step创建新的容器
+  ns3openenv::DataContainer actDataContainerPbMsg = m_envActMsg.actdata();
+  return OpenEnvDataContainer::CreateFromDataContainerPbMsg(actDataContainerPbMsg);
+}
 
-  if (m_simEnd) {
-    // if sim end only rx ms and quit
-    return;
+Ptr<OpenEnvDataContainer>
+OpenEnvInterface::UpdateActContainer(ns3openenv::Dtype dtype, uint32_t elementSize, const void *data, uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this);
+  // 动作的dtype不变时原地更新上一个step的容器
+  if (!m_actContainer || !m_actContainer->SetFromRawBuffer(dtype, elementSize, data, bytes)) {
+    m_actContainer = OpenEnvDataContainer::CreateFromRawBuffer(dtype, elementSize, data, bytes);
   }
+  return m_actContainer;
+}
 
-  bool stopSim = envActMsg.stopsimreq();
-  if (stopSim) {
-    NS_LOG_DEBUG("---Stop requested: " << stopSim);
-    m_stopEnvRequested = true;
-    Simulator::Stop();
-    Simulator::Destroy ();
-    std::exit(0);
+uint32_t
+OpenEnvInterface::SerializeToSendBuffer(const google::protobuf::MessageLite &msg, Ptr<OpenEnvDataContainer> raw)
+{
+  NS_LOG_FUNCTION (this);
+  const void *rawData;
+  uint32_t rawBytes, rawElementSize;
+  ns3openenv::Dtype rawDtype;
+  uint32_t msgBytes = msg.ByteSize();
+  if (!raw || !raw->GetRawBuffer(&rawData, &rawBytes, &rawDtype, &rawElementSize)) {
+    GrowSendBuffer(msgBytes);
+    msg.SerializeWithCachedSizesToArray(m_sendBuffer.data());
+    return msgBytes;
   }
 
-  // first step after reset is called without actions, just to get current state
-  ns3openenv::DataContainer actDataContainerPbMsg = envActMsg.actdata();
-  Ptr<OpenEnvDataContainer> actDataContainer = OpenEnvDataContainer::CreateFromDataContainerPbMsg(actDataContainerPbMsg);
-  ExecuteActions(actDataContainer);
+  // protobuf的字段可以按任意顺序出现，先序列化消息本身，再在其后手工写出obsRaw字段，
+  // 数组只从容器拷贝一次，直接进入发送缓冲区
+  using google::protobuf::io::CodedOutputStream;
+  m_rawBoxHeader.set_dtype(rawDtype);
+  const std::vector<uint32_t> &shape = raw->GetShape();
+  google::protobuf::RepeatedField<uint32_t> *headerShape = m_rawBoxHeader.mutable_shape();
+  headerShape->Clear();
+  for (uint32_t i = 0; i < shape.size(); i++) {
+    headerShape->Add(shape[i]);
+  }
+
+  uint32_t dataTag = LengthDelimitedTag(ns3openenv::RawBoxContainer::kDataFieldNumber);
+  uint32_t rawBoxTag = LengthDelimitedTag(ns3openenv::EnvStateMsg::kObsRawFieldNumber);
+  uint32_t headerBytes = m_rawBoxHeader.ByteSize();
+  uint32_t rawBoxBytes = headerBytes + CodedOutputStream::VarintSize32(dataTag) +
+                         CodedOutputStream::VarintSize32(rawBytes) + rawBytes;
+  uint32_t totalBytes = msgBytes + CodedOutputStream::VarintSize32(rawBoxTag) +
+                        CodedOutputStream::VarintSize32(rawBoxBytes) + rawBoxBytes;
 
+  GrowSendBuffer(totalBytes);
+  uint8_t *target = m_sendBuffer.data();
+  target = msg.SerializeWithCachedSizesToArray(target);
+  target = CodedOutputStream::WriteVarint32ToArray(rawBoxTag, target);
+  target = CodedOutputStream::WriteVarint32ToArray(rawBoxBytes, target);
+  target = m_rawBoxHeader.SerializeWithCachedSizesToArray(target);
+  target = CodedOutputStream::WriteVarint32ToArray(dataTag, target);
+  target = CodedOutputStream::WriteVarint32ToArray(rawBytes, target);
+  std::memcpy(target, rawData, rawBytes);
+  return totalBytes;
+}
+
+void
+OpenEnvInterface::GrowSendBuffer(uint32_t bytes)
+{
+  // 按2倍增长，观测大小稳定后不再分配
+  if (m_sendBuffer.size() < bytes) {
+    m_sendBuffer.resize(std::max<size_t>(bytes, 2 * m_sendBuffer.size()));
+  }
+}
+
+bool
+OpenEnvInterface::MergeMsg(google::protobuf::MessageLite &msg, const void *data, uint32_t bytes)
+{
+  google::protobuf::io::CodedInputStream input(static_cast<const uint8_t *>(data), bytes);
+  return msg.MergeFromCodedStream(&input);
+}
+
+void
+OpenEnvInterface::SendMsg(const google::protobuf::MessageLite &msg, Ptr<OpenEnvDataContainer> raw)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_useShm) {
+    const void *rawData = 0;
+    uint32_t rawBytes = 0, rawElementSize = 0;
+    ns3openenv::Dtype rawDtype = ns3openenv::NoDType;
+    if (raw) {
+      raw->GetRawBuffer(&rawData, &rawBytes, &rawDtype, &rawElementSize);
+    }
+    m_shm.Send(msg, rawData, rawBytes, rawDtype, rawElementSize);
+    return;
+  }
+
+  uint32_t bytes = SerializeToSendBuffer(msg, raw);
+  zmq_send((void*)m_zmq_socket, m_sendBuffer.data(), bytes, 0);
+}
+
+Ptr<OpenEnvDataContainer>
+OpenEnvInterface::RecvMsg(google::protobuf::MessageLite &msg)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_useShm) {
+    OpenEnvShmChannel::Frame frame;
+    m_shm.Receive(frame);
+    MergeMsg(msg, frame.msg, frame.msgBytes);
+    Ptr<OpenEnvDataContainer> raw;
+    if (frame.raw) {
+      // 环中的空间要尽早还给Python端，先复制到动作容器中
+      raw = UpdateActContainer(static_cast<ns3openenv::Dtype>(frame.rawDtype), frame.rawElementSize,
+                               frame.raw, frame.rawBytes);
+    }
+    m_shm.Release();
+    return raw;
+  }
+
+  m_zmq_socket.recv (&m_recvMsg);
+  MergeMsg(msg, m_recvMsg.data(), m_recvMsg.size());
+  return 0;
 }
 
 void
@@ -301,6 +892,53 @@ OpenEnvInterface::NotifySimulationEnd()
   if (m_initSimMsgSent) {
     WaitForStop();
   }
+  if (!m_resetRequested) {
+    // 原地reset之后仿真还会继续，统计在真正结束时再输出
+    PrintSummary();
+  }
+}
+
+void
+OpenEnvInterface::PrintSummary()
+{
+  NS_LOG_FUNCTION (this);
+  // 仿真结束后等待停止消息时也可能进入StopSimulation，只输出一次
+  if (m_summaryPrinted) {
+    return;
+  }
+  m_summaryPrinted = true;
+  if (!m_policyFile.empty()) {
+    NS_LOG_UNCOND("Policy evaluation: " << m_policySteps << " steps, total reward " << m_policyReward
+                  << ", mean reward " << (m_policySteps > 0 ? m_policyReward / m_policySteps : 0));
+  }
+  m_profiler.PrintSummary(std::cout);
+  std::cout.flush();
+}
+
+bool
+OpenEnvInterface::NotifyEpisodeEnd()
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_resetRequested) {
+    // 仿真到达结束时间，Python端可以在结束的状态之后请求reset
+    NotifySimulationEnd();
+    if (!m_resetRequested) {
+      return false;
+    }
+  }
+
+  m_resetRequested = false;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  if (m_resetSeed != 0) {
+    // 只影响此后创建的随机变量流
+    RngSeedManager::SetRun(m_resetSeed);
+  }
+  bool done = m_resetCb();
+  NS_ABORT_MSG_IF(!done, "OpenEnvInterface: reset callback failed");
+  m_simEnd = false;
+  m_resetTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  NS_LOG_UNCOND("In-process reset at " << Simulator::Now().GetSeconds() << "s took " << m_resetTime * 1e3 << " ms");
+  return true;
 }
 
 bool
@@ -23,7 +23,13 @@
 #define OPENENV_INTERFACE_H
 
 #include "ns3/object.h"
+#include "ns3/callback.h"
+#include "openenv_profiler.h"
+#include "openenv_shm.h"
+#include "openenv_policy.h"
+#include "messages.pb.h"
 #include <zmq.hpp>
+#include <vector>
 
 namespace ns3 {
 
@@ -46,6 +52,9 @@ public:
   void WaitForStop();
 
   void NotifySimulationEnd();
+  // Simulator::Run返回时代替NotifySimulationEnd调用：Python端请求了原地reset（在step中或仿真结束的状态之后）时
+  // 执行reset回调并返回true，调用者从当前时刻重新Run；否则与NotifySimulationEnd相同，返回false
+  bool NotifyEpisodeEnd();
 
   Ptr<OpenEnvSpace> GetActionSpace();
   Ptr<OpenEnvSpace> GetObservationSpace();
@@ -62,9 +71,23 @@ public:
   void SetGetGameOverCb(Callback< bool > cb);
   void SetGetExtraInfoCb(Callback<std::string> cb);
   void SetExecuteActionsCb(Callback<bool, Ptr<OpenEnvDataContainer> > cb);
+  // 返回累计路由计算时间（秒）的回调，剖析时用于从动作执行时间中拆出路由计算
+  void SetGetRouteTimeCb(Callback<double> cb);
+  // 向量化环境的子环境数和第k个子环境本step的奖励、结束标志，由OpenEnvVectorEnv设置
+  void SetGetNumEnvsCb(Callback<uint32_t> cb);
+  void SetGetEnvRewardCb(Callback<float, uint32_t> cb);
+  void SetGetEnvGameOverCb(Callback<bool, uint32_t> cb);
+  // 原地reset的回调，把场景恢复到新episode的开始，设置之后握手时告知Python端支持reset
+  void SetResetCb(Callback<bool> cb);
 
   void Notify(Ptr<OpenEnvAbstract> entity);
 
+  // 实际连接的ZMQ endpoint：Endpoint属性，其次是环境变量NS3_OPENENV_ENDPOINT，最后是tcp://localhost:<port>
+  std::string GetEndpoint() const;
+  // 同一进程内的智能体在这个context上bind inproc://的endpoint（在另一个线程中收发），
+  // 仿真端在Init时connect；inproc的endpoint只在同一个context内可见
+  zmq::context_t &GetZmqContext();
+
 protected:
   // Inherited
   virtual void DoInitialize (void);
@@ -74,14 +97,84 @@ private:
   static Ptr<OpenEnvInterface> *DoGet (uint32_t port=5555);
   static void Delete (void);
 
+  // 按Transport发送消息，raw中的Box作为原始数组附加在消息之后：共享内存传输时放在帧的原始数组中，
+  // ZMQ传输时作为EnvStateMsg的obsRaw字段直接写入消息缓冲区，因此raw只用于EnvStateMsg
+  void SendMsg(const google::protobuf::MessageLite &msg, Ptr<OpenEnvDataContainer> raw = 0);
+  // 异步模式的一个step：发送状态后只应用已经到达的动作，超过MaxStaleness时才等待
+  void NotifyCurrentStateAsync(Ptr<OpenEnvDataContainer> rawObs);
+  // PolicyFile模式的一个step：由进程内的策略计算动作并直接执行，不与Python交互
+  void NotifyCurrentStatePolicy();
+  // 异步模式下接收一条动作消息到m_envActMsg，wait为false且没有消息时返回false
+  bool RecvAsyncActMsg(bool wait);
+  void StopSimulation();
+  // 输出策略评估和剖析的统计，只在第一次调用时输出
+  void PrintSummary();
+  // 记录Python端的reset请求，在step中收到时停止Run，由NotifyEpisodeEnd执行reset
+  void RequestReset();
+  // 快照服务器：在第一个step之前（热身结束时）等待fork请求，只有fork出的子进程返回
+  void RunSnapshotServer();
+  // 按Transport接收消息，返回随消息附加的原始数组更新的动作容器，没有时返回0。
+  // 消息以Merge方式解析，调用者负责先清空
+  Ptr<OpenEnvDataContainer> RecvMsg(google::protobuf::MessageLite &msg);
+
+  // 把当前状态填入复用的m_envStateMsg，返回需要作为原始数组发送的观测
+  Ptr<OpenEnvDataContainer> FillStateMsg(Ptr<OpenEnvDataContainer> obs, float reward, bool isGameOver,
+                                         const std::string &extraInfo);
+  // 清空m_envActMsg，保留子消息和数组的容量
+  void ClearActMsg();
+  // 执行动作，剖析时把路由计算时间从动作执行时间中拆出
+  void ApplyActions(Ptr<OpenEnvDataContainer> action);
+  // 把动作宏中间一个step的观测和奖励记到m_envStateMsg的stepObs/stepReward中
+  void AppendMacroStep(Ptr<OpenEnvDataContainer> obs, float reward);
+  // 发送之后清空动作宏收集的状态，保留子消息以便复用
+  void ClearMacroSteps();
+  // 由m_envActMsg（或共享内存中的原始数组）得到本step的动作
+  Ptr<OpenEnvDataContainer> GetActionsFromMsg(Ptr<OpenEnvDataContainer> rawAct);
+  // 用原始数组原地更新m_actContainer，dtype变化时重新创建
+  Ptr<OpenEnvDataContainer> UpdateActContainer(ns3openenv::Dtype dtype, uint32_t elementSize,
+                                               const void *data, uint32_t bytes);
+  // 把消息（及raw）序列化到m_sendBuffer，返回字节数
+  uint32_t SerializeToSendBuffer(const google::protobuf::MessageLite &msg, Ptr<OpenEnvDataContainer> raw);
+  void GrowSendBuffer(uint32_t bytes);
+  static bool MergeMsg(google::protobuf::MessageLite &msg, const void *data, uint32_t bytes);
+
   uint32_t m_port;
   zmq::context_t m_zmq_context;
   zmq::socket_t m_zmq_socket;
 
+  std::string m_endpoint;
+  std::string m_transport;
+  std::string m_shmName;
+  bool m_useShm;
+  OpenEnvShmChannel m_shm;
+  bool m_rawBox;  // 握手时双方都支持RawBoxContainer
+
+  bool m_snapshotServer;
+  bool m_forkedChild;  // 由快照服务器fork出的子进程
+
+  uint32_t m_maxStaleness;  // 0为REQ/REP锁步，否则为DEALER异步模式下允许动作落后的step数
+  uint64_t m_stepId;        // 最近发送的状态序号
+  uint64_t m_actedStepId;   // 最近应用的动作对应的状态序号
+
+  // 每个step复用的消息、发送缓冲区和动作容器，稳态下收发不再分配堆内存
+  ns3openenv::EnvStateMsg m_envStateMsg;
+  ns3openenv::EnvActMsg m_envActMsg;
+  ns3openenv::RawBoxContainer m_rawBoxHeader;
+  std::vector<uint8_t> m_sendBuffer;
+  zmq::message_t m_recvMsg;
+  Ptr<OpenEnvDataContainer> m_actContainer;
+
   bool m_simEnd;
   bool m_stopEnvRequested;
   bool m_initSimMsgSent;
 
+  bool m_resetRequested;
+  uint32_t m_resetSeed;  // 非0时作为新episode的RngRun
+  double m_resetTime;    // 上一次reset的耗时（秒），随reset后的第一个状态发送
+
+  uint32_t m_repeatLeft;  // 动作宏还要在本地执行的step数
+  Ptr<OpenEnvDataContainer> m_repeatAction;  // 动作宏保持的动作
+
   Callback< Ptr<OpenEnvSpace> > m_actionSpaceCb;
   Callback< Ptr<OpenEnvSpace> > m_observationSpaceCb;
   Callback< bool > m_gameOverCb;
@@ -89,6 +182,21 @@ private:
   Callback<float> m_rewardCb;
   Callback<std::string> m_extraInfoCb;
   Callback<bool, Ptr<OpenEnvDataContainer> > m_actionCb;
+  Callback<double> m_routeTimeCb;
+  Callback<uint32_t> m_numEnvsCb;
+  Callback<float, uint32_t> m_envRewardCb;
+  Callback<bool, uint32_t> m_envGameOverCb;
+  Callback<bool> m_resetCb;
+
+  std::string m_policyFile;
+  OpenEnvMlpPolicy m_policy;
+  uint64_t m_policySteps;  // PolicyFile模式下的step数和累计奖励，仿真结束时输出
+  double m_policyReward;
+
+  bool m_enableProfiler;
+  std::string m_profilerTraceFile;
+  OpenEnvProfiler m_profiler;
+  bool m_summaryPrinted;
 };
 
 } // end of namespace ns3
@@ -0,0 +1,276 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * @desc: 在ns-3进程内执行导出的MLP策略，评估时不需要Python端
+ */
+
+#include "openenv_policy.h"
+#include "container.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OpenEnvMlpPolicy");
+
+// 权重文件的magic（"OEMP"）和版本，与RLAgent/AgentDDPG.py中的write_policy一致（由DDPG.export_actor调用）
+static const uint32_t POLICY_MAGIC = 0x504d454f;
+static const uint32_t POLICY_VERSION = 1;
+
+// 4个float的向量，GCC/Clang的向量扩展，x86-64上编译为SSE指令，其他平台为对应的SIMD或标量指令。
+// 不使用32字节的向量，没有开启AVX时它作为参数传递会改变ABI
+static const uint32_t LANES = 4;
+typedef float Float4 __attribute__ ((vector_size (LANES * sizeof (float))));
+
+// 权重按4字节对齐存放，通过memcpy读写向量，编译为不要求对齐的load/store
+static inline Float4
+LoadFloat4 (const float *data)
+{
+  Float4 value;
+  std::memcpy (&value, data, sizeof (value));
+  return value;
+}
+
+static inline void
+StoreFloat4 (float *data, Float4 value)
+{
+  std::memcpy (data, &value, sizeof (value));
+}
+
+template <typename T>
+static bool
+ReadValue (std::ifstream &file, T &value)
+{
+  return static_cast<bool> (file.read (reinterpret_cast<char *> (&value), sizeof (T)));
+}
+
+OpenEnvMlpPolicy::OpenEnvMlpPolicy ()
+  : m_scale (1)
+{
+}
+
+OpenEnvMlpPolicy::~OpenEnvMlpPolicy ()
+{
+}
+
+bool
+OpenEnvMlpPolicy::Load (std::string fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+  m_layers.clear ();
+  m_action = 0;
+
+  std::ifstream file (fileName.c_str (), std::ios::binary);
+  if (!file)
+    {
+      NS_LOG_WARN ("OpenEnvMlpPolicy: cannot open " << fileName);
+      return false;
+    }
+  uint32_t magic, version, layerCount;
+  float scale;
+  if (!ReadValue (file, magic) || !ReadValue (file, version) || !ReadValue (file, layerCount)
+      || !ReadValue (file, scale) || magic != POLICY_MAGIC || version != POLICY_VERSION || layerCount == 0)
+    {
+      NS_LOG_WARN ("OpenEnvMlpPolicy: " << fileName << " is not a policy file of version " << POLICY_VERSION);
+      return false;
+    }
+
+  std::vector<Layer> layers (layerCount);
+  std::vector<float> weight;
+  uint32_t maxDim = 0;
+  for (uint32_t index = 0; index < layerCount; index++)
+    {
+      Layer &layer = layers[index];
+      uint32_t activation;
+      if (!ReadValue (file, layer.inDim) || !ReadValue (file, layer.outDim) || !ReadValue (file, activation)
+          || layer.inDim == 0 || layer.outDim == 0 || activation > TANH
+          || (index > 0 && layer.inDim != layers[index - 1].outDim))
+        {
+          NS_LOG_WARN ("OpenEnvMlpPolicy: bad header of layer " << index << " in " << fileName);
+          return false;
+        }
+      layer.activation = static_cast<Activation> (activation);
+      layer.paddedDim = (layer.outDim + LANES - 1) / LANES * LANES;
+
+      // 文件中为[outDim][inDim]，转置为[inDim][paddedDim]
+      weight.resize (static_cast<size_t> (layer.outDim) * layer.inDim);
+      layer.weight.assign (static_cast<size_t> (layer.inDim) * layer.paddedDim, 0);
+      layer.bias.assign (layer.paddedDim, 0);
+      if (!file.read (reinterpret_cast<char *> (weight.data ()), weight.size () * sizeof (float))
+          || !file.read (reinterpret_cast<char *> (layer.bias.data ()), layer.outDim * sizeof (float)))
+        {
+          NS_LOG_WARN ("OpenEnvMlpPolicy: truncated layer " << index << " in " << fileName);
+          return false;
+        }
+      for (uint32_t out = 0; out < layer.outDim; out++)
+        {
+          for (uint32_t in = 0; in < layer.inDim; in++)
+            {
+              layer.weight[static_cast<size_t> (in) * layer.paddedDim + out] = weight[static_cast<size_t> (out) * layer.inDim + in];
+            }
+        }
+      maxDim = std::max (maxDim, layer.paddedDim);
+    }
+
+  m_layers.swap (layers);
+  m_scale = scale;
+  m_buffer[0].resize (maxDim);
+  m_buffer[1].resize (maxDim);
+  NS_LOG_INFO ("OpenEnvMlpPolicy: loaded " << layerCount << " layers, " << GetInputSize ()
+               << " inputs, " << GetOutputSize () << " outputs from " << fileName);
+  return true;
+}
+
+uint32_t
+OpenEnvMlpPolicy::GetInputSize (void) const
+{
+  return m_layers.empty () ? 0 : m_layers.front ().inDim;
+}
+
+uint32_t
+OpenEnvMlpPolicy::GetOutputSize (void) const
+{
+  return m_layers.empty () ? 0 : m_layers.back ().outDim;
+}
+
+void
+OpenEnvMlpPolicy::ForwardRow (const float *input, float *output)
+{
+  const float *x = input;
+  for (uint32_t index = 0; index < m_layers.size (); index++)
+    {
+      const Layer &layer = m_layers[index];
+      float *y = m_buffer[index % 2].data ();
+      // y = x * W + b，每次计算4个输出，内层循环是一次广播乘加
+      for (uint32_t block = 0; block < layer.paddedDim; block += LANES)
+        {
+          Float4 acc = LoadFloat4 (layer.bias.data () + block);
+          const float *w = layer.weight.data () + block;
+          for (uint32_t in = 0; in < layer.inDim; in++)
+            {
+              acc += x[in] * LoadFloat4 (w + static_cast<size_t> (in) * layer.paddedDim);
+            }
+          StoreFloat4 (y + block, acc);
+        }
+
+      if (layer.activation == RELU)
+        {
+          for (uint32_t out = 0; out < layer.outDim; out++)
+            {
+              y[out] = std::max (y[out], 0.0f);
+            }
+        }
+      else if (layer.activation == SOFTMAX)
+        {
+          float maxValue = *std::max_element (y, y + layer.outDim);
+          float sum = 0;
+          for (uint32_t out = 0; out < layer.outDim; out++)
+            {
+              y[out] = std::exp (y[out] - maxValue);
+              sum += y[out];
+            }
+          for (uint32_t out = 0; out < layer.outDim; out++)
+            {
+              y[out] /= sum;
+            }
+        }
+      else if (layer.activation == TANH)
+        {
+          for (uint32_t out = 0; out < layer.outDim; out++)
+            {
+              y[out] = std::tanh (y[out]);
+            }
+        }
+      x = y;
+    }
+
+  uint32_t outDim = GetOutputSize ();
+  for (uint32_t out = 0; out < outDim; out++)
+    {
+      output[out] = x[out] * m_scale;
+    }
+}
+
+void
+OpenEnvMlpPolicy::Forward (const float *input, float *output, uint32_t rows)
+{
+  NS_ASSERT (!m_layers.empty ());
+  uint32_t inDim = GetInputSize ();
+  uint32_t outDim = GetOutputSize ();
+  for (uint32_t row = 0; row < rows; row++)
+    {
+      ForwardRow (input + static_cast<size_t> (row) * inDim, output + static_cast<size_t> (row) * outDim);
+    }
+}
+
+Ptr<OpenEnvDataContainer>
+OpenEnvMlpPolicy::ComputeAction (Ptr<OpenEnvDataContainer> obs)
+{
+  NS_LOG_FUNCTION (this);
+  const void *data;
+  uint32_t bytes, elementSize;
+  ns3openenv::Dtype dtype;
+  if (m_layers.empty () || obs == 0 || !obs->GetRawBuffer (&data, &bytes, &dtype, &elementSize))
+    {
+      NS_LOG_WARN ("OpenEnvMlpPolicy: policy not loaded or observation is not a Box");
+      return 0;
+    }
+  uint32_t count = bytes / elementSize;
+  uint32_t inDim = GetInputSize ();
+  uint32_t rows = count / inDim;
+  if (rows == 0 || rows * inDim != count)
+    {
+      NS_LOG_WARN ("OpenEnvMlpPolicy: observation of " << count << " elements does not match "
+                   << inDim << " inputs");
+      return 0;
+    }
+
+  // float观测直接使用，其他dtype先转换
+  const float *input = static_cast<const float *> (data);
+  if (dtype != ns3openenv::FLOAT || elementSize != sizeof (float))
+    {
+      m_input.resize (count);
+      for (uint32_t i = 0; i < count; i++)
+        {
+          switch (dtype)
+            {
+            case ns3openenv::DOUBLE:
+              m_input[i] = static_cast<const double *> (data)[i];
+              break;
+            case ns3openenv::INT:
+              m_input[i] = static_cast<const int32_t *> (data)[i];
+              break;
+            case ns3openenv::UINT:
+              m_input[i] = static_cast<const uint32_t *> (data)[i];
+              break;
+            default:
+              NS_LOG_WARN ("OpenEnvMlpPolicy: unsupported observation dtype " << dtype);
+              return 0;
+            }
+        }
+      input = m_input.data ();
+    }
+
+  m_output.resize (static_cast<size_t> (rows) * GetOutputSize ());
+  Forward (input, m_output.data (), rows);
+
+  // 大小不变时原地更新
+  uint32_t outBytes = m_output.size () * sizeof (float);
+  if (!m_action || m_shape.size () != (rows > 1 ? 2u : 1u) || (rows > 1 && m_shape[0] != rows)
+      || !m_action->SetFromRawBuffer (ns3openenv::FLOAT, sizeof (float), m_output.data (), outBytes))
+    {
+      m_shape.clear ();
+      if (rows > 1)
+        {
+          m_shape.push_back (rows);
+        }
+      m_shape.push_back (GetOutputSize ());
+      m_action = OpenEnvDataContainer::CreateFromRawBuffer (ns3openenv::FLOAT, sizeof (float), m_output.data (),
+                                                            outBytes, m_shape);
+    }
+  return m_action;
+}
+
+} // namespace ns3
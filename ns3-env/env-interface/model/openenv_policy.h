@@ -0,0 +1,92 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * @desc: 在ns-3进程内执行导出的MLP策略，评估时不需要Python端
+ */
+
+#ifndef OPENENV_POLICY_H
+#define OPENENV_POLICY_H
+
+#include "ns3/ptr.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+class OpenEnvDataContainer;
+
+/**
+ * \brief 由RLAgent导出的MLP策略（如AgentDDPG的ActorNetwork）
+ *
+ * 权重文件为小端的二进制格式：
+ *  - 文件头：uint32 magic "OEMP"，uint32 version，uint32 层数，float 输出倍率
+ *  - 每层：uint32 输入维度，uint32 输出维度，uint32 激活函数（Activation），
+ *    float weight[输出][输入]（与torch.nn.Linear相同），float bias[输出]
+ *
+ * 加载时把权重转置为[输入][输出]，输出维度补齐到4的倍数，前向计算按4个输出一组用向量乘加，
+ * 编译为SIMD指令。观测的元素数是输入维度的整数倍时按行计算（如向量化环境的[K × obs]）。
+ */
+class OpenEnvMlpPolicy
+{
+public:
+  /// 每层输出的激活函数
+  enum Activation
+  {
+    LINEAR = 0,
+    RELU,
+    SOFTMAX,
+    TANH
+  };
+
+  OpenEnvMlpPolicy ();
+  ~OpenEnvMlpPolicy ();
+
+  /// 加载权重文件，之前加载的网络被替换
+  /// \param fileName 权重文件
+  /// \returns 文件不存在或格式错误时返回false
+  bool Load (std::string fileName);
+
+  /// \returns 网络的输入维度，没有加载时为0
+  uint32_t GetInputSize (void) const;
+
+  /// \returns 网络的输出维度，没有加载时为0
+  uint32_t GetOutputSize (void) const;
+
+  /// 前向计算
+  /// \param input rows行输入，每行GetInputSize个元素
+  /// \param output rows行输出，每行GetOutputSize个元素
+  /// \param rows 行数
+  void Forward (const float *input, float *output, uint32_t rows);
+
+  /// 由Box观测计算Box<float>动作，返回的容器在下一次调用时被原地改写
+  /// \param obs Box观测，元素数必须是输入维度的整数倍
+  /// \returns 动作，没有加载或观测不是合适的Box时返回0
+  Ptr<OpenEnvDataContainer> ComputeAction (Ptr<OpenEnvDataContainer> obs);
+
+private:
+  /// 一个全连接层
+  struct Layer
+  {
+    uint32_t inDim;              //!< 输入维度
+    uint32_t outDim;             //!< 输出维度
+    uint32_t paddedDim;          //!< 补齐到4的倍数的输出维度
+    Activation activation;       //!< 激活函数
+    std::vector<float> weight;   //!< [inDim][paddedDim]，补齐的部分为0
+    std::vector<float> bias;     //!< [paddedDim]
+  };
+
+  /// 计算一行
+  void ForwardRow (const float *input, float *output);
+
+  std::vector<Layer> m_layers;        //!< 各层
+  float m_scale;                      //!< 输出倍率（DDPG的action bound）
+  std::vector<float> m_buffer[2];     //!< 层间交替使用的缓冲区
+  std::vector<float> m_input;         //!< 观测转换为float的缓冲区
+  std::vector<float> m_output;        //!< 动作缓冲区
+  std::vector<uint32_t> m_shape;      //!< 动作的形状
+  Ptr<OpenEnvDataContainer> m_action; //!< 复用的动作容器
+};
+
+} // namespace ns3
+
+#endif /* OPENENV_POLICY_H */
@@ -0,0 +1,191 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * @desc: 按step统计仿真循环各阶段的墙钟时间和仿真事件数
+ */
+
+#include "openenv_profiler.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OpenEnvProfiler");
+
+OpenEnvProfiler::OpenEnvProfiler ()
+  : m_enabled (false),
+    m_trace (0),
+    m_step (0),
+    m_lastEventCount (0),
+    m_stepEvents (0),
+    m_totalEvents (0)
+{
+  for (uint32_t phase = 0; phase < PHASE_COUNT; phase++)
+    {
+      m_stepTime[phase] = 0;
+      m_totalTime[phase] = 0;
+      m_maxTime[phase] = 0;
+    }
+}
+
+OpenEnvProfiler::~OpenEnvProfiler ()
+{
+  if (m_trace != 0)
+    {
+      std::fclose (m_trace);
+      m_trace = 0;
+    }
+}
+
+void
+OpenEnvProfiler::Enable (std::string traceFile)
+{
+  NS_LOG_FUNCTION (this << traceFile);
+  m_enabled = true;
+  m_lastMark = Clock::now ();
+  m_lastEventCount = Simulator::GetEventCount ();
+  if (traceFile.empty ())
+    {
+      return;
+    }
+  m_trace = std::fopen (traceFile.c_str (), "w");
+  if (m_trace == 0)
+    {
+      NS_FATAL_ERROR ("OpenEnvProfiler: cannot open " << traceFile);
+    }
+  std::fprintf (m_trace, "step,simTimeNs,events");
+  for (uint32_t phase = 0; phase < PHASE_COUNT; phase++)
+    {
+      std::fprintf (m_trace, ",%sUs", GetPhaseName (static_cast<Phase> (phase)));
+    }
+  std::fprintf (m_trace, "\n");
+}
+
+bool
+OpenEnvProfiler::IsEnabled (void) const
+{
+  return m_enabled;
+}
+
+void
+OpenEnvProfiler::BeginStep (void)
+{
+  if (!m_enabled)
+    {
+      return;
+    }
+  Mark (SIMULATION);
+  uint64_t eventCount = Simulator::GetEventCount ();
+  m_stepEvents = eventCount - m_lastEventCount;
+  m_lastEventCount = eventCount;
+}
+
+void
+OpenEnvProfiler::Mark (Phase phase)
+{
+  if (!m_enabled)
+    {
+      return;
+    }
+  Clock::time_point now = Clock::now ();
+  m_stepTime[phase] += std::chrono::duration<double> (now - m_lastMark).count ();
+  m_lastMark = now;
+}
+
+void
+OpenEnvProfiler::Transfer (Phase from, Phase to, double seconds)
+{
+  if (!m_enabled)
+    {
+      return;
+    }
+  if (seconds > m_stepTime[from])
+    {
+      seconds = m_stepTime[from];
+    }
+  m_stepTime[from] -= seconds;
+  m_stepTime[to] += seconds;
+}
+
+void
+OpenEnvProfiler::EndStep (void)
+{
+  if (!m_enabled)
+    {
+      return;
+    }
+  if (m_trace != 0)
+    {
+      std::fprintf (m_trace, "%llu,%lld,%llu", (unsigned long long) m_step,
+                    (long long) Simulator::Now ().GetNanoSeconds (), (unsigned long long) m_stepEvents);
+      for (uint32_t phase = 0; phase < PHASE_COUNT; phase++)
+        {
+          std::fprintf (m_trace, ",%.1f", m_stepTime[phase] * 1e6);
+        }
+      std::fprintf (m_trace, "\n");
+    }
+
+  for (uint32_t phase = 0; phase < PHASE_COUNT; phase++)
+    {
+      m_totalTime[phase] += m_stepTime[phase];
+      if (m_stepTime[phase] > m_maxTime[phase])
+        {
+          m_maxTime[phase] = m_stepTime[phase];
+        }
+      m_stepTime[phase] = 0;
+    }
+  m_totalEvents += m_stepEvents;
+  m_stepEvents = 0;
+  m_step++;
+}
+
+void
+OpenEnvProfiler::PrintSummary (std::ostream &os) const
+{
+  if (!m_enabled || m_step == 0)
+    {
+      return;
+    }
+  if (m_trace != 0)
+    {
+      std::fflush (m_trace);
+    }
+  double total = 0;
+  for (uint32_t phase = 0; phase < PHASE_COUNT; phase++)
+    {
+      total += m_totalTime[phase];
+    }
+  os << "OpenEnv profile: " << m_step << " steps, " << total << " s wall time, "
+     << m_totalEvents << " events (" << m_totalEvents / m_step << " per step)" << std::endl;
+  for (uint32_t phase = 0; phase < PHASE_COUNT; phase++)
+    {
+      os << "  " << GetPhaseName (static_cast<Phase> (phase))
+         << ": total " << m_totalTime[phase] << " s"
+         << ", mean " << m_totalTime[phase] / m_step * 1e6 << " us"
+         << ", max " << m_maxTime[phase] * 1e6 << " us"
+         << ", " << (total > 0 ? m_totalTime[phase] / total * 100 : 0) << "%" << std::endl;
+    }
+}
+
+const char*
+OpenEnvProfiler::GetPhaseName (Phase phase)
+{
+  switch (phase)
+    {
+    case SIMULATION:
+      return "simulation";
+    case COLLECT:
+      return "collect";
+    case SERIALIZE:
+      return "serialize";
+    case WAIT:
+      return "wait";
+    case ACTION:
+      return "action";
+    case ROUTE:
+      return "route";
+    default:
+      return "unknown";
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,103 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * @desc: 按step统计仿真循环各阶段的墙钟时间和仿真事件数
+ */
+
+#ifndef OPENENV_PROFILER_H
+#define OPENENV_PROFILER_H
+
+#include <stdint.h>
+#include <chrono>
+#include <cstdio>
+#include <ostream>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \brief 仿真循环的逐step剖析器
+ *
+ * 一个step从上一次与Python交互结束开始，到本次交互结束为止，依次分为：
+ *  - SIMULATION: 两次交互之间处理仿真事件（收发包等）的时间
+ *  - COLLECT:    调用GetObservation/GetReward/GetGameOver/GetExtraInfo收集状态
+ *  - SERIALIZE:  构建并序列化protobuf消息
+ *  - WAIT:       发送状态并等待Python返回动作
+ *  - ACTION:     解析动作并执行ExecuteActions（不含路由计算）
+ *  - ROUTE:      ExecuteActions中重新计算路由表的时间
+ *
+ * 时间使用单调的steady_clock，每个阶段只需读一次时钟。
+ * 每个step可以写一行CSV到trace文件，结束时打印各阶段的汇总。
+ */
+class OpenEnvProfiler
+{
+public:
+  /// 仿真循环的各阶段
+  enum Phase
+  {
+    SIMULATION = 0,
+    COLLECT,
+    SERIALIZE,
+    WAIT,
+    ACTION,
+    ROUTE,
+    PHASE_COUNT
+  };
+
+  OpenEnvProfiler ();
+  ~OpenEnvProfiler ();
+
+  /// 开始剖析
+  /// \param traceFile 逐step的CSV输出文件，为空时只统计汇总
+  void Enable (std::string traceFile);
+
+  /// \returns true if the profiler is enabled
+  bool IsEnabled (void) const;
+
+  /// 开始一个step：此前的墙钟时间计入SIMULATION，并记录仿真事件数
+  void BeginStep (void);
+
+  /// 结束当前阶段：自上一次打点以来的墙钟时间计入phase
+  /// \param phase the phase that just ended
+  void Mark (Phase phase);
+
+  /// 把一部分已计入from的时间转移到to，用于从ACTION中拆出路由计算时间
+  /// \param from the phase to take time from
+  /// \param to the phase to move time to
+  /// \param seconds wall-clock seconds to move
+  void Transfer (Phase from, Phase to, double seconds);
+
+  /// 结束当前step，写出一行trace并累加汇总
+  void EndStep (void);
+
+  /// 输出各阶段的汇总：总时间、每step平均值、最大值和占比
+  /// \param os the output stream
+  void PrintSummary (std::ostream &os) const;
+
+  /// \param phase the phase
+  /// \returns the name of the phase
+  static const char* GetPhaseName (Phase phase);
+
+private:
+  typedef std::chrono::steady_clock Clock; //!< 单调时钟
+
+  /// Defined and not implemented to avoid misuse
+  OpenEnvProfiler (OpenEnvProfiler const &);
+  /// Defined and not implemented to avoid misuse
+  /// \returns
+  OpenEnvProfiler& operator= (OpenEnvProfiler const &);
+
+  bool m_enabled;                   //!< 是否启用
+  std::FILE *m_trace;               //!< 逐step的trace文件
+  Clock::time_point m_lastMark;     //!< 上一次打点的时刻
+  uint64_t m_step;                  //!< 已完成的step数
+  uint64_t m_lastEventCount;        //!< 上一个step开始时的仿真事件数
+  uint64_t m_stepEvents;            //!< 当前step处理的仿真事件数
+  uint64_t m_totalEvents;           //!< 累计处理的仿真事件数
+  double m_stepTime[PHASE_COUNT];   //!< 当前step各阶段的时间（秒）
+  double m_totalTime[PHASE_COUNT];  //!< 各阶段的累计时间（秒）
+  double m_maxTime[PHASE_COUNT];    //!< 各阶段单个step的最大时间（秒）
+};
+
+} // namespace ns3
+
+#endif /* OPENENV_PROFILER_H */
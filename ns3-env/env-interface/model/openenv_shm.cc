@@ -0,0 +1,254 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * @desc: 基于POSIX共享内存和一对SPSC环形缓冲区的OpenEnv传输通道
+ */
+
+#include "openenv_shm.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include <google/protobuf/message_lite.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <thread>
+
+// 共享内存布局，与pyns3/shm_channel.py保持一致
+#define SHM_MAGIC (0x4853454fu) // "OESH"
+#define SHM_VERSION (1)
+#define SHM_HEADER_BYTES (64)
+#define SHM_RING_CONTROL_BYTES (128)
+#define SHM_DATA_OFFSET (SHM_HEADER_BYTES + 2 * SHM_RING_CONTROL_BYTES)
+#define RING_TAIL_OFFSET (64)
+// 帧头：帧长、消息长度、原始数组长度各4字节，dtype和元素大小各2字节
+#define FRAME_HEADER_BYTES (16)
+#define FRAME_WRAP (0xffffffffu)
+// 读空时futex等待之前的自旋次数
+#define SPIN_ITERATIONS (4096)
+// 等待Python端创建共享内存的间隔
+#define OPEN_RETRY_INTERVAL_MS (100)
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OpenEnvShmChannel");
+
+static_assert (sizeof (std::atomic<uint64_t>) == 8 && sizeof (std::atomic<uint32_t>) == 4,
+               "shared memory layout needs plain-sized atomics");
+
+/// \param value the value to align
+/// \returns value向上对齐到8字节
+static inline uint64_t
+Align8 (uint64_t value)
+{
+  return (value + 7) & ~static_cast<uint64_t> (7);
+}
+
+/// 共享内存中的futex，不能使用FUTEX_PRIVATE_FLAG
+/// \param word the futex word
+/// \param op FUTEX_WAIT or FUTEX_WAKE
+/// \param value expected value for FUTEX_WAIT, number of waiters for FUTEX_WAKE
+static inline long
+Futex (std::atomic<uint32_t> *word, int op, uint32_t value)
+{
+  return syscall (SYS_futex, reinterpret_cast<uint32_t *> (word), op, value, NULL, NULL, 0);
+}
+
+OpenEnvShmChannel::OpenEnvShmChannel ()
+  : m_base (0),
+    m_size (0),
+    m_capacity (0),
+    m_pendingTail (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+OpenEnvShmChannel::~OpenEnvShmChannel ()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_base != 0)
+    {
+      munmap (m_base, m_size);
+      m_base = 0;
+    }
+}
+
+void
+OpenEnvShmChannel::Open (std::string name)
+{
+  NS_LOG_FUNCTION (this << name);
+  NS_ABORT_MSG_IF (m_base != 0, "OpenEnvShmChannel: already open");
+
+  bool waitingLogged = false;
+  while (true)
+    {
+      int fd = shm_open (name.c_str (), O_RDWR, 0);
+      if (fd >= 0)
+        {
+          struct stat st;
+          if (fstat (fd, &st) == 0 && static_cast<uint64_t> (st.st_size) >= SHM_DATA_OFFSET)
+            {
+              uint8_t *base = static_cast<uint8_t *> (
+                  mmap (NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+              NS_ABORT_MSG_IF (base == MAP_FAILED, "OpenEnvShmChannel: cannot map " << name);
+              // Python端最后写magic，读到magic时头部已经初始化完成
+              std::atomic<uint32_t> *magic = reinterpret_cast<std::atomic<uint32_t> *> (base);
+              if (magic->load (std::memory_order_acquire) == SHM_MAGIC)
+                {
+                  close (fd);
+                  m_base = base;
+                  m_size = st.st_size;
+                  break;
+                }
+              munmap (base, st.st_size);
+            }
+          close (fd);
+        }
+      if (!waitingLogged)
+        {
+          NS_LOG_UNCOND ("Waiting for Python process to create shared memory: " << name);
+          waitingLogged = true;
+        }
+      std::this_thread::sleep_for (std::chrono::milliseconds (OPEN_RETRY_INTERVAL_MS));
+    }
+
+  uint32_t version;
+  std::memcpy (&version, m_base + 4, sizeof (version));
+  std::memcpy (&m_capacity, m_base + 8, sizeof (m_capacity));
+  NS_ABORT_MSG_IF (version != SHM_VERSION,
+                   "OpenEnvShmChannel: shared memory version " << version << ", expected " << SHM_VERSION);
+  NS_ABORT_MSG_IF (m_capacity % 8 != 0 || SHM_DATA_OFFSET + 2 * static_cast<uint64_t> (m_capacity) > m_size,
+                   "OpenEnvShmChannel: bad ring capacity " << m_capacity);
+  MapRing (0, m_tx);
+  MapRing (1, m_rx);
+  m_pendingTail = m_rx.tail->load (std::memory_order_relaxed);
+  NS_LOG_UNCOND ("Connected to Python process via shared memory: " << name
+                 << " (" << m_capacity << " bytes per ring)");
+}
+
+bool
+OpenEnvShmChannel::IsOpen (void) const
+{
+  return m_base != 0;
+}
+
+void
+OpenEnvShmChannel::MapRing (uint32_t index, Ring &ring)
+{
+  uint8_t *control = m_base + SHM_HEADER_BYTES + index * SHM_RING_CONTROL_BYTES;
+  ring.head = reinterpret_cast<std::atomic<uint64_t> *> (control);
+  ring.seq = reinterpret_cast<std::atomic<uint32_t> *> (control + 8);
+  ring.waiting = reinterpret_cast<std::atomic<uint32_t> *> (control + 12);
+  ring.tail = reinterpret_cast<std::atomic<uint64_t> *> (control + RING_TAIL_OFFSET);
+  ring.data = m_base + SHM_DATA_OFFSET + index * static_cast<uint64_t> (m_capacity);
+}
+
+void
+OpenEnvShmChannel::Send (const google::protobuf::MessageLite &msg, const void *raw, uint32_t rawBytes,
+                         uint16_t rawDtype, uint16_t rawElementSize)
+{
+  NS_LOG_FUNCTION (this << rawBytes);
+  uint32_t msgBytes = msg.ByteSize ();
+  uint64_t rawOffset = FRAME_HEADER_BYTES + Align8 (msgBytes);
+  uint64_t frameBytes = Align8 (rawOffset + rawBytes);
+  NS_ABORT_MSG_IF (frameBytes > m_capacity / 2,
+                   "OpenEnvShmChannel: message of " << frameBytes << " bytes does not fit the ring");
+
+  // 只有本端写head
+  uint64_t head = m_tx.head->load (std::memory_order_relaxed);
+  uint64_t pos = head % m_capacity;
+  uint64_t contiguous = m_capacity - pos;
+  uint64_t needed = contiguous < frameBytes ? contiguous + frameBytes : frameBytes;
+  while (m_capacity - (head - m_tx.tail->load (std::memory_order_acquire)) < needed)
+    {
+      // 锁步交互时环中最多只有一帧，这里只在Python端处理不及时时发生
+      std::this_thread::yield ();
+    }
+  if (contiguous < frameBytes)
+    {
+      uint32_t wrap = FRAME_WRAP;
+      std::memcpy (m_tx.data + pos, &wrap, sizeof (wrap));
+      head += contiguous;
+      pos = 0;
+    }
+
+  uint8_t *frame = m_tx.data + pos;
+  uint32_t header[3] = {static_cast<uint32_t> (frameBytes), msgBytes, rawBytes};
+  std::memcpy (frame, header, sizeof (header));
+  std::memcpy (frame + 12, &rawDtype, sizeof (rawDtype));
+  std::memcpy (frame + 14, &rawElementSize, sizeof (rawElementSize));
+  msg.SerializeToArray (frame + FRAME_HEADER_BYTES, msgBytes);
+  if (rawBytes > 0)
+    {
+      std::memcpy (frame + rawOffset, raw, rawBytes);
+    }
+
+  m_tx.head->store (head + frameBytes, std::memory_order_seq_cst);
+  m_tx.seq->fetch_add (1, std::memory_order_seq_cst);
+  if (m_tx.waiting->load (std::memory_order_seq_cst) != 0)
+    {
+      Futex (m_tx.seq, FUTEX_WAKE, INT_MAX);
+    }
+}
+
+void
+OpenEnvShmChannel::Receive (Frame &frame)
+{
+  NS_LOG_FUNCTION (this);
+  uint64_t tail = m_rx.tail->load (std::memory_order_relaxed);
+  while (true)
+    {
+      uint32_t spin = 0;
+      while (m_rx.head->load (std::memory_order_acquire) == tail)
+        {
+          if (++spin < SPIN_ITERATIONS)
+            {
+              continue;
+            }
+          // 先读seq再置waiting并复查head，Python端在写入之后更新seq，不会丢失唤醒
+          uint32_t seq = m_rx.seq->load (std::memory_order_seq_cst);
+          m_rx.waiting->store (1, std::memory_order_seq_cst);
+          if (m_rx.head->load (std::memory_order_seq_cst) == tail)
+            {
+              Futex (m_rx.seq, FUTEX_WAIT, seq);
+            }
+          m_rx.waiting->store (0, std::memory_order_relaxed);
+        }
+
+      uint64_t pos = tail % m_capacity;
+      uint32_t frameBytes;
+      std::memcpy (&frameBytes, m_rx.data + pos, sizeof (frameBytes));
+      if (frameBytes == FRAME_WRAP)
+        {
+          tail += m_capacity - pos;
+          continue;
+        }
+      NS_ABORT_MSG_IF (frameBytes < FRAME_HEADER_BYTES || frameBytes > m_capacity - pos,
+                       "OpenEnvShmChannel: corrupted frame of " << frameBytes << " bytes");
+
+      const uint8_t *data = m_rx.data + pos;
+      uint32_t header[3];
+      std::memcpy (header, data, sizeof (header));
+      frame.msg = data + FRAME_HEADER_BYTES;
+      frame.msgBytes = header[1];
+      frame.rawBytes = header[2];
+      std::memcpy (&frame.rawDtype, data + 12, sizeof (frame.rawDtype));
+      std::memcpy (&frame.rawElementSize, data + 14, sizeof (frame.rawElementSize));
+      frame.raw = frame.rawBytes > 0 ? data + FRAME_HEADER_BYTES + Align8 (frame.msgBytes) : 0;
+      m_pendingTail = tail + frameBytes;
+      return;
+    }
+}
+
+void
+OpenEnvShmChannel::Release (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_rx.tail->store (m_pendingTail, std::memory_order_release);
+}
+
+} // namespace ns3
@@ -0,0 +1,110 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * @desc: 基于POSIX共享内存和一对SPSC环形缓冲区的OpenEnv传输通道
+ */
+
+#ifndef OPENENV_SHM_H
+#define OPENENV_SHM_H
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+namespace google {
+namespace protobuf {
+class MessageLite;
+} // namespace protobuf
+} // namespace google
+
+namespace ns3 {
+
+/**
+ * \brief 与Python进程共享内存的传输通道
+ *
+ * 共享内存由Python端创建（pyns3/shm_channel.py），仿真端打开。布局为：
+ *  - [0, 64)：头部，magic "OESH"、版本号、每个环的容量（字节）
+ *  - [64, 192)：环0（仿真 -> Python，状态）的控制块
+ *  - [192, 320)：环1（Python -> 仿真，动作）的控制块
+ *  - [320, 320 + capacity)：环0的数据，之后是环1的数据
+ *
+ * 控制块中head（生产者累计写入的字节数）、seq（futex等待的序号）、waiting
+ * 位于第一个cache line，tail（消费者累计读出的字节数）位于第二个cache line。
+ *
+ * 每条消息是一个帧：16字节帧头（帧长、protobuf长度、原始数组长度、dtype、元素大小），
+ * 之后是protobuf序列化的消息，8字节对齐后是原始数组。帧不会跨越环尾，放不下时写一个
+ * 回绕标记从头开始，所以原始数组总是连续的，Python端可以直接用np.frombuffer映射。
+ *
+ * 读空时先自旋一段时间，再置waiting并在seq上futex等待；写入后若对端在等待则唤醒。
+ */
+class OpenEnvShmChannel
+{
+public:
+  /// 接收到的一帧，指针指向环内的数据，调用Release之前有效
+  struct Frame
+  {
+    const uint8_t *msg;     //!< protobuf序列化的消息
+    uint32_t msgBytes;      //!< 消息长度
+    const uint8_t *raw;     //!< 原始数组，没有时为0
+    uint32_t rawBytes;      //!< 原始数组的字节数
+    uint16_t rawDtype;      //!< 原始数组的ns3openenv::Dtype
+    uint16_t rawElementSize; //!< 原始数组每个元素的字节数
+  };
+
+  OpenEnvShmChannel ();
+  ~OpenEnvShmChannel ();
+
+  /// 打开Python端创建的共享内存，尚未创建或尚未初始化完成时一直等待
+  /// \param name 共享内存的名字，如 "/ns3openenv-5555"
+  void Open (std::string name);
+
+  /// \returns true if the channel is open
+  bool IsOpen (void) const;
+
+  /// 把消息直接序列化到状态环中，rawBytes非零时在其后附加原始数组
+  /// \param msg the protobuf message
+  /// \param raw 原始数组
+  /// \param rawBytes 原始数组的字节数
+  /// \param rawDtype 原始数组的ns3openenv::Dtype
+  /// \param rawElementSize 原始数组每个元素的字节数
+  void Send (const google::protobuf::MessageLite &msg, const void *raw = 0, uint32_t rawBytes = 0,
+             uint16_t rawDtype = 0, uint16_t rawElementSize = 0);
+
+  /// 等待动作环中的下一帧
+  /// \param frame 帧的内容，调用Release之前有效
+  void Receive (Frame &frame);
+
+  /// 释放Receive得到的帧，之后环中的空间可以被Python端复用
+  void Release (void);
+
+private:
+  /// Defined and not implemented to avoid misuse
+  OpenEnvShmChannel (OpenEnvShmChannel const &);
+  /// Defined and not implemented to avoid misuse
+  /// \returns
+  OpenEnvShmChannel& operator= (OpenEnvShmChannel const &);
+
+  /// 一个环在共享内存中的各字段
+  struct Ring
+  {
+    std::atomic<uint64_t> *head;     //!< 生产者累计写入的字节数
+    std::atomic<uint32_t> *seq;      //!< 每写入一帧加一，futex在它上面等待
+    std::atomic<uint32_t> *waiting;  //!< 消费者正在futex等待
+    std::atomic<uint64_t> *tail;     //!< 消费者累计读出的字节数
+    uint8_t *data;                   //!< 环的数据区
+  };
+
+  /// \param index 0为状态环，1为动作环
+  /// \param ring the ring to fill
+  void MapRing (uint32_t index, Ring &ring);
+
+  uint8_t *m_base;        //!< 共享内存的起始地址
+  uint64_t m_size;        //!< 共享内存的大小
+  uint32_t m_capacity;    //!< 每个环的容量
+  Ring m_tx;              //!< 状态环，本端为生产者
+  Ring m_rx;              //!< 动作环，本端为消费者
+  uint64_t m_pendingTail; //!< Release时写回的tail
+};
+
+} // namespace ns3
+
+#endif /* OPENENV_SHM_H */
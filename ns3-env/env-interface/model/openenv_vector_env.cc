@@ -0,0 +1,282 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * @desc: 在一个ns-3进程中把K个独立的环境合并为一个向量化环境，共用一个OpenEnvInterface
+ */
+
+#include "openenv_vector_env.h"
+#include "openenv_interface.h"
+#include "container.h"
+#include "spaces.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OpenEnvVectorEnv");
+
+NS_OBJECT_ENSURE_REGISTERED (OpenEnvVectorEnv);
+
+TypeId
+OpenEnvVectorEnv::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("OpenEnvVectorEnv")
+    .SetParent<OpenEnvAbstract> ()
+    .SetGroupName ("OpenEnv")
+    .AddConstructor<OpenEnvVectorEnv> ()
+    ;
+  return tid;
+}
+
+OpenEnvVectorEnv::OpenEnvVectorEnv ()
+  : m_pending (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+OpenEnvVectorEnv::~OpenEnvVectorEnv ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+OpenEnvVectorEnv::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<Ptr<OpenEnvAbstract> >::iterator iter = m_envs.begin (); iter != m_envs.end (); iter++)
+    {
+      (*iter)->m_vectorEnv = 0;
+    }
+  m_envs.clear ();
+  m_obsBox = 0;
+  m_actBoxes.clear ();
+  OpenEnvAbstract::DoDispose ();
+}
+
+void
+OpenEnvVectorEnv::AddEnv (Ptr<OpenEnvAbstract> env)
+{
+  NS_LOG_FUNCTION (this << env);
+  NS_ABORT_MSG_IF (env->m_vectorEnv != 0, "OpenEnvVectorEnv: environment already belongs to a vector env");
+  NS_ABORT_MSG_IF (env->m_openEnvInterface != 0,
+                   "OpenEnvVectorEnv: sub-environment must not be connected to an OpenEnvInterface");
+  env->m_vectorEnv = this;
+  m_envs.push_back (env);
+  m_notified.push_back (false);
+  m_rewards.push_back (0);
+  m_gameOver.push_back (false);
+  m_actBoxes.push_back (0);
+  m_pending++;
+}
+
+uint32_t
+OpenEnvVectorEnv::GetNEnvs (void) const
+{
+  return m_envs.size ();
+}
+
+Ptr<OpenEnvAbstract>
+OpenEnvVectorEnv::GetEnv (uint32_t index) const
+{
+  NS_ASSERT (index < m_envs.size ());
+  return m_envs[index];
+}
+
+void
+OpenEnvVectorEnv::SetOpenEnvInterface (Ptr<OpenEnvInterface> openEnvInterface)
+{
+  NS_LOG_FUNCTION (this);
+  OpenEnvAbstract::SetOpenEnvInterface (openEnvInterface);
+  openEnvInterface->SetGetNumEnvsCb (MakeCallback (&OpenEnvVectorEnv::GetNEnvs, this));
+  openEnvInterface->SetGetEnvRewardCb (MakeCallback (&OpenEnvVectorEnv::GetEnvReward, this));
+  openEnvInterface->SetGetEnvGameOverCb (MakeCallback (&OpenEnvVectorEnv::GetEnvGameOver, this));
+}
+
+void
+OpenEnvVectorEnv::NotifyEnv (Ptr<OpenEnvAbstract> env)
+{
+  NS_LOG_FUNCTION (this << env);
+  uint32_t index = std::find (m_envs.begin (), m_envs.end (), env) - m_envs.begin ();
+  NS_ASSERT (index < m_envs.size ());
+  // 子环境的step时间相同，一轮中每个子环境只报告一次
+  NS_ABORT_MSG_IF (m_notified[index],
+                   "OpenEnvVectorEnv: environment " << index << " notified twice in one round, "
+                   "sub-environments must use the same step time");
+  m_notified[index] = true;
+  if (--m_pending > 0)
+    {
+      return;
+    }
+  std::fill (m_notified.begin (), m_notified.end (), false);
+  m_pending = m_envs.size ();
+  Notify ();
+}
+
+Ptr<OpenEnvSpace>
+OpenEnvVectorEnv::BatchSpace (Ptr<OpenEnvSpace> space)
+{
+  Ptr<OpenEnvBoxSpace> box = DynamicCast<OpenEnvBoxSpace> (space);
+  NS_ABORT_MSG_IF (box == 0, "OpenEnvVectorEnv: only Box spaces can be batched");
+  std::vector<uint32_t> shape = box->GetShape ();
+  shape.insert (shape.begin (), m_envs.size ());
+  return CreateObject<OpenEnvBoxSpace> (box->GetLow (), box->GetHigh (), shape, box->GetDtypeName ());
+}
+
+Ptr<OpenEnvSpace>
+OpenEnvVectorEnv::GetActionSpace ()
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (m_envs.empty (), "OpenEnvVectorEnv: no sub-environment");
+  return BatchSpace (m_envs[0]->GetActionSpace ());
+}
+
+Ptr<OpenEnvSpace>
+OpenEnvVectorEnv::GetObservationSpace ()
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (m_envs.empty (), "OpenEnvVectorEnv: no sub-environment");
+  return BatchSpace (m_envs[0]->GetObservationSpace ());
+}
+
+bool
+OpenEnvVectorEnv::GetGameOver ()
+{
+  NS_LOG_FUNCTION (this);
+  bool allOver = true;
+  for (uint32_t index = 0; index < m_envs.size (); index++)
+    {
+      m_gameOver[index] = m_envs[index]->GetGameOver ();
+      allOver = allOver && m_gameOver[index];
+    }
+  return allOver;
+}
+
+Ptr<OpenEnvDataContainer>
+OpenEnvVectorEnv::GetObservation ()
+{
+  NS_LOG_FUNCTION (this);
+  const void *data;
+  uint32_t bytes = 0, elementSize = 0, envBytes = 0;
+  ns3openenv::Dtype dtype = ns3openenv::NoDType, envDtype = ns3openenv::NoDType;
+  std::vector<uint32_t> shape;
+  for (uint32_t index = 0; index < m_envs.size (); index++)
+    {
+      Ptr<OpenEnvDataContainer> obs = m_envs[index]->GetObservation ();
+      NS_ABORT_MSG_IF (obs == 0 || !obs->GetRawBuffer (&data, &bytes, &dtype, &elementSize),
+                       "OpenEnvVectorEnv: environment " << index << " did not return a Box observation");
+      if (index == 0)
+        {
+          envBytes = bytes;
+          envDtype = dtype;
+          shape = obs->GetShape ();
+          // 大小不变时resize不会重新分配
+          m_obsBytes.resize (static_cast<size_t> (envBytes) * m_envs.size ());
+        }
+      NS_ABORT_MSG_IF (bytes != envBytes || dtype != envDtype,
+                       "OpenEnvVectorEnv: observation of environment " << index << " does not match environment 0");
+      std::memcpy (m_obsBytes.data () + static_cast<size_t> (index) * envBytes, data, bytes);
+    }
+
+  if (!m_obsBox || !m_obsBox->SetFromRawBuffer (envDtype, elementSize, m_obsBytes.data (), m_obsBytes.size ()))
+    {
+      shape.insert (shape.begin (), m_envs.size ());
+      m_obsBox = OpenEnvDataContainer::CreateFromRawBuffer (envDtype, elementSize, m_obsBytes.data (),
+                                                            m_obsBytes.size (), shape);
+      NS_ABORT_MSG_IF (m_obsBox == 0, "OpenEnvVectorEnv: unsupported observation dtype " << envDtype);
+    }
+  return m_obsBox;
+}
+
+float
+OpenEnvVectorEnv::GetReward ()
+{
+  NS_LOG_FUNCTION (this);
+  float sum = 0;
+  for (uint32_t index = 0; index < m_envs.size (); index++)
+    {
+      m_rewards[index] = m_envs[index]->GetReward ();
+      sum += m_rewards[index];
+    }
+  return m_envs.empty () ? 0 : sum / m_envs.size ();
+}
+
+float
+OpenEnvVectorEnv::GetEnvReward (uint32_t index)
+{
+  return m_rewards[index];
+}
+
+bool
+OpenEnvVectorEnv::GetEnvGameOver (uint32_t index)
+{
+  return m_gameOver[index];
+}
+
+std::string
+OpenEnvVectorEnv::GetExtraInfo ()
+{
+  NS_LOG_FUNCTION (this);
+  std::string info;
+  for (uint32_t index = 0; index < m_envs.size (); index++)
+    {
+      if (index > 0)
+        {
+          info += ";";
+        }
+      info += m_envs[index]->GetExtraInfo ();
+    }
+  return info;
+}
+
+bool
+OpenEnvVectorEnv::ExecuteActions (Ptr<OpenEnvDataContainer> action)
+{
+  NS_LOG_FUNCTION (this);
+  const void *data;
+  uint32_t bytes, elementSize;
+  ns3openenv::Dtype dtype;
+  if (action == 0 || !action->GetRawBuffer (&data, &bytes, &dtype, &elementSize))
+    {
+      NS_LOG_WARN ("OpenEnvVectorEnv: only Box actions can be split between environments");
+      return false;
+    }
+  uint32_t envBytes = bytes / m_envs.size ();
+  if (envBytes * m_envs.size () != bytes || envBytes % elementSize != 0)
+    {
+      NS_LOG_WARN ("OpenEnvVectorEnv: action of " << bytes << " bytes cannot be split into "
+                   << m_envs.size () << " environments");
+      return false;
+    }
+
+  bool reply = true;
+  for (uint32_t index = 0; index < m_envs.size (); index++)
+    {
+      const uint8_t *envData = static_cast<const uint8_t *> (data) + static_cast<size_t> (index) * envBytes;
+      // 每个子环境复用自己的动作容器，dtype变化时重新创建
+      Ptr<OpenEnvDataContainer> &envAction = m_actBoxes[index];
+      if (!envAction || !envAction->SetFromRawBuffer (dtype, elementSize, envData, envBytes))
+        {
+          envAction = OpenEnvDataContainer::CreateFromRawBuffer (dtype, elementSize, envData, envBytes);
+        }
+      reply = m_envs[index]->ExecuteActions (envAction) && reply;
+    }
+  return reply;
+}
+
+bool
+OpenEnvVectorEnv::Reset ()
+{
+  NS_LOG_FUNCTION (this);
+  bool reply = true;
+  for (uint32_t index = 0; index < m_envs.size (); index++)
+    {
+      reply = m_envs[index]->Reset () && reply;
+    }
+  // 在一轮中途reset时丢弃已经报告的子环境
+  std::fill (m_notified.begin (), m_notified.end (), false);
+  m_pending = m_envs.size ();
+  return reply;
+}
+
+} // namespace ns3
@@ -0,0 +1,92 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * @desc: 在一个ns-3进程中把K个独立的环境合并为一个向量化环境，共用一个OpenEnvInterface
+ */
+
+#ifndef OPENENV_VECTOR_ENV_H
+#define OPENENV_VECTOR_ENV_H
+
+#include "openenv_abstract.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief K个子环境组成的向量化环境
+ *
+ * 子环境各自拥有节点、路由和FlowMonitor，通过AddEnv加入后不再直接连接OpenEnvInterface，
+ * 而是在Notify时向本对象报告。所有子环境都报告之后（它们使用相同的step时间），本对象作为一个
+ * 环境与Python交互一次：
+ *  - 观测空间和动作空间是子环境的Box空间加上最前面的一维K，观测按子环境顺序拼接为[K × obs]；
+ *  - 收到的[K × act]动作按子环境切分，每个子环境复用自己的动作容器；
+ *  - reward为各子环境奖励的平均值，isGameOver在所有子环境都结束时为true，逐个子环境的奖励和
+ *    结束标志通过EnvStateMsg的envReward和envGameOver发送；
+ *  - info为各子环境的info，以';'分隔。
+ *
+ * 只支持Box观测和动作，且所有子环境的空间必须相同。
+ */
+class OpenEnvVectorEnv : public OpenEnvAbstract
+{
+public:
+  OpenEnvVectorEnv ();
+  virtual ~OpenEnvVectorEnv ();
+
+  static TypeId GetTypeId ();
+
+  /// 加入一个子环境，必须在仿真开始之前调用
+  /// \param env 子环境，不要再对它调用SetOpenEnvInterface
+  void AddEnv (Ptr<OpenEnvAbstract> env);
+
+  /// \returns 子环境数K
+  uint32_t GetNEnvs (void) const;
+
+  /// \param index 子环境的序号
+  /// \returns 第index个子环境
+  Ptr<OpenEnvAbstract> GetEnv (uint32_t index) const;
+
+  /// 子环境在Notify时调用，K个子环境都报告之后与Python交互一次
+  /// \param env 报告的子环境
+  void NotifyEnv (Ptr<OpenEnvAbstract> env);
+
+  virtual void SetOpenEnvInterface (Ptr<OpenEnvInterface> openEnvInterface);
+
+  Ptr<OpenEnvSpace> GetActionSpace ();
+  Ptr<OpenEnvSpace> GetObservationSpace ();
+  bool GetGameOver ();
+  Ptr<OpenEnvDataContainer> GetObservation ();
+  float GetReward ();
+  std::string GetExtraInfo ();
+  bool ExecuteActions (Ptr<OpenEnvDataContainer> action);
+  /// 所有子环境都reset成功时返回true
+  virtual bool Reset ();
+
+  /// \param index 子环境的序号
+  /// \returns 第index个子环境最近一次GetReward的结果
+  float GetEnvReward (uint32_t index);
+
+  /// \param index 子环境的序号
+  /// \returns 第index个子环境最近一次GetGameOver的结果
+  bool GetEnvGameOver (uint32_t index);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// 在子环境的Box空间前面加上一维K
+  /// \param space 子环境的空间
+  /// \returns 向量化之后的空间
+  Ptr<OpenEnvSpace> BatchSpace (Ptr<OpenEnvSpace> space);
+
+  std::vector<Ptr<OpenEnvAbstract> > m_envs;        //!< 子环境
+  std::vector<bool> m_notified;                      //!< 本轮已经报告的子环境
+  uint32_t m_pending;                                //!< 本轮还没有报告的子环境数
+  std::vector<float> m_rewards;                      //!< 各子环境本step的奖励
+  std::vector<bool> m_gameOver;                      //!< 各子环境本step是否结束
+  std::vector<uint8_t> m_obsBytes;                   //!< 拼接观测的缓冲区
+  Ptr<OpenEnvDataContainer> m_obsBox;                //!< 复用的[K × obs]观测
+  std::vector<Ptr<OpenEnvDataContainer> > m_actBoxes; //!< 各子环境复用的动作容器
+};
+
+} // namespace ns3
+
+#endif /* OPENENV_VECTOR_ENV_H */
@@ -212,6 +212,13 @@ OpenEnvBoxSpace::GetShape()
   return m_shape;
 }
 
+std::string
+OpenEnvBoxSpace::GetDtypeName()
+{
+  NS_LOG_FUNCTION (this);
+  return m_dtypeName;
+}
+
 ns3openenv::SpaceDescription
 OpenEnvBoxSpace::GetSpaceDescription()
 {
@@ -87,6 +87,7 @@ public:
   float GetLow();
   float GetHigh();
   std::vector<uint32_t> GetShape();
+  std::string GetDtypeName();
 
   virtual void Print(std::ostream& where) const;
   friend std::ostream& operator<< (std::ostream& os, const Ptr<OpenEnvBoxSpace> space)
@@ -0,0 +1,389 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * @desc: 测试OpenEnvInterface稳态下收发状态和动作消息不分配堆内存，以及进程内策略的前向计算
+ */
+
+// 测试OpenEnvInterface每个step复用消息和缓冲区的效果。
+//
+// OpenEnvInterfaceAllocTestCase 介绍
+//
+//      在OpenEnvInterface的ZMQ context上bind一个inproc的REP socket，由另一个线程扮演Python端：
+//      握手时启用RawBoxContainer，之后每个step检查收到的状态，交替回复两条预先序列化好的动作消息。
+//      仿真端只通过公开接口驱动：设置Endpoint属性和回调，逐个调用NotifyCurrentState，
+//      最后NotifySimulationEnd。观测为每个step原地更新的1000维uint32 Box，动作为100维float RawBox。
+//
+//      a. 测试内存分配:      前几个step让消息、发送缓冲区和动作容器达到稳定大小，之后统计仿真线程上
+//                            operator new的调用次数，应该为0。计数是线程局部的，只在这些step中开启，
+//                            扮演Python端的线程和同一进程中的其他测试不受影响
+//      b. 测试消息内容:      Python端收到的obsRaw应该与观测一致；
+//                            动作回调收到的容器应该是同一个，内容与最后一条动作消息一致
+//
+// OpenEnvMlpPolicyTestCase 介绍
+//
+//      写出一个3输入、5个ReLU隐藏单元、6个softmax输出的策略文件（输出维度不是4的倍数），
+//      对2行uint32观测计算动作，与直接按行计算的结果比较，并检查动作的形状和倍率。
+//
+#include "ns3/core-module.h"
+#include "ns3/test.h"
+#include "ns3/openenv_interface.h"
+#include "ns3/openenv_policy.h"
+#include "ns3/container.h"
+#include "ns3/messages.pb.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <zmq.hpp>
+
+// 当前线程开启计数期间operator new的调用次数，其他线程和计数关闭时只转发给malloc
+static thread_local bool g_countAllocations = false;
+static thread_local uint32_t g_allocations = 0;
+
+void*
+operator new (std::size_t size)
+{
+  if (g_countAllocations)
+    {
+      g_allocations++;
+    }
+  void *ptr = std::malloc (size == 0 ? 1 : size);
+  if (ptr == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return ptr;
+}
+
+void*
+operator new[] (std::size_t size)
+{
+  return operator new (size);
+}
+
+void
+operator delete (void *ptr) noexcept
+{
+  std::free (ptr);
+}
+
+void
+operator delete[] (void *ptr) noexcept
+{
+  std::free (ptr);
+}
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("OpenEnvInterfaceTestSuite");
+
+// 观测和动作的元素数，热身和稳态的step数
+static const uint32_t OBS_SIZE = 1000;
+static const uint32_t ACT_SIZE = 100;
+static const uint32_t WARMUP_STEPS = 3;
+static const uint32_t STEPS = 100;
+
+/**
+ * \ingroup openenv
+ * \ingroup tests
+ *
+ * \brief 检测稳态下一个step是否分配堆内存
+ */
+class OpenEnvInterfaceAllocTestCase : public TestCase
+{
+public:
+  OpenEnvInterfaceAllocTestCase ();
+  virtual void DoRun (void);
+
+private:
+  Ptr<OpenEnvDataContainer> GetObservation (void);
+  bool ExecuteActions (Ptr<OpenEnvDataContainer> action);
+  /// 扮演Python端，在单独的线程中运行
+  /// \param socket 已经bind的REP socket
+  void RunAgent (zmq::socket_t *socket);
+  /// 检查Python端收到的第step个状态
+  /// \returns 错误描述，正确时为空
+  std::string CheckState (const ns3openenv::EnvStateMsg &stateMsg, uint32_t step);
+
+  Ptr<OpenEnvBoxContainer<uint32_t> > m_obs;
+  Ptr<OpenEnvDataContainer> m_action;
+  uint32_t m_step;
+  std::string m_actWire[2];           //!< Python端交替回复的动作消息
+  std::string m_agentError;           //!< Python端发现的第一个错误，由RunAgent写入，join之后读取
+};
+
+OpenEnvInterfaceAllocTestCase::OpenEnvInterfaceAllocTestCase ()
+  : TestCase ("OpenEnvInterfaceAllocTestCase"),
+    m_step (0)
+{
+}
+
+Ptr<OpenEnvDataContainer>
+OpenEnvInterfaceAllocTestCase::GetObservation (void)
+{
+  uint32_t *data = m_obs->GetRawData ();
+  for (uint32_t i = 0; i < m_obs->GetSize (); i++)
+    {
+      data[i] = m_step * i;
+    }
+  return m_obs;
+}
+
+bool
+OpenEnvInterfaceAllocTestCase::ExecuteActions (Ptr<OpenEnvDataContainer> action)
+{
+  m_action = action;
+  return true;
+}
+
+void
+OpenEnvInterfaceAllocTestCase::RunAgent (zmq::socket_t *socket)
+{
+  zmq::message_t request;
+  socket->recv (&request);
+  ns3openenv::SimInitMsg simInitMsg;
+  if (!simInitMsg.ParseFromArray (request.data (), request.size ()) || !simInitMsg.rawboxsupported ())
+    {
+      m_agentError = "握手消息错误";
+    }
+  ns3openenv::SimInitAck simInitAck;
+  simInitAck.set_done (true);
+  simInitAck.set_rawboxenabled (true);
+  std::string ackWire = simInitAck.SerializeAsString ();
+  zmq_send ((void*)*socket, ackWire.data (), ackWire.size (), 0);
+
+  ns3openenv::EnvStateMsg stateMsg;
+  for (uint32_t step = 0; ; step++)
+    {
+      socket->recv (&request);
+      if (!stateMsg.ParseFromArray (request.data (), request.size ()))
+        {
+          m_agentError = "不是合法的EnvStateMsg";
+        }
+      if (stateMsg.isgameover ())
+        {
+          // 仿真结束的状态，回复一条空的动作消息后退出
+          zmq_send ((void*)*socket, "", 0, 0);
+          break;
+        }
+      if (m_agentError.empty ())
+        {
+          m_agentError = CheckState (stateMsg, step);
+        }
+      const std::string &wire = m_actWire[step % 2];
+      zmq_send ((void*)*socket, wire.data (), wire.size (), 0);
+    }
+}
+
+std::string
+OpenEnvInterfaceAllocTestCase::CheckState (const ns3openenv::EnvStateMsg &stateMsg, uint32_t step)
+{
+  if (stateMsg.has_obsdata ())
+    {
+      return "启用RawBox时不应发送obsData";
+    }
+  const ns3openenv::RawBoxContainer &obsRaw = stateMsg.obsraw ();
+  if (obsRaw.dtype () != ns3openenv::UINT || obsRaw.shape_size () != 1 || obsRaw.shape (0) != OBS_SIZE
+      || obsRaw.data ().size () != OBS_SIZE * sizeof (uint32_t))
+    {
+      return "obsRaw的dtype、shape或长度错误";
+    }
+  const uint32_t *obsData = reinterpret_cast<const uint32_t *> (obsRaw.data ().data ());
+  for (uint32_t i = 0; i < OBS_SIZE; i++)
+    {
+      if (obsData[i] != step * i)
+        {
+          return "obsRaw的内容与观测不一致";
+        }
+    }
+  return "";
+}
+
+void
+OpenEnvInterfaceAllocTestCase::DoRun (void)
+{
+  std::vector<uint32_t> shape (1, OBS_SIZE);
+  m_obs = CreateObject<OpenEnvBoxContainer<uint32_t> > (shape);
+  m_obs->Resize (OBS_SIZE);
+
+  // 两条交替发送的动作消息，检查容器被原地更新
+  for (uint32_t k = 0; k < 2; k++)
+    {
+      std::vector<float> act (ACT_SIZE, 0.5f + k);
+      ns3openenv::EnvActMsg actMsg;
+      actMsg.mutable_actraw ()->set_dtype (ns3openenv::FLOAT);
+      actMsg.mutable_actraw ()->add_shape (ACT_SIZE);
+      actMsg.mutable_actraw ()->set_data (act.data (), act.size () * sizeof (float));
+      m_actWire[k] = actMsg.SerializeAsString ();
+    }
+
+  Ptr<OpenEnvInterface> openEnv = CreateObject<OpenEnvInterface> ();
+  openEnv->SetAttribute ("Endpoint", StringValue ("inproc://openenv-interface-test"));
+  openEnv->SetGetObservationCb (MakeCallback (&OpenEnvInterfaceAllocTestCase::GetObservation, this));
+  openEnv->SetExecuteActionsCb (MakeCallback (&OpenEnvInterfaceAllocTestCase::ExecuteActions, this));
+
+  // inproc的endpoint只在同一个context内可见，先bind再由Init connect
+  zmq::socket_t agent (openEnv->GetZmqContext (), ZMQ_REP);
+  agent.bind ("inproc://openenv-interface-test");
+  std::thread agentThread (&OpenEnvInterfaceAllocTestCase::RunAgent, this, &agent);
+
+  Ptr<OpenEnvDataContainer> firstAction;
+  for (m_step = 0; m_step < WARMUP_STEPS + STEPS; m_step++)
+    {
+      if (m_step == WARMUP_STEPS)
+        {
+          firstAction = m_action;
+          g_allocations = 0;
+          g_countAllocations = true;
+        }
+      openEnv->NotifyCurrentState ();
+    }
+  g_countAllocations = false;
+  openEnv->NotifySimulationEnd ();
+  agentThread.join ();
+  agent.close ();
+  m_step = WARMUP_STEPS + STEPS - 1;
+
+  NS_TEST_ASSERT_MSG_EQ (m_agentError, "", "Error: Python端收到的状态错误");
+  NS_TEST_ASSERT_MSG_EQ (g_allocations, 0, "Error: 稳态下的" << STEPS << "个step分配了堆内存");
+
+  NS_TEST_ASSERT_MSG_EQ (m_action, firstAction, "Error: 动作容器没有被复用");
+  Ptr<OpenEnvBoxContainer<float> > action = DynamicCast<OpenEnvBoxContainer<float> > (m_action);
+  NS_TEST_ASSERT_MSG_NE (action, 0, "Error: 动作容器类型错误");
+  NS_TEST_ASSERT_MSG_EQ (action->GetSize (), ACT_SIZE, "Error: 动作的长度错误");
+  NS_TEST_ASSERT_MSG_EQ (action->GetValue (0), 0.5f + m_step % 2, "Error: 动作的内容错误");
+
+  m_action = 0;
+  firstAction = 0;
+  m_obs = 0;
+  openEnv->Dispose ();
+}
+
+/**
+ * \ingroup openenv
+ * \ingroup tests
+ *
+ * \brief 检测OpenEnvMlpPolicy加载策略文件并正确计算动作
+ */
+class OpenEnvMlpPolicyTestCase : public TestCase
+{
+public:
+  OpenEnvMlpPolicyTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+OpenEnvMlpPolicyTestCase::OpenEnvMlpPolicyTestCase ()
+  : TestCase ("Check the forward pass of an exported MLP policy")
+{
+}
+
+void
+OpenEnvMlpPolicyTestCase::DoRun (void)
+{
+  const uint32_t IN = 3, HIDDEN = 5, OUT = 6, ROWS = 2;
+  const float SCALE = 12;
+  float w1[HIDDEN][IN], b1[HIDDEN], w2[OUT][HIDDEN], b2[OUT];
+  for (uint32_t h = 0; h < HIDDEN; h++)
+    {
+      for (uint32_t i = 0; i < IN; i++)
+        {
+          w1[h][i] = 0.1f * (h + 1) - 0.2f * i;
+        }
+      b1[h] = 0.05f * h - 0.1f;
+    }
+  for (uint32_t o = 0; o < OUT; o++)
+    {
+      for (uint32_t h = 0; h < HIDDEN; h++)
+        {
+          w2[o][h] = 0.03f * (o + 1) * (h % 2 ? -1.0f : 1.0f);
+        }
+      b2[o] = 0.01f * o;
+    }
+
+  // 与RLAgent/AgentDDPG.py的write_policy相同的格式
+  std::string fileName = CreateTempDirFilename ("policy.bin");
+  FILE *file = std::fopen (fileName.c_str (), "wb");
+  NS_TEST_ASSERT_MSG_NE (file, 0, "Error: 无法创建策略文件");
+  uint32_t header[3] = {0x504d454f, 1, 2};
+  uint32_t layer1[3] = {IN, HIDDEN, OpenEnvMlpPolicy::RELU};
+  uint32_t layer2[3] = {HIDDEN, OUT, OpenEnvMlpPolicy::SOFTMAX};
+  std::fwrite (header, sizeof (header), 1, file);
+  std::fwrite (&SCALE, sizeof (SCALE), 1, file);
+  std::fwrite (layer1, sizeof (layer1), 1, file);
+  std::fwrite (w1, sizeof (w1), 1, file);
+  std::fwrite (b1, sizeof (b1), 1, file);
+  std::fwrite (layer2, sizeof (layer2), 1, file);
+  std::fwrite (w2, sizeof (w2), 1, file);
+  std::fwrite (b2, sizeof (b2), 1, file);
+  std::fclose (file);
+
+  OpenEnvMlpPolicy policy;
+  NS_TEST_ASSERT_MSG_EQ (policy.Load (fileName), true, "Error: 策略文件加载失败");
+  NS_TEST_ASSERT_MSG_EQ (policy.GetInputSize (), IN, "Error: 输入维度错误");
+  NS_TEST_ASSERT_MSG_EQ (policy.GetOutputSize (), OUT, "Error: 输出维度错误");
+
+  Ptr<OpenEnvBoxContainer<uint32_t> > obs = CreateObject<OpenEnvBoxContainer<uint32_t> > ();
+  for (uint32_t i = 0; i < ROWS * IN; i++)
+    {
+      obs->AddValue (i);
+    }
+  Ptr<OpenEnvBoxContainer<float> > action = DynamicCast<OpenEnvBoxContainer<float> > (policy.ComputeAction (obs));
+  NS_TEST_ASSERT_MSG_NE (action, 0, "Error: 没有得到float动作");
+  NS_TEST_ASSERT_MSG_EQ (action->GetShape ().size (), 2u, "Error: 按行计算的动作应该是二维的");
+  NS_TEST_ASSERT_MSG_EQ (action->GetShape ()[0], ROWS, "Error: 动作的行数错误");
+  NS_TEST_ASSERT_MSG_EQ (action->GetSize (), ROWS * OUT, "Error: 动作的长度错误");
+
+  for (uint32_t row = 0; row < ROWS; row++)
+    {
+      double hidden[HIDDEN], logits[OUT], sum = 0;
+      for (uint32_t h = 0; h < HIDDEN; h++)
+        {
+          hidden[h] = b1[h];
+          for (uint32_t i = 0; i < IN; i++)
+            {
+              hidden[h] += w1[h][i] * (row * IN + i);
+            }
+          hidden[h] = std::max (hidden[h], 0.0);
+        }
+      for (uint32_t o = 0; o < OUT; o++)
+        {
+          logits[o] = b2[o];
+          for (uint32_t h = 0; h < HIDDEN; h++)
+            {
+              logits[o] += w2[o][h] * hidden[h];
+            }
+          sum += std::exp (logits[o]);
+        }
+      for (uint32_t o = 0; o < OUT; o++)
+        {
+          NS_TEST_ASSERT_MSG_EQ_TOL (action->GetValue (row * OUT + o), SCALE * std::exp (logits[o]) / sum, 1e-4,
+                                     "Error: 第" << row << "行第" << o << "个动作错误");
+        }
+    }
+}
+
+/**
+ * \ingroup openenv
+ * \ingroup tests
+ *
+ * \brief OpenEnvInterface TestSuite
+ */
+class OpenEnvInterfaceTestSuite : public TestSuite
+{
+public:
+  OpenEnvInterfaceTestSuite ();
+};
+
+OpenEnvInterfaceTestSuite::OpenEnvInterfaceTestSuite ()
+  : TestSuite ("openenv-interface", UNIT)
+{
+  AddTestCase (new OpenEnvInterfaceAllocTestCase, TestCase::QUICK);
+  AddTestCase (new OpenEnvMlpPolicyTestCase, TestCase::QUICK);
+}
+
+static OpenEnvInterfaceTestSuite g_openEnvInterfaceTestSuite; //!< Static variable for test initialization
+
+} // namespace ns3
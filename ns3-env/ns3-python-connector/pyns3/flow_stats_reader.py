@@ -0,0 +1,99 @@
+#!/usr/bin/env python
+# coding=utf-8
+"""
+@desc: 读取FlowStatsWriter写出的二进制统计文件，并转换为CSV
+
+用法:
+    python -m pyns3.flow_stats_reader stats.bin --flows flows.csv --links links.csv
+"""
+
+import argparse
+import csv
+import struct
+
+MAGIC = b'RLFS'
+SUPPORTED_VERSIONS = (1,)
+
+FILE_HEADER = struct.Struct('<4sHH')
+STEP_HEADER = struct.Struct('<QqdII')
+FLOW_RECORD = struct.Struct('<IIIIIQQqq')
+LINK_RECORD = struct.Struct('<IIQQIIqqqq')
+
+FLOW_FIELDS = ('flowId', 'txPackets', 'rxPackets', 'lostPackets', 'timesForwarded',
+               'txBytes', 'rxBytes', 'delaySumNs', 'jitterSumNs')
+LINK_FIELDS = ('nodeId', 'interface', 'packets', 'bytes', 'delayCount', 'queueCount',
+               'delaySumNs', 'delayMaxNs', 'queueDelaySumNs', 'queueDelayMaxNs')
+STEP_FIELDS = ('step', 'timeNs', 'samplingScale')
+
+
+def _read_exact(f, size):
+    data = f.read(size)
+    if len(data) != size:
+        raise EOFError('truncated flow stats file')
+    return data
+
+
+def read_flow_stats(path):
+    """逐step读取统计文件
+
+    @param path: FlowStatsWriter写出的文件路径
+    @return: 生成器，每个元素为 (step头dict, flow记录list, link记录list)
+    """
+    with open(path, 'rb') as f:
+        magic, version, _ = FILE_HEADER.unpack(_read_exact(f, FILE_HEADER.size))
+        if magic != MAGIC:
+            raise ValueError(f'{path} is not a flow stats file')
+        if version not in SUPPORTED_VERSIONS:
+            raise ValueError(f'unsupported flow stats version {version}')
+
+        while True:
+            head = f.read(STEP_HEADER.size)
+            if not head:
+                break
+            if len(head) != STEP_HEADER.size:
+                raise EOFError('truncated flow stats file')
+            step, time_ns, scale, n_flows, n_links = STEP_HEADER.unpack(head)
+            step_info = dict(zip(STEP_FIELDS, (step, time_ns, scale)))
+
+            flows_raw = _read_exact(f, FLOW_RECORD.size * n_flows)
+            flows = [dict(zip(FLOW_FIELDS, rec)) for rec in FLOW_RECORD.iter_unpack(flows_raw)]
+            links_raw = _read_exact(f, LINK_RECORD.size * n_links)
+            links = [dict(zip(LINK_FIELDS, rec)) for rec in LINK_RECORD.iter_unpack(links_raw)]
+            yield step_info, flows, links
+
+
+def to_csv(path, flows_csv=None, links_csv=None):
+    """把统计文件转换为flow和link两个CSV，每行都带有step信息"""
+    flow_file = open(flows_csv, 'w', newline='') if flows_csv else None
+    link_file = open(links_csv, 'w', newline='') if links_csv else None
+    try:
+        flow_writer = csv.DictWriter(flow_file, STEP_FIELDS + FLOW_FIELDS) if flow_file else None
+        link_writer = csv.DictWriter(link_file, STEP_FIELDS + LINK_FIELDS) if link_file else None
+        if flow_writer:
+            flow_writer.writeheader()
+        if link_writer:
+            link_writer.writeheader()
+
+        for step_info, flows, links in read_flow_stats(path):
+            if flow_writer:
+                for flow in flows:
+                    flow.update(step_info)
+                    flow_writer.writerow(flow)
+            if link_writer:
+                for link in links:
+                    link.update(step_info)
+                    link_writer.writerow(link)
+    finally:
+        if flow_file:
+            flow_file.close()
+        if link_file:
+            link_file.close()
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='将FlowStatsWriter的二进制文件转换为CSV')
+    parser.add_argument('path', type=str, help='二进制统计文件')
+    parser.add_argument('--flows', default='flows.csv', type=str, help='flow统计输出的CSV')
+    parser.add_argument('--links', default='links.csv', type=str, help='链路统计输出的CSV')
+    args = parser.parse_args()
+    to_csv(args.path, args.flows, args.links)
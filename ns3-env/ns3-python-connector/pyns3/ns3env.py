@@ -2,6 +2,8 @@ import os
 import sys
 import zmq
 import time
+import signal
+import socket
 
 import numpy as np
 
@@ -19,7 +21,16 @@ from google.protobuf.any_pb2 import Any
 class Ns3ZmqBridge(object):
     """docstring for Ns3ZmqBridge"""
 
-    def __init__(self, simScriptName=None, port=0, startSim=True, simSeed=0, simArgs={}, debug=False):
+    # (ns3openenv::Dtype, 元素大小) -> numpy dtype，与OpenEnvDataContainer::CreateFromRawBuffer一致
+    RAW_DTYPES = {
+        (pb.INT, 4): np.int32,
+        (pb.UINT, 4): np.uint32,
+        (pb.FLOAT, 4): np.float32,
+        (pb.DOUBLE, 8): np.float64,
+    }
+
+    def __init__(self, simScriptName=None, port=0, startSim=True, simSeed=0, simArgs={}, debug=False,
+                 maxStaleness=0, endpoint=None):
         super(Ns3ZmqBridge, self).__init__()
         port = int(port)
         self.simScriptName = simScriptName
@@ -27,30 +38,25 @@ class Ns3ZmqBridge(object):
         self.startSim = startSim
         self.simSeed = simSeed
         self.simArgs = simArgs
+        # 大于0时为异步模式：仿真发送状态后不等待动作，动作最多落后maxStaleness个状态
+        self.maxStaleness = int(maxStaleness)
+        if self.maxStaleness > 0:
+            self.simArgs = dict(simArgs)
+            self.simArgs['--OpenEnvInterface::MaxStaleness'] = self.maxStaleness
+        # 为空时使用环境变量NS3_OPENENV_ENDPOINT，仍为空时使用tcp端口
+        self.endpoint = endpoint or os.environ.get('NS3_OPENENV_ENDPOINT') or None
         self.envStopped = False
         self.simPid = None
         self.wafPid = None
         self.ns3Process = None
+        # 握手时仿真端声明支持RawBoxContainer后，Box观测和动作都以原始数组传输
+        self.rawBox = False
+        # 握手时仿真端声明可以原地reset后，游戏结束时不再关闭仿真，等待reset或close
+        self.resetSupported = False
+        # 仿真端上一次原地reset的耗时（秒）
+        self.resetTime = 0
 
-        context = zmq.Context()
-        self.socket = context.socket(zmq.REP)
-        try:
-            if port == 0 and self.startSim:
-                port = self.socket.bind_to_random_port('tcp://*', min_port=5001, max_port=10000, max_tries=100)
-                print("Got new port for ns3gm interface: ", port)
-
-            elif port == 0 and not self.startSim:
-                print("Cannot use port %s to bind" % str(port))
-                print("Please specify correct port")
-                sys.exit()
-
-            else:
-                self.socket.bind("tcp://*:%s" % str(port))
-
-        except Exception as e:
-            print("Cannot bind to tcp://*:%s as port is already in use" % str(port))
-            print("Please specify different port or use 0 to get free port")
-            sys.exit()
+        port = self._bind(port)
 
         if (startSim == True and simSeed == 0):
             maxSeed = np.iinfo(np.uint32).max
@@ -59,9 +65,9 @@ class Ns3ZmqBridge(object):
 
         if self.startSim:
             # run simulation script
-            self.ns3Process = start_sim_script(simScriptName, port, simSeed, simArgs, debug)
+            self.ns3Process = start_sim_script(simScriptName, port, simSeed, self.simArgs, debug)
         else:
-            print("Waiting for simulation script to connect on port: tcp://localhost:{}".format(port))
+            print("Waiting for simulation script to connect on: {}".format(self.endpoint or "tcp://localhost:%d" % port))
             print('Please start proper ns-3 simulation script using ./waf --run "..."')
 
         self._action_space = None
@@ -71,9 +77,75 @@ class Ns3ZmqBridge(object):
         self.obsData = None
         self.reward = 0
         self.gameOver = False
+        self.envGameOver = None
         self.gameOverReason = None
         self.extraInfo = None
         self.newStateRx = False
+        self.stepId = 0
+        # 动作宏期间在仿真端收集的各step的观测和奖励，不包括最近一次的状态
+        self.macroObs = []
+        self.macroReward = []
+
+    def _bind(self, port):
+        context = zmq.Context()
+        # 异步模式下双方都可能连续发送多条消息，不能使用REQ/REP
+        self.socket = context.socket(zmq.DEALER if self.maxStaleness > 0 else zmq.REP)
+        if self.endpoint:
+            # ipc://路径、ipc://@名字（Linux抽象命名空间）或tcp://地址，仿真端connect同一个endpoint，
+            # 不需要分配端口；inproc://只能用于同一进程内的智能体，这里无法使用
+            if self.endpoint.startswith('inproc://'):
+                raise ValueError("inproc endpoint is only reachable from inside the simulation process")
+            try:
+                self.socket.bind(self.endpoint)
+            except zmq.ZMQError as e:
+                print("Cannot bind to %s: %s" % (self.endpoint, e))
+                sys.exit()
+            self.simArgs = dict(self.simArgs)
+            self.simArgs['--OpenEnvInterface::Endpoint'] = self.endpoint
+            return port
+        try:
+            if port == 0 and self.startSim:
+                port = self.socket.bind_to_random_port('tcp://*', min_port=5001, max_port=10000, max_tries=100)
+                print("Got new port for ns3gm interface: ", port)
+
+            elif port == 0 and not self.startSim:
+                print("Cannot use port %s to bind" % str(port))
+                print("Please specify correct port")
+                sys.exit()
+
+            else:
+                self.socket.bind("tcp://*:%s" % str(port))
+
+        except Exception as e:
+            print("Cannot bind to tcp://*:%s as port is already in use" % str(port))
+            print("Please specify different port or use 0 to get free port")
+            sys.exit()
+        return port
+
+    def _send_msg(self, msg, raw=None):
+        if raw is not None:
+            array, dtype = raw
+            msg.actRaw.dtype = dtype
+            msg.actRaw.shape.extend(array.shape)
+            msg.actRaw.data = array.tobytes()
+        self.socket.send(msg.SerializeToString())
+
+    def _recv_msg(self, msg):
+        """接收并解析一条消息，返回随消息附加的原始数组，ZMQ传输时总是None"""
+        msg.ParseFromString(self.socket.recv())
+        return None
+
+    def _recv_latest_state(self, msg):
+        """异步模式下接收状态，跳过已经过时的状态只保留最新的一个，游戏结束的状态不会被跳过"""
+        data = self.socket.recv()
+        while True:
+            msg.ParseFromString(data)
+            if msg.isGameOver:
+                return None
+            try:
+                data = self.socket.recv(zmq.NOBLOCK)
+            except zmq.Again:
+                return None
 
     def close(self):
         try:
@@ -144,9 +216,8 @@ class Ns3ZmqBridge(object):
         return space
 
     def initialize_env(self, stepInterval):
-        request = self.socket.recv()
         simInitMsg = pb.SimInitMsg()
-        simInitMsg.ParseFromString(request)
+        self._recv_msg(simInitMsg)
 
         self.simPid = int(simInitMsg.simProcessId)
         self.wafPid = int(simInitMsg.wafShellProcessId)
@@ -156,8 +227,11 @@ class Ns3ZmqBridge(object):
         reply = pb.SimInitAck()
         reply.done = True
         reply.stopSimReq = False
-        replyMsg = reply.SerializeToString()
-        self.socket.send(replyMsg)
+        # 旧版本的仿真端没有这个字段，读到False，继续使用repeated字段
+        self.rawBox = simInitMsg.rawBoxSupported
+        reply.rawBoxEnabled = self.rawBox
+        self.resetSupported = simInitMsg.resetSupported
+        self._send_msg(reply)
         return True
 
     def get_action_space(self):
@@ -173,17 +247,39 @@ class Ns3ZmqBridge(object):
         if self.newStateRx:
             return
 
-        request = self.socket.recv()
         envStateMsg = pb.EnvStateMsg()
-        envStateMsg.ParseFromString(request)
-
-        self.obsData = self._create_data(envStateMsg.obsData)
+        if self.maxStaleness > 0:
+            rawObs = self._recv_latest_state(envStateMsg)
+        else:
+            rawObs = self._recv_msg(envStateMsg)
+        self.stepId = envStateMsg.stepId
+
+        if rawObs is not None:
+            self.obsData = rawObs
+        elif envStateMsg.HasField('obsRaw'):
+            self.obsData = self._create_raw_data(envStateMsg.obsRaw.dtype, self._element_size(envStateMsg.obsRaw.dtype),
+                                                 envStateMsg.obsRaw.data, envStateMsg.obsRaw.shape)
+        else:
+            self.obsData = self._create_data(envStateMsg.obsData)
+        self.macroObs = [self._create_raw_data(box.dtype, self._element_size(box.dtype), box.data, box.shape)
+                         for box in envStateMsg.stepObsRaw]
+        self.macroObs.extend(self._create_data(data) for data in envStateMsg.stepObsData)
+        self.macroReward = list(envStateMsg.stepReward)
         self.reward = envStateMsg.reward
+        if len(envStateMsg.envReward) > 0:
+            # 向量化环境：逐个子环境的奖励和结束标志，isGameOver在所有子环境都结束时为True
+            self.reward = np.array(envStateMsg.envReward, dtype=np.float32)
+            self.envGameOver = np.array(envStateMsg.envGameOver, dtype=bool)
         self.gameOver = envStateMsg.isGameOver
         self.gameOverReason = envStateMsg.reason
+        if envStateMsg.resetTime > 0:
+            self.resetTime = envStateMsg.resetTime
 
         if self.gameOver:
-            if self.gameOverReason == pb.EnvStateMsg.SimulationEnd:
+            if self.resetSupported:
+                # 仿真端等待reset或close的回复
+                pass
+            elif self.gameOverReason == pb.EnvStateMsg.SimulationEnd:
                 self.envStopped = True
                 self.send_close_command()
             else:
@@ -200,29 +296,56 @@ class Ns3ZmqBridge(object):
         reply = pb.EnvActMsg()
         reply.stopSimReq = True
 
-        replyMsg = reply.SerializeToString()
-        self.socket.send(replyMsg)
+        self._send_msg(reply)
         self.newStateRx = False
         return True
 
-    def send_actions(self, actions):
+    def can_reset(self):
+        """仿真端支持原地reset，且正在等待对当前状态的回复"""
+        return self.resetSupported and not self.envStopped and self.newStateRx
+
+    def send_reset_command(self, seed=None):
+        """请求仿真端原地reset，之后用rx_env_state接收新episode的第一个状态
+
+        :param seed: 新episode的RngRun，None时与启动仿真时一样使用simSeed，simSeed为0时随机选取
+        """
+        if seed is None:
+            seed = self.simSeed
+        if not seed:
+            seed = np.random.randint(1, np.iinfo(np.uint32).max)
         reply = pb.EnvActMsg()
+        reply.resetReq = True
+        reply.resetSeed = int(seed)
 
-        actionMsg = self._pack_data(actions, self._action_space)
-        reply.actData.CopyFrom(actionMsg)
+        self._send_msg(reply)
+        self.newStateRx = False
+        self.gameOver = False
+        self.envGameOver = None
+        return True
+
+    def send_actions(self, actions, repeat=1):
+        reply = pb.EnvActMsg()
+        # 大于1时仿真端在本地把动作保持repeat个step，之后一次性返回这些step的状态
+        reply.repeat = int(repeat)
+
+        raw = self._pack_raw(actions, self._action_space)
+        if raw is None:
+            actionMsg = self._pack_data(actions, self._action_space)
+            reply.actData.CopyFrom(actionMsg)
 
         reply.stopSimReq = False
         if self.forceEnvStop:
             reply.stopSimReq = True
+        # 仿真端据此计算动作的staleness
+        reply.stepId = self.stepId
 
-        replyMsg = reply.SerializeToString()
-        self.socket.send(replyMsg)
+        self._send_msg(reply, raw)
         self.newStateRx = False
         return True
 
-    def step(self, actions):
+    def step(self, actions, repeat=1):
         # exec actions for current state
-        self.send_actions(actions)
+        self.send_actions(actions, repeat)
         # get result of above actions
         self.rx_env_state()
 
@@ -286,6 +409,43 @@ class Ns3ZmqBridge(object):
     def get_extra_info(self):
         return self.extraInfo
 
+    def get_env_game_over(self):
+        """向量化环境中各子环境是否结束，非向量化环境返回None"""
+        return self.envGameOver
+
+    def get_macro_states(self):
+        """
+        :returns: (观测列表, 奖励列表)，包括动作宏期间各step和最近一次的状态，按step顺序
+        """
+        return self.macroObs + [self.obsData], self.macroReward + [self.reward]
+
+    @staticmethod
+    def _element_size(dtype):
+        return 8 if dtype == pb.DOUBLE else 4
+
+    def _create_raw_data(self, dtype, elementSize, data, shape=()):
+        """把原始数组映射为numpy数组，不拷贝，数组只读"""
+        npDtype = self.RAW_DTYPES.get((dtype, elementSize))
+        if npDtype is None:
+            raise RuntimeError('unsupported raw box, dtype %d, element size %d' % (dtype, elementSize))
+        array = np.frombuffer(data, dtype=npDtype)
+        if len(shape) > 1 and np.prod(shape) == array.size:
+            array = array.reshape(tuple(shape))
+        return array
+
+    def _pack_raw(self, actions, spaceDesc):
+        """能以原始数组发送时返回(数组, dtype)，否则返回None走protobuf"""
+        if not self.rawBox or spaceDesc.__class__ != spaces.Box:
+            return None
+        # 与_pack_data的dtype映射一致，浮点动作按float发送
+        if spaceDesc.dtype in ['int', 'int8', 'int16', 'int32', 'int64']:
+            return np.ascontiguousarray(actions, dtype=np.int32).ravel(), pb.INT
+        elif spaceDesc.dtype in ['uint', 'uint8', 'uint16', 'uint32', 'uint64']:
+            return np.ascontiguousarray(actions, dtype=np.uint32).ravel(), pb.UINT
+        elif spaceDesc.dtype in ['double']:
+            return np.ascontiguousarray(actions, dtype=np.float64).ravel(), pb.DOUBLE
+        return np.ascontiguousarray(actions, dtype=np.float32).ravel(), pb.FLOAT
+
     def _pack_data(self, actions, spaceDesc):
         dataContainer = pb.DataContainer()
 
@@ -355,8 +515,206 @@ class Ns3ZmqBridge(object):
         return dataContainer
 
 
+class Ns3ShmBridge(Ns3ZmqBridge):
+    """通过共享内存环与仿真交互，对应OpenEnvInterface::Transport=shm
+
+    Box观测以原始数组传输，get_obs返回直接映射共享内存的numpy数组，
+    在下一次step之前有效，需要保留时请自行copy。
+    """
+
+    def __init__(self, simScriptName=None, port=0, startSim=True, simSeed=0, simArgs={}, debug=False,
+                 shmCapacity=None, maxStaleness=0, endpoint=None):
+        self.shmCapacity = shmCapacity
+        self.channel = None
+        if maxStaleness > 0:
+            raise ValueError("shared memory transport does not support maxStaleness")
+        simArgs = dict(simArgs)
+        simArgs['--OpenEnvInterface::Transport'] = 'shm'
+        super(Ns3ShmBridge, self).__init__(simScriptName, port, startSim, simSeed, simArgs, debug)
+
+    def _bind(self, port):
+        # multiprocessing.shared_memory需要Python 3.8，只在使用共享内存时导入
+        from pyns3.shm_channel import ShmChannel
+        # 共享内存传输不使用ZMQ的endpoint
+        self.endpoint = None
+
+        if port == 0 and not self.startSim:
+            print("Cannot use port %s for shared memory name" % str(port))
+            print("Please specify correct port")
+            sys.exit()
+        if port == 0:
+            # 端口只用于区分共享内存的名字
+            port = np.random.randint(5001, 10000)
+        name = "/ns3openenv-%d" % port
+        if self.startSim:
+            # 自动启动的仿真再加上pid，避免多个实验使用同一个名字
+            name = "/ns3openenv-%d-%d" % (os.getpid(), port)
+            self.simArgs['--OpenEnvInterface::ShmName'] = name
+        if self.shmCapacity:
+            self.channel = ShmChannel(name, self.shmCapacity)
+        else:
+            self.channel = ShmChannel(name)
+        print("Created shared memory for ns3gm interface: ", name)
+        return port
+
+    def _alive(self):
+        return self.ns3Process is None or self.ns3Process.poll() is None
+
+    def _send_msg(self, msg, raw=None):
+        # 发送之前归还上一帧，仿真端要在收到这条消息之后才会写入下一帧
+        self.channel.release()
+        if raw is None:
+            self.channel.send(msg.SerializeToString())
+        else:
+            array, dtype = raw
+            self.channel.send(msg.SerializeToString(), array, dtype, array.itemsize)
+
+    def _recv_msg(self, msg):
+        data, raw, dtype, elementSize = self.channel.receive(self._alive)
+        msg.ParseFromString(bytes(data))
+        if raw is None:
+            return None
+        # 帧中没有形状，按观测空间还原（如向量化环境的[K × obs]）
+        shape = self._observation_space.shape if self._observation_space is not None else ()
+        return self._create_raw_data(dtype, elementSize, raw, shape)
+
+    def close(self):
+        super(Ns3ShmBridge, self).close()
+        if self.channel:
+            # 映射共享内存的观测必须先释放
+            self.obsData = None
+            self.channel.close()
+            self.channel = None
+
+
+class Ns3SnapshotServer(object):
+    """快照服务器，对应OpenEnvInterface::SnapshotServer=true
+
+    仿真只启动一次，热身结束后停在第一个step之前。每次fork_bridge让仿真fork出一个
+    copy-on-write的子进程，子进程从相同的热身状态开始一个episode，使用自己的端口（或共享内存）
+    和随机种子。把它传给Ns3Env的snapshotServer参数后，每次reset都从快照fork新的子进程。
+    子进程的Transport和MaxStaleness与服务器相同。控制连接使用ipc://的endpoint时，
+    子进程使用在它后面加上序号的endpoint，否则使用新分配的TCP端口。
+    """
+
+    def __init__(self, simScriptName=None, port=0, startSim=True, simSeed=0, simArgs={}, debug=False,
+                 transport='zmq', maxStaleness=0, shmCapacity=None, endpoint=None):
+        self.transport = transport
+        self.endpoint = endpoint or os.environ.get('NS3_OPENENV_ENDPOINT') or None
+        self.forkCount = 0
+        self.maxStaleness = int(maxStaleness)
+        self.shmCapacity = shmCapacity
+        self.debug = debug
+        self.ns3Process = None
+        simArgs = dict(simArgs)
+        simArgs['--OpenEnvInterface::SnapshotServer'] = 'true'
+        if transport == 'shm':
+            if self.maxStaleness > 0:
+                raise ValueError("shared memory transport does not support maxStaleness")
+            simArgs['--OpenEnvInterface::Transport'] = 'shm'
+        elif transport != 'zmq':
+            raise ValueError("Unknown transport: %s" % transport)
+        if self.maxStaleness > 0:
+            simArgs['--OpenEnvInterface::MaxStaleness'] = self.maxStaleness
+
+        # 控制连接，与仿真端的REQ配对
+        context = zmq.Context()
+        self.socket = context.socket(zmq.REP)
+        if self.endpoint:
+            if self.endpoint.startswith('inproc://'):
+                raise ValueError("inproc endpoint is only reachable from inside the simulation process")
+            self.socket.bind(self.endpoint)
+            simArgs['--OpenEnvInterface::Endpoint'] = self.endpoint
+        elif port == 0 and startSim:
+            port = self.socket.bind_to_random_port('tcp://*', min_port=5001, max_port=10000, max_tries=100)
+        elif port == 0:
+            raise ValueError("port must be specified when the simulation is started manually")
+        else:
+            self.socket.bind("tcp://*:%s" % str(port))
+        self.port = port
+
+        if startSim:
+            if simSeed == 0:
+                simSeed = np.random.randint(0, np.iinfo(np.uint32).max)
+            self.ns3Process = start_sim_script(simScriptName, port, simSeed, simArgs, debug)
+        else:
+            print("Waiting for snapshot server to connect on: {}".format(self.endpoint or "tcp://localhost:%d" % port))
+
+        # 仿真热身结束后发来第一条消息
+        self.snapshotMsg = pb.SnapshotMsg()
+        self.snapshotMsg.ParseFromString(self.socket.recv())
+        self.simPid = int(self.snapshotMsg.simProcessId)
+        self.wafPid = int(self.snapshotMsg.wafShellProcessId)
+        self.snapshotTime = self.snapshotMsg.simTime
+        self.stopped = False
+
+    @staticmethod
+    def _free_port():
+        sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        sock.bind(('', 0))
+        port = sock.getsockname()[1]
+        sock.close()
+        return port
+
+    def fork_bridge(self, seed=None):
+        """fork一个从快照开始的子进程，返回与它连接的bridge，之后按Ns3Env的流程调用initialize_env
+
+        :param seed: 子进程的RngRun，None时随机选取
+        """
+        if self.stopped:
+            raise RuntimeError("snapshot server is stopped")
+        port = self._free_port()
+        self.forkCount += 1
+        endpoint = None
+        if self.endpoint and self.endpoint.startswith('ipc://'):
+            endpoint = '%s-%d' % (self.endpoint, self.forkCount)
+        if self.transport == 'shm':
+            bridge = Ns3ShmBridge(None, port, False, 0, {}, self.debug, shmCapacity=self.shmCapacity)
+        else:
+            # 子进程的endpoint由ForkReq指定，不使用环境变量
+            bridge = Ns3ZmqBridge(None, port, False, 0, {}, self.debug, maxStaleness=self.maxStaleness,
+                                  endpoint=endpoint or 'tcp://*:%d' % port)
+        if not seed:
+            seed = np.random.randint(1, np.iinfo(np.uint32).max)
+
+        req = pb.ForkReq()
+        req.port = port
+        req.seed = int(seed)
+        if endpoint and self.transport != 'shm':
+            req.endpoint = endpoint
+        self.socket.send(req.SerializeToString())
+        self.snapshotMsg.ParseFromString(self.socket.recv())
+        # 子进程结束时由bridge关闭，快照服务器负责回收
+        return bridge
+
+    def close(self):
+        if self.stopped:
+            return
+        self.stopped = True
+        try:
+            req = pb.ForkReq()
+            req.stopServer = True
+            self.socket.send(req.SerializeToString())
+            if self.ns3Process:
+                self.ns3Process.wait(timeout=10)
+        except Exception as e:
+            if self.simPid:
+                os.kill(self.simPid, signal.SIGTERM)
+        self.socket.close()
+
+
 class Ns3Env(gym.Env):
-    def __init__(self, stepTime=0, simScriptName=None, port=0, startSim=True, simSeed=0, simArgs={}, debug=False):
+    def __init__(self, stepTime=0, simScriptName=None, port=0, startSim=True, simSeed=0, simArgs={}, debug=False,
+                 transport='zmq', maxStaleness=0, snapshotServer=None, endpoint=None):
+        """
+        :param transport: 'zmq'为默认的ZMQ传输，'shm'使用共享内存环（仅支持x86-64 Linux）
+        :param maxStaleness: 0为锁步交互；大于0时仿真不等待智能体，动作最多落后maxStaleness个step，
+                             info中的staleness=N为当前生效动作落后的step数（仅支持zmq传输）
+        :param snapshotServer: Ns3SnapshotServer，给出时不启动仿真，每个episode从服务器的热身快照fork子进程，
+                               transport和maxStaleness由服务器决定
+        :param endpoint: zmq传输使用的endpoint，如ipc:///tmp/ns3env或ipc://@ns3env（Linux抽象命名空间），
+                         为None时使用环境变量NS3_OPENENV_ENDPOINT，都没有时使用tcp端口
+        """
         self.stepTime = stepTime
         self.simScriptName = simScriptName
         self.port = port
@@ -364,6 +722,13 @@ class Ns3Env(gym.Env):
         self.simSeed = simSeed
         self.simArgs = simArgs
         self.debug = debug
+        self.transport = transport
+        self.maxStaleness = maxStaleness
+        self.snapshotServer = snapshotServer
+        self.endpoint = endpoint
+
+        # 上一次reset的耗时（秒），原地reset时包括仿真到第一个状态的时间，否则包括重启仿真进程
+        self.resetLatency = None
 
         # Filled in reset function
         self.ns3ZmqBridge = None
@@ -374,7 +739,7 @@ class Ns3Env(gym.Env):
         self.state = None
         self.steps_beyond_done = None
 
-        self.ns3ZmqBridge = Ns3ZmqBridge(self.simScriptName, self.port, self.startSim, self.simSeed, self.simArgs, self.debug)
+        self.ns3ZmqBridge = self._create_bridge()
         self.ns3ZmqBridge.initialize_env(self.stepTime)
         self.action_space = self.ns3ZmqBridge.get_action_space()
         self.observation_space = self.ns3ZmqBridge.get_observation_space()
@@ -383,6 +748,18 @@ class Ns3Env(gym.Env):
         self.envDirty = False
         self.seed()
 
+    def _create_bridge(self):
+        if self.snapshotServer is not None:
+            return self.snapshotServer.fork_bridge()
+        if self.transport == 'shm':
+            bridgeClass = Ns3ShmBridge
+        elif self.transport == 'zmq':
+            bridgeClass = Ns3ZmqBridge
+        else:
+            raise ValueError("Unknown transport: %s" % self.transport)
+        return bridgeClass(self.simScriptName, self.port, self.startSim, self.simSeed, self.simArgs, self.debug,
+                           maxStaleness=self.maxStaleness, endpoint=self.endpoint)
+
     def seed(self, seed=None):
         self.np_random, seed = seeding.np_random(seed)
         return [seed]
@@ -399,25 +776,51 @@ class Ns3Env(gym.Env):
         self.envDirty = True
         return self.get_state()
 
+    def step_repeat(self, action, repeat):
+        """把动作保持repeat个step，仿真端在本地执行并收集各step的状态，只需要一次交互
+
+        :returns: (obs列表, reward列表, done, info)，列表按step顺序，游戏提前结束时长度小于repeat，
+                  info为最后一个step的info
+        """
+        self.ns3ZmqBridge.step(action, repeat)
+        self.envDirty = True
+        obs, reward = self.ns3ZmqBridge.get_macro_states()
+        return (obs, reward, self.ns3ZmqBridge.is_game_over(), self.ns3ZmqBridge.get_extra_info())
+
     def reset(self):
         if not self.envDirty:
             obs = self.ns3ZmqBridge.get_obs()
             return obs
 
-        if self.ns3ZmqBridge:
-            self.ns3ZmqBridge.close()
-            self.ns3ZmqBridge = None
-
+        start = time.time()
+        if self.snapshotServer is None and self.ns3ZmqBridge and self.ns3ZmqBridge.can_reset():
+            # 仿真端原地reset，不重启ns-3进程，也不重新握手
+            self.ns3ZmqBridge.send_reset_command()
+            self.ns3ZmqBridge.rx_env_state()
+        else:
+            # 使用快照服务器时关闭当前子进程，从快照fork新的子进程
+            if self.ns3ZmqBridge:
+                self.ns3ZmqBridge.close()
+                self.ns3ZmqBridge = None
+
+            self.ns3ZmqBridge = self._create_bridge()
+            self.ns3ZmqBridge.initialize_env(self.stepTime)
+            self.action_space = self.ns3ZmqBridge.get_action_space()
+            self.observation_space = self.ns3ZmqBridge.get_observation_space()
+            # get first observations
+            self.ns3ZmqBridge.rx_env_state()
         self.envDirty = False
-        self.ns3ZmqBridge = Ns3ZmqBridge(self.port, self.startSim, self.simSeed, self.simArgs, self.debug)
-        self.ns3ZmqBridge.initialize_env(self.stepTime)
-        self.action_space = self.ns3ZmqBridge.get_action_space()
-        self.observation_space = self.ns3ZmqBridge.get_observation_space()
-        # get first observations
-        self.ns3ZmqBridge.rx_env_state()
+        self.resetLatency = time.time() - start
         obs = self.ns3ZmqBridge.get_obs()
         return obs
 
+    def get_reset_latency(self):
+        """
+        :returns: (上一次reset的总耗时, 仿真端原地reset的耗时)，单位为秒，还没有reset过时总耗时为None
+        """
+        simResetTime = self.ns3ZmqBridge.resetTime if self.ns3ZmqBridge else 0
+        return self.resetLatency, simResetTime
+
     def render(self, mode='human'):
         return
 
@@ -0,0 +1,182 @@
+"""
+@desc: OpenEnv共享内存传输的Python端，布局与env-interface/model/openenv_shm.cc保持一致
+
+共享内存由本端创建，ns-3仿真端打开。环0为仿真 -> Python（状态），本端读；
+环1为Python -> 仿真（动作），本端写。每个环是单生产者单消费者的字节环，
+帧头之后是protobuf消息，8字节对齐后是原始数组，帧不会跨越环尾。
+"""
+import ctypes
+import os
+import platform
+import struct
+from multiprocessing import shared_memory
+
+SHM_MAGIC = 0x4853454f  # "OESH"
+SHM_VERSION = 1
+SHM_HEADER_BYTES = 64
+SHM_RING_CONTROL_BYTES = 128
+SHM_DATA_OFFSET = SHM_HEADER_BYTES + 2 * SHM_RING_CONTROL_BYTES
+RING_TAIL_OFFSET = 64
+FRAME_HEADER = struct.Struct('<IIIHH')
+FRAME_WRAP = 0xffffffff
+DEFAULT_RING_CAPACITY = 4 << 20
+
+# 读空时futex等待之前的自旋次数，以及每次futex等待的超时（秒），超时后检查仿真进程是否还在
+SPIN_ITERATIONS = 2048
+FUTEX_TIMEOUT = 0.1
+
+_SYS_FUTEX = 202
+_FUTEX_WAIT = 0
+_FUTEX_WAKE = 1
+
+
+class _Timespec(ctypes.Structure):
+    _fields_ = [('tv_sec', ctypes.c_long), ('tv_nsec', ctypes.c_long)]
+
+
+def _align8(value):
+    return (value + 7) & ~7
+
+
+class _Ring(object):
+    """一个环的控制字段和数据区"""
+
+    def __init__(self, buf, index, capacity):
+        control = SHM_HEADER_BYTES + index * SHM_RING_CONTROL_BYTES
+        self.head = ctypes.c_uint64.from_buffer(buf, control)
+        self.seq = ctypes.c_uint32.from_buffer(buf, control + 8)
+        self.waiting = ctypes.c_uint32.from_buffer(buf, control + 12)
+        self.tail = ctypes.c_uint64.from_buffer(buf, control + RING_TAIL_OFFSET)
+        self.offset = SHM_DATA_OFFSET + index * capacity
+        self.data = buf[self.offset:self.offset + capacity]
+
+
+class ShmChannel(object):
+    """与OpenEnvShmChannel配对的共享内存通道
+
+    只支持x86-64：对齐的8字节读写是原子的，且TSO保证另一进程看到head时帧内容已经写完，
+    因此这里不需要额外的内存屏障。
+    """
+
+    def __init__(self, name, capacity=DEFAULT_RING_CAPACITY):
+        if platform.machine() not in ('x86_64', 'AMD64'):
+            raise RuntimeError('shared memory transport only supports x86-64, got %s' % platform.machine())
+        if capacity % 8 != 0:
+            raise ValueError('ring capacity must be a multiple of 8')
+        self.name = name
+        self.capacity = capacity
+        self._libc = ctypes.CDLL(None, use_errno=True)
+        self._libc.syscall.restype = ctypes.c_long
+        self._timeout = _Timespec(int(FUTEX_TIMEOUT), int((FUTEX_TIMEOUT % 1) * 1e9))
+
+        # multiprocessing.shared_memory的名字不带前导'/'
+        shmName = name.lstrip('/')
+        try:
+            old = shared_memory.SharedMemory(name=shmName)
+            old.close()
+            old.unlink()
+        except FileNotFoundError:
+            pass
+        self._shm = shared_memory.SharedMemory(name=shmName, create=True,
+                                               size=SHM_DATA_OFFSET + 2 * capacity)
+        buf = self._shm.buf
+        buf[:SHM_DATA_OFFSET] = bytes(SHM_DATA_OFFSET)
+        struct.pack_into('<II', buf, 4, SHM_VERSION, capacity)
+        self._rx = _Ring(buf, 0, capacity)
+        self._tx = _Ring(buf, 1, capacity)
+        self._pendingTail = 0
+        # 最后写magic，仿真端读到magic时其他字段都已初始化
+        self._magic = ctypes.c_uint32.from_buffer(buf, 0)
+        self._magic.value = SHM_MAGIC
+
+    def _futex(self, word, op, value, timeout=None):
+        return self._libc.syscall(_SYS_FUTEX, ctypes.byref(word), op, value,
+                                  ctypes.byref(timeout) if timeout is not None else None, None, 0)
+
+    def send(self, msg, raw=None, rawDtype=0, rawElementSize=0):
+        """发送一帧，msg为protobuf序列化后的bytes，raw为可选的原始数组（支持buffer协议的对象）"""
+        ring = self._tx
+        rawView = memoryview(raw).cast('B') if raw is not None else b''
+        rawOffset = FRAME_HEADER.size + _align8(len(msg))
+        frameBytes = _align8(rawOffset + len(rawView))
+        if frameBytes > self.capacity // 2:
+            raise ValueError('message of %d bytes does not fit the ring' % frameBytes)
+
+        head = ring.head.value
+        pos = head % self.capacity
+        contiguous = self.capacity - pos
+        needed = contiguous + frameBytes if contiguous < frameBytes else frameBytes
+        while self.capacity - (head - ring.tail.value) < needed:
+            os.sched_yield()
+        if contiguous < frameBytes:
+            struct.pack_into('<I', ring.data, pos, FRAME_WRAP)
+            head += contiguous
+            pos = 0
+
+        FRAME_HEADER.pack_into(ring.data, pos, frameBytes, len(msg), len(rawView), rawDtype, rawElementSize)
+        ring.data[pos + FRAME_HEADER.size:pos + FRAME_HEADER.size + len(msg)] = msg
+        if len(rawView) > 0:
+            ring.data[pos + rawOffset:pos + rawOffset + len(rawView)] = rawView
+
+        ring.head.value = head + frameBytes
+        ring.seq.value = (ring.seq.value + 1) & 0xffffffff
+        # Python端无法可靠地在写seq与读waiting之间加屏障，总是唤醒，没有等待者时只是一次空的系统调用
+        self._futex(ring.seq, _FUTEX_WAKE, 0x7fffffff)
+
+    def receive(self, alive=None):
+        """等待状态环中的下一帧
+
+        :param alive: 可选的回调，futex等待超时时调用，返回False时放弃等待并抛出异常
+        :returns: (msg, raw, rawDtype, rawElementSize)，msg和raw是环内的memoryview，
+                  在调用release之前有效
+        """
+        ring = self._rx
+        tail = ring.tail.value
+        while True:
+            spin = 0
+            while ring.head.value == tail:
+                spin += 1
+                if spin < SPIN_ITERATIONS:
+                    continue
+                seq = ring.seq.value
+                ring.waiting.value = 1
+                if ring.head.value == tail:
+                    self._futex(ring.seq, _FUTEX_WAIT, seq, self._timeout)
+                ring.waiting.value = 0
+                if alive is not None and ring.head.value == tail and not alive():
+                    raise RuntimeError('simulation process exited')
+
+            pos = tail % self.capacity
+            # 环尾剩余不足一个帧头时只有4字节的回绕标记
+            frameBytes, = struct.unpack_from('<I', ring.data, pos)
+            if frameBytes == FRAME_WRAP:
+                tail += self.capacity - pos
+                continue
+            if frameBytes < FRAME_HEADER.size or frameBytes > self.capacity - pos:
+                raise RuntimeError('corrupted frame of %d bytes' % frameBytes)
+            _, msgBytes, rawBytes, rawDtype, rawElementSize = FRAME_HEADER.unpack_from(ring.data, pos)
+
+            msgStart = pos + FRAME_HEADER.size
+            msg = ring.data[msgStart:msgStart + msgBytes]
+            raw = None
+            if rawBytes > 0:
+                rawStart = msgStart + _align8(msgBytes)
+                raw = ring.data[rawStart:rawStart + rawBytes]
+            self._pendingTail = tail + frameBytes
+            return msg, raw, rawDtype, rawElementSize
+
+    def release(self):
+        """释放receive得到的帧，之后其中的内存可能被仿真端覆盖"""
+        self._rx.tail.value = self._pendingTail
+
+    def close(self):
+        if self._shm is None:
+            return
+        # 释放所有指向共享内存的导出对象，否则SharedMemory.close会失败
+        self._rx = self._tx = self._magic = None
+        self._shm.close()
+        try:
+            self._shm.unlink()
+        except FileNotFoundError:
+            pass
+        self._shm = None
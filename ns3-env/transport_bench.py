@@ -0,0 +1,110 @@
+#!/usr/bin/env python
+# -*- coding: UTF-8 -*-
+"""
+@FilePath: /ns3-env/transport_bench.py
+@desc: 比较OpenEnv各ZMQ endpoint的往返延迟
+
+仿真端用REQ发送与状态消息等长的数据，智能体端用REP回复与动作消息等长的数据，与OpenEnvInterface的锁步交互相同。
+tcp、ipc和抽象命名空间的ipc在两个进程之间测量，inproc只能在同一个context内使用，在同一进程的两个线程之间测量，
+作为ZMQ本身开销的下限。
+"""
+
+import argparse
+import multiprocessing
+import os
+import threading
+import time
+
+import numpy as np
+import zmq
+
+
+parser = argparse.ArgumentParser(description='测量各endpoint的往返延迟')
+parser.add_argument('--steps', default=10000, type=int, help='每个endpoint测量的往返次数，默认值为10000')
+parser.add_argument('--warmup', default=1000, type=int, help='测量之前的往返次数，默认值为1000')
+parser.add_argument('--obs-bytes', default=4096, type=int, help='状态消息的字节数，默认值为4096')
+parser.add_argument('--act-bytes', default=1024, type=int, help='动作消息的字节数，默认值为1024')
+parser.add_argument('--port', default=5599, type=int, help='tcp使用的端口，默认值为5599')
+parser.add_argument('--transports', default='tcp,ipc,abstract,inproc', type=str,
+                    help='要测量的endpoint类型，以逗号分隔，默认值为tcp,ipc,abstract,inproc')
+args = parser.parse_args()
+
+
+def endpoints(transport):
+    """返回(智能体bind的endpoint, 仿真connect的endpoint)"""
+    if transport == 'tcp':
+        return 'tcp://*:%d' % args.port, 'tcp://localhost:%d' % args.port
+    if transport == 'ipc':
+        endpoint = 'ipc:///tmp/ns3openenv-bench-%d' % os.getpid()
+    elif transport == 'abstract':
+        # Linux抽象命名空间，不在文件系统中创建文件
+        endpoint = 'ipc://@ns3openenv-bench-%d' % os.getpid()
+    elif transport == 'inproc':
+        endpoint = 'inproc://ns3openenv-bench'
+    else:
+        raise ValueError('Unknown transport: %s' % transport)
+    return endpoint, endpoint
+
+
+def run_sim(context, endpoint, rounds, result=None):
+    """仿真端：发送状态，等待动作，记录每次往返的耗时（纳秒）"""
+    socket = context.socket(zmq.REQ)
+    socket.connect(endpoint)
+    state = os.urandom(args.obs_bytes)
+    rtt = np.empty(rounds, dtype=np.int64)
+    for step in range(args.warmup + rounds):
+        start = time.perf_counter_ns()
+        socket.send(state)
+        socket.recv(copy=False)
+        if step >= args.warmup:
+            rtt[step - args.warmup] = time.perf_counter_ns() - start
+    socket.close()
+    if result is not None:
+        result.send(rtt)
+    return rtt
+
+
+def run_sim_process(endpoint, rounds, result):
+    run_sim(zmq.Context(), endpoint, rounds, result)
+
+
+def run_agent(socket, rounds):
+    """智能体端：收到状态后立即回复动作"""
+    action = os.urandom(args.act_bytes)
+    for _ in range(args.warmup + rounds):
+        socket.recv(copy=False)
+        socket.send(action)
+
+
+def bench(transport):
+    bindAddr, connectAddr = endpoints(transport)
+    context = zmq.Context()
+    socket = context.socket(zmq.REP)
+    socket.bind(bindAddr)
+    if transport == 'inproc':
+        # inproc的endpoint只在同一个context内可见
+        agent = threading.Thread(target=run_agent, args=(socket, args.steps))
+        agent.start()
+        rtt = run_sim(context, connectAddr, args.steps)
+        agent.join()
+    else:
+        receiver, sender = multiprocessing.Pipe(duplex=False)
+        sim = multiprocessing.Process(target=run_sim_process, args=(connectAddr, args.steps, sender))
+        sim.start()
+        run_agent(socket, args.steps)
+        rtt = receiver.recv()
+        sim.join()
+    socket.close()
+    context.term()
+    if bindAddr.startswith('ipc:///'):
+        os.unlink(bindAddr[len('ipc://'):])
+    return rtt / 1000.0
+
+
+if __name__ == '__main__':
+    print('%d round trips, state %d bytes, action %d bytes' % (args.steps, args.obs_bytes, args.act_bytes))
+    print('%-10s %10s %10s %10s %10s' % ('transport', 'mean(us)', 'p50(us)', 'p99(us)', 'steps/s'))
+    for transport in args.transports.split(','):
+        rtt = bench(transport.strip())
+        print('%-10s %10.1f %10.1f %10.1f %10.0f' % (transport, rtt.mean(), np.percentile(rtt, 50),
+                                                     np.percentile(rtt, 99), 1e6 / rtt.mean()))